@@ -0,0 +1,9 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <physics_2d/physics_2d.h>
+#include <physics_2d/physics_broadphase.h>
+#include <physics_2d/physics_simd.h>
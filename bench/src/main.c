@@ -0,0 +1,471 @@
+#include "bench.h"
+
+/*
+ * Headless benchmark of the collision pipeline
+ *
+ * Scenes are generated from a seed, so two runs with the same options test
+ * the same colliders and pairs. Every result is printed as one JSON object
+ * per line:
+ *  {"bench": ..., "scene": ..., "n": colliders, "case": ..., "unit": ...,
+ *   "ops": units timed, "ns_per_op": ..., "ops_per_sec": ...}
+ *
+ * Usage: bench [-s seed] [-n max colliders] [-t min ms per case]
+ *              [-k auto|scalar|sse2|avx2|neon]
+ */
+
+#define MAX_VERTICES 128
+#define DEFAULT_COUNT 1024
+
+typedef struct Options {
+    uint32_t seed;
+    int32_t max_count;
+    double min_time;
+    EcsProjectionKernel kernel;
+} Options;
+
+/*
+ * Colliders of a scene, index i of every array is the same collider
+ *  vertices: Vertex count of the polygons, 0 for circles only and -1 for
+ *            half circles and half polygons of 3 to 8 vertices
+ *  pairs: Candidate pairs of the sweep and prune
+ */
+typedef struct Scene {
+    const char *name;
+    int32_t vertices;
+    int32_t count;
+    EcsVector2D *positions;
+    EcsRotation *rotations;
+    EcsCircleCollider *circles;
+    EcsPolygonCollider *polygons;
+    EcsPoint *points;
+    EcsColliderData *data;
+    EcsColliderData **colliders;
+    EcsColliderPair *pairs;
+    int32_t pair_count;
+} Scene;
+
+typedef struct SceneDesc {
+    const char *name;
+    int32_t vertices;
+} SceneDesc;
+
+static const SceneDesc scenes[] = {
+    {"circles", 0},
+    {"boxes", 4},
+    {"mixed", -1},
+    {"polygons_3", 3},
+    {"polygons_8", 8},
+    {"polygons_16", 16},
+    {"polygons_32", 32},
+    {"polygons_64", 64},
+    {"polygons_128", MAX_VERTICES},
+};
+#define SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+#define SCALING_SCENES 3
+
+static const char *kernel_names[] = {"auto", "scalar", "sse2", "avx2", "neon"};
+static const char *pair_names[] = {"circle_circle", "circle_polygon", "polygon_polygon"};
+
+/* Keeps the results of the timed calls alive */
+static volatile int64_t sink;
+
+static uint32_t Bench_random(uint32_t *state)
+{
+    // xorshift32, the same sequence on every platform
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static float Bench_uniform(uint32_t *state, float min, float max)
+{
+    return min + (max - min) * (float)(Bench_random(state) >> 8) / (float)(1 << 24);
+}
+
+static double Bench_now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static void Bench_report(
+    const char *bench,
+    const char *scene,
+    int32_t count,
+    const char *name,
+    const char *unit,
+    int64_t ops,
+    double seconds)
+{
+    printf("{\"bench\": \"%s\", \"scene\": \"%s\", \"n\": %d, \"case\": \"%s\", \"unit\": \"%s\", "
+           "\"ops\": %lld, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f}\n",
+        bench, scene, count, name, unit, (long long)ops,
+        ops > 0 ? seconds * 1e9 / (double)ops : 0.0,
+        seconds > 0 ? (double)ops / seconds : 0.0);
+}
+
+static int8_t Scene_init(Scene *scene, const SceneDesc *desc, int32_t count, uint32_t seed)
+{
+    memset(scene, 0, sizeof(Scene));
+    scene->name = desc->name;
+    scene->vertices = desc->vertices;
+    scene->count = count;
+    int32_t stride = desc->vertices > 0 ? desc->vertices : 8;
+    scene->positions = malloc(count * sizeof(EcsVector2D));
+    scene->rotations = malloc(count * sizeof(EcsRotation));
+    scene->circles = calloc(count, sizeof(EcsCircleCollider));
+    scene->polygons = calloc(count, sizeof(EcsPolygonCollider));
+    scene->points = malloc(count * stride * sizeof(EcsPoint));
+    scene->data = calloc(count, sizeof(EcsColliderData));
+    scene->colliders = malloc(count * sizeof(EcsColliderData*));
+    if (scene->positions == NULL || scene->rotations == NULL || scene->circles == NULL ||
+        scene->polygons == NULL || scene->points == NULL || scene->data == NULL || scene->colliders == NULL) {
+        return false;
+    }
+
+    // Constant density, about two candidate pairs per collider
+    uint32_t state = seed ? seed : 1;
+    float side = sqrtf((float)count) * 3.0f;
+    for (int32_t i = 0; i < count; i++) {
+        scene->positions[i][0] = Bench_uniform(&state, 0, side);
+        scene->positions[i][1] = Bench_uniform(&state, 0, side);
+        EcsRotation_set(&scene->rotations[i], Bench_uniform(&state, 0, 2 * (float)M_PI));
+        scene->data[i][0] = &scene->positions[i];
+        scene->colliders[i] = &scene->data[i];
+
+        int32_t vertices = desc->vertices;
+        if (vertices < 0) {
+            vertices = i % 2 ? 3 + (int32_t)(Bench_random(&state) % 6) : 0;
+        }
+        if (vertices == 0) {
+            scene->circles[i].radius = Bench_uniform(&state, 0.5f, 1.5f);
+            scene->data[i][1] = &scene->circles[i];
+            continue;
+        }
+
+        EcsPoint *points = &scene->points[i * stride];
+        if (vertices == 4) {
+            float half_width = Bench_uniform(&state, 0.5f, 1.5f);
+            float half_height = Bench_uniform(&state, 0.5f, 1.5f);
+            points[0][0] = -half_width; points[0][1] = -half_height;
+            points[1][0] = half_width;  points[1][1] = -half_height;
+            points[2][0] = half_width;  points[2][1] = half_height;
+            points[3][0] = -half_width; points[3][1] = half_height;
+        } else {
+            float radius = Bench_uniform(&state, 0.5f, 1.5f);
+            float phase = Bench_uniform(&state, 0, 2 * (float)M_PI);
+            for (int32_t j = 0; j < vertices; j++) {
+                float angle = phase + 2 * (float)M_PI * j / vertices;
+                points[j][0] = cosf(angle) * radius;
+                points[j][1] = sinf(angle) * radius;
+            }
+        }
+        if (!EcsPolygonCollider_init(&scene->polygons[i], points, vertices)) {
+            return false;
+        }
+        scene->data[i][2] = &scene->polygons[i];
+        scene->data[i][3] = &scene->rotations[i];
+    }
+
+    EcsSweepAndPrune sap;
+    EcsSweepAndPrune_init(&sap);
+    int8_t result = EcsSweepAndPrune_update(&sap, scene->colliders, count);
+    if (result) {
+        scene->pair_count = EcsSweepAndPrune_getPairs(&sap, NULL, 0);
+        scene->pairs = malloc((scene->pair_count + 1) * sizeof(EcsColliderPair));
+        result = scene->pairs != NULL;
+    }
+    if (result) {
+        EcsSweepAndPrune_getPairs(&sap, scene->pairs, scene->pair_count);
+    }
+    EcsSweepAndPrune_deinit(&sap);
+    return result;
+}
+
+static void Scene_deinit(Scene *scene)
+{
+    for (int32_t i = 0; scene->polygons != NULL && i < scene->count; i++) {
+        EcsPolygonCollider_release(&scene->polygons[i]);
+    }
+    free(scene->positions);
+    free(scene->rotations);
+    free(scene->circles);
+    free(scene->polygons);
+    free(scene->points);
+    free(scene->data);
+    free(scene->colliders);
+    free(scene->pairs);
+    memset(scene, 0, sizeof(Scene));
+}
+
+static int32_t Scene_getPairType(Scene *scene, EcsColliderPair *pair)
+{
+    int8_t polygon_a = scene->data[pair->a][2] != NULL;
+    int8_t polygon_b = scene->data[pair->b][2] != NULL;
+    return polygon_a + polygon_b;
+}
+
+/* EcsPhysis2dCollisionCheck on the candidate pairs, by pair type */
+static void Bench_collide(Scene *scene, Options *options)
+{
+    EcsColliderPair *buckets[3];
+    int32_t counts[3] = {0, 0, 0};
+    for (int32_t t = 0; t < 3; t++) {
+        buckets[t] = malloc((scene->pair_count + 1) * sizeof(EcsColliderPair));
+    }
+    for (int32_t i = 0; i < scene->pair_count; i++) {
+        int32_t type = Scene_getPairType(scene, &scene->pairs[i]);
+        if (buckets[type] != NULL) {
+            buckets[type][counts[type]++] = scene->pairs[i];
+        }
+    }
+
+    for (int32_t t = 0; t < 3; t++) {
+        if (buckets[t] == NULL || counts[t] == 0) {
+            continue;
+        }
+        EcsColliderPair *pairs = buckets[t];
+        EcsCollisionInfo info;
+        int64_t ops = 0;
+        int64_t hits = 0;
+        double start = Bench_now();
+        double elapsed;
+        do {
+            for (int32_t i = 0; i < counts[t]; i++) {
+                hits += EcsPhysis2dCollisionCheck(scene->colliders[pairs[i].a], scene->colliders[pairs[i].b], &info);
+            }
+            ops += counts[t];
+            elapsed = Bench_now() - start;
+        } while (elapsed < options->min_time);
+        sink += hits;
+        Bench_report("collide", scene->name, scene->count, pair_names[t], "pair", ops, elapsed);
+    }
+    for (int32_t t = 0; t < 3; t++) {
+        free(buckets[t]);
+    }
+}
+
+/* EcsColliderData_getAABB of every collider, by shape */
+static void Bench_aabb(Scene *scene, Options *options)
+{
+    for (int32_t polygon = 0; polygon < 2; polygon++) {
+        int32_t count = 0;
+        for (int32_t i = 0; i < scene->count; i++) {
+            count += (scene->data[i][2] != NULL) == polygon;
+        }
+        if (count == 0) {
+            continue;
+        }
+        EcsAABB aabb;
+        int64_t ops = 0;
+        double start = Bench_now();
+        double elapsed;
+        do {
+            for (int32_t i = 0; i < scene->count; i++) {
+                if ((scene->data[i][2] != NULL) == polygon) {
+                    sink += EcsColliderData_getAABB(scene->colliders[i], &aabb);
+                }
+            }
+            ops += count;
+            elapsed = Bench_now() - start;
+        } while (elapsed < options->min_time);
+        Bench_report("aabb", scene->name, scene->count, polygon ? "polygon" : "circle", "collider", ops, elapsed);
+    }
+}
+
+/* EcsMatrix3x3_transform of the polygon vertices to world space */
+static void Bench_transform(Scene *scene, Options *options)
+{
+    EcsPoint buffer[MAX_VERTICES];
+    int64_t points = 0;
+    for (int32_t i = 0; i < scene->count; i++) {
+        points += scene->polygons[i].points_count;
+    }
+    if (points == 0) {
+        return;
+    }
+    int64_t ops = 0;
+    double start = Bench_now();
+    double elapsed;
+    do {
+        for (int32_t i = 0; i < scene->count; i++) {
+            EcsPolygonCollider *polygon = &scene->polygons[i];
+            if (polygon->points == NULL) {
+                continue;
+            }
+            EcsMatrix3x3 transform = EcsMatrix3x3_Identity();
+            EcsMatrix3x3_add_rotation(&transform, atan2f(scene->rotations[i].s, scene->rotations[i].c));
+            EcsMatrix3x3_add_translation(&transform, &scene->positions[i]);
+            EcsMatrix3x3_transform(&transform, polygon->points, buffer, polygon->points_count);
+            sink += (int64_t)buffer[0][0];
+        }
+        ops += points;
+        elapsed = Bench_now() - start;
+    } while (elapsed < options->min_time);
+    Bench_report("transform", scene->name, scene->count, "polygon", "point", ops, elapsed);
+}
+
+/* Full step over n: AABBs and broadphase, then every candidate pair */
+static int8_t Bench_step(Scene *scene, Options *options)
+{
+    EcsSweepAndPrune sap;
+    EcsSweepAndPrune_init(&sap);
+    EcsColliderPair *pairs = malloc((scene->pair_count + 1) * sizeof(EcsColliderPair));
+    if (pairs == NULL) {
+        return false;
+    }
+    EcsCollisionInfo info;
+    int64_t steps = 0;
+    int64_t pair_count = 0;
+    double start = Bench_now();
+    double elapsed;
+    do {
+        EcsSweepAndPrune_update(&sap, scene->colliders, scene->count);
+        int32_t count = EcsSweepAndPrune_getPairs(&sap, pairs, scene->pair_count);
+        for (int32_t i = 0; i < count && i < scene->pair_count; i++) {
+            sink += EcsPhysis2dCollisionCheck(scene->colliders[pairs[i].a], scene->colliders[pairs[i].b], &info);
+        }
+        pair_count += count;
+        steps++;
+        elapsed = Bench_now() - start;
+    } while (elapsed < options->min_time);
+    Bench_report("step", scene->name, scene->count, "sweep_and_prune", "step", steps, elapsed);
+    Bench_report("step", scene->name, scene->count, "sweep_and_prune", "pair", pair_count, elapsed);
+    free(pairs);
+    EcsSweepAndPrune_deinit(&sap);
+    return true;
+}
+
+/*
+ * Every projection kernel must give the same bits as the scalar one, runs
+ * the polygon pairs of scene with each kernel the CPU supports.
+ * Returns the number of mismatches.
+ */
+static int32_t Bench_checkKernels(Scene *scene, Options *options)
+{
+    int32_t mismatches_total = 0;
+    EcsCollisionInfo *expected = malloc((scene->pair_count + 1) * sizeof(EcsCollisionInfo));
+    int8_t *expected_hits = malloc(scene->pair_count + 1);
+    if (expected == NULL || expected_hits == NULL) {
+        free(expected);
+        free(expected_hits);
+        return 0;
+    }
+    EcsPhysis2d_setProjectionKernel(EcsProjectionKernelScalar);
+    for (int32_t i = 0; i < scene->pair_count; i++) {
+        memset(&expected[i], 0, sizeof(EcsCollisionInfo));
+        expected_hits[i] = EcsPhysis2dCollisionCheck(
+            scene->colliders[scene->pairs[i].a], scene->colliders[scene->pairs[i].b], &expected[i]);
+    }
+    for (int32_t kernel = EcsProjectionKernelSse2; kernel <= EcsProjectionKernelNeon; kernel++) {
+        if (!EcsPhysis2d_setProjectionKernel(kernel)) {
+            continue;
+        }
+        int32_t mismatches = 0;
+        for (int32_t i = 0; i < scene->pair_count; i++) {
+            EcsCollisionInfo info;
+            memset(&info, 0, sizeof(EcsCollisionInfo));
+            int8_t hit = EcsPhysis2dCollisionCheck(
+                scene->colliders[scene->pairs[i].a], scene->colliders[scene->pairs[i].b], &info);
+            if (hit != expected_hits[i] || (hit && memcmp(&info, &expected[i], sizeof(EcsCollisionInfo)))) {
+                mismatches++;
+            }
+        }
+        printf("{\"bench\": \"kernel_check\", \"scene\": \"%s\", \"n\": %d, \"case\": \"%s\", \"pairs\": %d, \"mismatches\": %d}\n",
+            scene->name, scene->count, kernel_names[kernel], scene->pair_count, mismatches);
+        mismatches_total += mismatches;
+    }
+    EcsPhysis2d_setProjectionKernel(options->kernel);
+    free(expected);
+    free(expected_hits);
+    return mismatches_total;
+}
+
+static int8_t Bench_parse(Options *options, int argc, char const *argv[])
+{
+    options->seed = 1;
+    options->max_count = 16384;
+    options->min_time = 0.1;
+    options->kernel = EcsProjectionKernelAuto;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || argv[i][0] != '-') {
+            return false;
+        }
+        const char *value = argv[++i];
+        switch (argv[i - 1][1]) {
+        case 's':
+            options->seed = (uint32_t)strtoul(value, NULL, 10);
+            break;
+        case 'n':
+            options->max_count = atoi(value);
+            break;
+        case 't':
+            options->min_time = atof(value) * 1e-3;
+            break;
+        case 'k': {
+            int32_t kernel = 0;
+            while (kernel <= EcsProjectionKernelNeon && strcmp(kernel_names[kernel], value)) {
+                kernel++;
+            }
+            if (kernel > EcsProjectionKernelNeon) {
+                return false;
+            }
+            options->kernel = kernel;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return options->max_count > 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    Options options;
+    if (!Bench_parse(&options, argc, argv)) {
+        fprintf(stderr, "usage: %s [-s seed] [-n max colliders] [-t min ms per case] [-k auto|scalar|sse2|avx2|neon]\n", argv[0]);
+        return 1;
+    }
+    if (!EcsPhysis2d_setProjectionKernel(options.kernel)) {
+        fprintf(stderr, "projection kernel %s is not supported\n", kernel_names[options.kernel]);
+        return 1;
+    }
+    printf("{\"bench\": \"config\", \"seed\": %u, \"max_n\": %d, \"min_time_ms\": %.1f, \"kernel\": \"%s\"}\n",
+        options.seed, options.max_count, options.min_time * 1e3, kernel_names[EcsPhysis2d_getProjectionKernel()]);
+
+    int32_t count = options.max_count < DEFAULT_COUNT ? options.max_count : DEFAULT_COUNT;
+    int32_t mismatches = 0;
+    Scene scene;
+    for (size_t s = 0; s < SCENE_COUNT; s++) {
+        if (!Scene_init(&scene, &scenes[s], count, options.seed)) {
+            fprintf(stderr, "out of memory\n");
+            Scene_deinit(&scene);
+            return 1;
+        }
+        Bench_collide(&scene, &options);
+        Bench_aabb(&scene, &options);
+        Bench_transform(&scene, &options);
+        if (scenes[s].vertices != 0) {
+            mismatches += Bench_checkKernels(&scene, &options);
+        }
+        Scene_deinit(&scene);
+    }
+
+    // Scaling curve, n from 64 to max_n by factors of 4
+    for (size_t s = 0; s < SCALING_SCENES; s++) {
+        for (int32_t n = 64; n <= options.max_count; n *= 4) {
+            if (!Scene_init(&scene, &scenes[s], n, options.seed) || !Bench_step(&scene, &options)) {
+                fprintf(stderr, "out of memory\n");
+                Scene_deinit(&scene);
+                return 1;
+            }
+            Scene_deinit(&scene);
+        }
+    }
+    return mismatches ? 2 : 0;
+}
@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include "physics_util.h"
+#include "physics_aabb_tree.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,16 +16,453 @@ typedef struct EcsCircleCollider {
     float radius;
 } EcsCircleCollider;
 
+/**
+ * Points within radius of the segment [point1, point2], the segment is in
+ * local space and rotates with the collider
+ */
+typedef struct EcsCapsuleCollider {
+    EcsPoint point1;
+    EcsPoint point2;
+    float radius;
+} EcsCapsuleCollider;
+
+/**
+ * Box centered on the position and aligned with the world axes, the rotation
+ * of the collider does not apply to it
+ *  half_extents: Half of the width and half of the height
+ */
+typedef struct EcsBoxCollider {
+    EcsVector2D half_extents;
+} EcsBoxCollider;
+
+/**
+ * Extreme vertex lookup entry of a polygon
+ *  angle: Pseudo angle of an outward edge normal, ordered as atan2
+ *  vertex: Extreme vertex for directions between the previous entry and angle
+ */
+typedef struct EcsPolygonSupport {
+    float angle;
+    int32_t vertex;
+} EcsPolygonSupport;
+
+/**
+ * Fixed size polygons with a dedicated narrowphase path
+ *  EcsPolygonShapeBox: 4 vertices, every edge normal opposite to the normal
+ *                      of the facing edge, only 2 SAT axes are tested
+ */
+typedef enum EcsPolygonShape {
+    EcsPolygonShapeGeneric = 0,
+    EcsPolygonShapeTriangle,
+    EcsPolygonShapeBox
+} EcsPolygonShape;
+
+/**
+ * Convex polygon in local space
+ *  normals: Unit normal of every edge [i, i+1], baked by
+ *           EcsPolygonCollider_bake (Can be NULL)
+ *  supports: Edge normals sorted by angle, baked for big convex polygons only.
+ *            Finds the extreme vertex along a direction in O(log n) (Can be
+ *            NULL, the points are scanned then)
+ *  facing: For every edge, the earlier edge with the opposite normal or -1.
+ *          SAT projects once on the axis of both edges (Can be NULL, baked
+ *          when at least two edges face each other)
+ *  shape: EcsPolygonShape found by EcsPolygonCollider_bake
+ *  winding: 1 for counter clockwise points, -1 for clockwise, baked with the
+ *           normals
+ *  aabb: Bounds of the points in the local frame, baked with the normals
+ */
 typedef struct EcsPolygonCollider {
     EcsPoint *points;
-    int8_t points_count; //MAX 128
+    int32_t points_count;
+    EcsVector2D *normals;
+    EcsPolygonSupport *supports;
+    int32_t *facing;
+    int8_t shape;
+    int8_t winding;
+    EcsAABB aabb;
 } EcsPolygonCollider;
 
+/**
+ * World space vertices of a polygon
+ *  polygon, position: Polygon and position components of the collider (key)
+ *  transform: Position and rotation the vertices were transformed with
+ *  soa: Same vertices, capacity x coordinates followed by the y coordinates
+ *  stamp: Entry is in use when it matches EcsVertexCache::stamp
+ */
+typedef struct EcsVertexCacheEntry {
+    EcsPolygonCollider *polygon;
+    EcsPoint *position;
+    EcsTransform transform;
+    EcsPoint *vertices;
+    float *soa;
+    int32_t count;
+    int32_t capacity;
+    uint32_t stamp;
+} EcsVertexCacheEntry;
+
+/**
+ * Per step cache of world space polygon vertices
+ *
+ * Every polygon is transformed once per step, entries are keyed by the
+ * polygon and position components of the collider, so colliders sharing a
+ * polygon get vertices of their own. Entries are transformed again when the
+ * position or the rotation changes.
+ * Call EcsVertexCache_begin at the start of every step, vertex buffers are
+ * reused between steps.
+ */
+typedef struct EcsVertexCache {
+    EcsVertexCacheEntry *entries;
+    int32_t size;
+    int32_t count;
+    uint32_t stamp;
+} EcsVertexCache;
+
+/**
+ * Last separating axis of a polygon pair
+ *  polygon_a, position_a, polygon_b, position_b: Polygon and position
+ *    components of both colliders (key, ordered by polygon then position)
+ *  owner: Collider whose edge separated the pair, 0 for a and 1 for b, -1
+ *    while they overlap
+ *  edge: Edge of owner
+ *  stamp: Step the entry was last used in
+ */
+typedef struct EcsSatCacheEntry {
+    EcsPolygonCollider *polygon_a;
+    EcsPoint *position_a;
+    EcsPolygonCollider *polygon_b;
+    EcsPoint *position_b;
+    int8_t owner;
+    int32_t edge;
+    uint32_t stamp;
+} EcsSatCacheEntry;
+
+/**
+ * Separating axis cache for pairs tested on consecutive steps
+ *
+ * A pair separated on the last step is tested first on the axis that
+ * separated it, which usually still does. Entries not used during a step are
+ * dropped by the next EcsSatCache_begin.
+ *  hits: Tests that ended on the cached axis
+ *  misses: Tests that needed every axis
+ */
+typedef struct EcsSatCache {
+    EcsSatCacheEntry *entries;
+    EcsSatCacheEntry *spare;
+    int32_t size;
+    int32_t count;
+    uint32_t stamp;
+    uint64_t hits;
+    uint64_t misses;
+} EcsSatCache;
+
+/**
+ * Narrowphase algorithm
+ *  EcsNarrowphaseSat: Separating axis tests, per shape combination
+ *  EcsNarrowphaseGjk: GJK + EPA on the support functions of the shapes,
+ *                     cheaper for polygons with many vertices
+ */
+typedef enum EcsNarrowphase {
+    EcsNarrowphaseSat = 0,
+    EcsNarrowphaseGjk = 1
+} EcsNarrowphase;
+
+/**
+ * Optional state shared by the narrowphase calls of a step
+ *  vertex_cache: World space vertex cache (Can be NULL)
+ *  sat_cache: Separating axis cache (Can be NULL)
+ *  narrowphase: Algorithm used by the context based checks
+ */
+typedef struct EcsPhysis2dContext {
+    EcsVertexCache *vertex_cache;
+    EcsSatCache *sat_cache;
+    EcsNarrowphase narrowphase;
+} EcsPhysis2dContext;
+
+/**
+ * Closest points of two colliders
+ *  distance: Distance between the surfaces, 0 when they overlap
+ *  point_a, point_b: Closest point on a and on b (the same point on overlap)
+ */
+typedef struct EcsDistanceInfo {
+    float distance;
+    EcsPoint point_a;
+    EcsPoint point_b;
+} EcsDistanceInfo;
+
+/**
+ * First contact of two moving colliders
+ *  time: Fraction of the step when they touch, in [0, 1]
+ *  normal: Unit contact normal, from a to b
+ *  point: World contact point at time
+ */
+typedef struct EcsToiInfo {
+    float time;
+    EcsVector2D normal;
+    EcsPoint point;
+} EcsToiInfo;
+
+/**
+ * Sets the points of polygon and bakes it.
+ */
+int8_t EcsPolygonCollider_init(EcsPolygonCollider *polygon, EcsPoint *points, int32_t points_count);
+
+/**
+ * Precomputes the edge normals, winding and bounds of polygon, the supports of polygons with
+ * many vertices, the edges facing each other and the shape of triangles and
+ * boxes, call it again after changing the points. Baked data is owned
+ * by the polygon, free it with EcsPolygonCollider_release.
+ */
+int8_t EcsPolygonCollider_bake(EcsPolygonCollider *polygon);
+void EcsPolygonCollider_release(EcsPolygonCollider *polygon);
+
+/**
+ * Contact point of a manifold
+ *  position: World point halfway between both surfaces
+ *  depth: Penetration depth at the point
+ *  id: Feature id, the same while the same edges and vertices touch
+ */
+typedef struct EcsContactPoint {
+    EcsVector2D position;
+    float depth;
+    uint32_t id;
+} EcsContactPoint;
+
+/**
+ * Contact manifold of a colliding pair
+ *  normal: Unit collision normal, from a to b
+ *  points_count: Number of valid entries in points
+ */
+typedef struct EcsContactManifold {
+    EcsVector2D normal;
+    int8_t points_count;
+    EcsContactPoint points[2];
+} EcsContactManifold;
+
+void EcsVertexCache_init(EcsVertexCache *cache);
+void EcsVertexCache_deinit(EcsVertexCache *cache);
+void EcsVertexCache_begin(EcsVertexCache *cache);
+
+/**
+ * Returns the world space vertices of a polygon collider, NULL on error.
+ * The pointer is valid until the next EcsVertexCache_begin.
+ */
+EcsPoint* EcsVertexCache_get(EcsVertexCache *cache, EcsColliderData *collider);
+
+void EcsSatCache_init(EcsSatCache *cache);
+void EcsSatCache_deinit(EcsSatCache *cache);
+
+/**
+ * Starts a step, drops the pairs that were not tested on the last one.
+ */
+void EcsSatCache_begin(EcsSatCache *cache);
+void EcsSatCache_resetStats(EcsSatCache *cache);
+
 int8_t EcsPhysis2dCollisionCheck(
     EcsColliderData *collider_a, 
     EcsColliderData *collider_b, 
     EcsCollisionInfo *collision_out);
 
+/**
+ * Same as EcsPhysis2dCollisionCheck, using the state in ctx (Can be NULL).
+ * With ctx->narrowphase set to EcsNarrowphaseGjk every pair goes through
+ * EcsPhysis2dCollisionCheckGjk.
+ */
+int8_t EcsPhysis2dCollisionCheckWithContext(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a, 
+    EcsColliderData *collider_b, 
+    EcsCollisionInfo *collision_out);
+
+/**
+ * GJK + EPA collision test, for every shape combination.
+ * collision_out->distance is the penetration depth (positive) and
+ * direction * distance moves a out of b.
+ */
+int8_t EcsPhysis2dCollisionCheckGjk(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a, 
+    EcsColliderData *collider_b, 
+    EcsCollisionInfo *collision_out);
+
+/**
+ * Distance and closest points of two colliders (GJK).
+ * Returns false on invalid colliders.
+ */
+int8_t EcsPhysis2dDistance(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a, 
+    EcsColliderData *collider_b, 
+    EcsDistanceInfo *distance_out);
+
+/**
+ * Same test as EcsPhysis2dCollisionCheckWithContext, producing a contact
+ * manifold. Polygon pairs get up to two points from clipping the incident
+ * edge against the reference edge, circle pairs get one point. Capsules
+ * and boxes clip their segment or corners the same way, with the radius
+ * around them.
+ */
+int8_t EcsPhysis2dCollisionManifold(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a, 
+    EcsColliderData *collider_b, 
+    EcsContactManifold *manifold_out);
+
+/**
+ * Time of impact of two colliders moving along their sweeps, a NULL sweep
+ * keeps the collider at its position.
+ * Circles are swept analytically against circles, polygons and boxes, the
+ * other pairs use conservative advancement on the GJK distance. Pairs
+ * overlapping at the start get time 0.
+ * Returns true when they touch during the step.
+ */
+int8_t EcsPhysis2dTimeOfImpact(
+    EcsColliderData *collider_a,
+    EcsSweep *sweep_a,
+    EcsColliderData *collider_b,
+    EcsSweep *sweep_b,
+    EcsToiInfo *toi_out);
+
+/**
+ * Ray against a single collider. Rays starting inside the collider do not
+ * hit it. Rays missing the bounds of baked polygons, capsules and boxes are
+ * rejected before the exact test. Returns true on hit.
+ */
+int8_t EcsPhysis2dRaycast(
+    EcsColliderData *collider,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out);
+
+/**
+ * Moves shape by translation and returns its first contact with target.
+ * hit_out->normal is the surface normal of target, hit_out->point the
+ * contact point. Shapes overlapping at the start hit at fraction 0.
+ */
+int8_t EcsPhysis2dShapeCast(
+    EcsColliderData *shape,
+    EcsVector2D *translation,
+    EcsColliderData *target,
+    EcsRaycastHit *hit_out);
+
+/**
+ * Casts rays[0..ray_count) against the colliders of tree, the user ids of the
+ * leaves are indices into colliders. Leaves are culled by the tree. With
+ * closest set every hit clips the ray, so colliders past the closest hit
+ * are never tested.
+ *
+ *  closest: true for the closest hit of every ray only, false for all hits
+ *  hits_out: Hits, grouped by ray in the order of rays
+ * Returns the total number of hits, which can be greater than max_hits when
+ * hits_out is too small.
+ */
+int32_t EcsPhysis2dRaycastBatch(
+    EcsAABBTree *tree,
+    EcsColliderData **colliders,
+    EcsRay *rays,
+    int32_t ray_count,
+    int8_t closest,
+    EcsRaycastHit *hits_out,
+    int32_t max_hits);
+
+/**
+ * Moves shapes[i] by translations[i] for i in [0, shape_count) against the
+ * colliders of tree, as EcsPhysis2dShapeCast. The user ids of the leaves are
+ * indices into colliders, only the leaves overlapping the swept AABB of a
+ * shape are tested. A shape never hits the collider it points to.
+ *
+ *  closest: true for the closest hit of every shape only, false for all hits
+ *  hits_out: Hits, grouped by shape in the order of shapes, hit->ray is the
+ *            index of the shape
+ * Returns the total number of hits, which can be greater than max_hits when
+ * hits_out is too small.
+ */
+int32_t EcsPhysis2dShapeCastBatch(
+    EcsAABBTree *tree,
+    EcsColliderData **colliders,
+    EcsColliderData **shapes,
+    EcsVector2D *translations,
+    int32_t shape_count,
+    int8_t closest,
+    EcsRaycastHit *hits_out,
+    int32_t max_hits);
+
+/**
+ * Tests pairs[0..pair_count) of colliders and writes the hits only.
+ * Pairs are grouped by shape combination before testing, the output keeps
+ * the order of pairs.
+ *
+ *  ctx: Narrowphase state (Can be NULL)
+ *  collisions_out: Collision info of every hit (pair_count entries max)
+ *  hits_out: Index in pairs of every hit (Can be NULL)
+ * Returns the number of hits.
+ */
+int32_t EcsPhysis2dCollisionCheckBatch(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out);
+
+/**
+ * Shape combination of a narrowphase pair, circles first. Every pair with a
+ * capsule or a box counts as EcsStatsPairPrimitive.
+ */
+typedef enum EcsStatsPair {
+    EcsStatsPairCircleCircle = 0,
+    EcsStatsPairCirclePolygon,
+    EcsStatsPairPolygonPolygon,
+    EcsStatsPairPrimitive,
+    EcsStatsPairCount
+} EcsStatsPair;
+
+/**
+ * Stages of a step timed by the stats
+ *  EcsStatsStageAABB: World AABBs of the broadphases and the world
+ *  EcsStatsStageBroadphase: Sorting and pair search of the broadphases
+ *  EcsStatsStageNarrowphase: Batched pair tests
+ *  EcsStatsStageSolver: Contact solver steps
+ */
+typedef enum EcsStatsStage {
+    EcsStatsStageAABB = 0,
+    EcsStatsStageBroadphase,
+    EcsStatsStageNarrowphase,
+    EcsStatsStageSolver,
+    EcsStatsStageCount
+} EcsStatsStage;
+
+/**
+ * Hot path counters, only compiled in when the library is built with
+ * ECS_PHYSICS_STATS defined, without it they cost nothing and read as 0.
+ *
+ * Every thread counts into its own slot, reads sum the slots. Slots are
+ * given back when their thread exits, past 63 live threads the rest share
+ * one. Read and reset between steps, counts made during a reset can be lost.
+ *  pair_tests, pair_hits: Narrowphase tests and collisions by EcsStatsPair
+ *  early_outs: Misses rejected before the full test: circle pairs on the
+ *              distance, circle polygon pairs by an edge, polygon pairs by
+ *              the cached separating axis
+ *  axes_projected: SAT axes both polygons were projected on, and polygon
+ *                  edges tested against circles
+ *  aabbs: AABBs computed
+ *  stage_time: Nanoseconds spent in every EcsStatsStage, summed over threads
+ *  stage_calls: Timed calls of every stage
+ */
+typedef struct EcsPhysicsStats {
+    uint64_t pair_tests[EcsStatsPairCount];
+    uint64_t pair_hits[EcsStatsPairCount];
+    uint64_t early_outs[EcsStatsPairCount];
+    uint64_t axes_projected;
+    uint64_t aabbs;
+    uint64_t stage_time[EcsStatsStageCount];
+    uint64_t stage_calls[EcsStatsStageCount];
+} EcsPhysicsStats;
+
+/**
+ * True when the library was built with ECS_PHYSICS_STATS.
+ */
+int8_t EcsPhysicsStats_isEnabled(void);
+void EcsPhysicsStats_get(EcsPhysicsStats *stats_out);
+void EcsPhysicsStats_reset(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,104 @@
+#ifndef PHYSICS_2D_PHYSICS_AABB_TREE_H
+#define PHYSICS_2D_PHYSICS_AABB_TREE_H
+
+#include <unistd.h>
+
+#include "physics_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EcsAABBTree_NullNode (-1)
+
+/**
+ * Node of the dynamic AABB tree
+ *  aabb: Fattened AABB for leaves, union of the children for branches
+ *  parent: Parent node, next free node when the node is not in use
+ *  height: 0 for leaves, -1 for free nodes
+ *  user_id: Caller value of the leaf (collider index)
+ */
+typedef struct EcsAABBTreeNode {
+    EcsAABB aabb;
+    int32_t parent;
+    int32_t child1;
+    int32_t child2;
+    int32_t height;
+    int32_t user_id;
+} EcsAABBTreeNode;
+
+/**
+ * Dynamic bounding volume tree
+ *
+ * Leaves store an AABB fattened by margin, a move that stays inside the
+ * fattened AABB does not touch the tree. The tree is kept balanced with
+ * rotations on every insertion and removal.
+ */
+typedef struct EcsAABBTree {
+    EcsAABBTreeNode *nodes;
+    int32_t root;
+    int32_t count;
+    int32_t capacity;
+    int32_t free_list;
+    float margin;
+} EcsAABBTree;
+
+/**
+ * Query callbacks, return false to stop the query.
+ */
+typedef int8_t (*EcsAABBTreeQueryCallback)(void *ctx, int32_t user_id);
+typedef int8_t (*EcsAABBTreePairCallback)(void *ctx, int32_t user_id_a, int32_t user_id_b);
+
+/**
+ * Ray query callback, returns the new max fraction of the ray: 0 stops the
+ * query, ray->max_fraction goes on, a smaller value clips the ray.
+ */
+typedef float (*EcsAABBTreeRaycastCallback)(void *ctx, EcsRay *ray, int32_t user_id);
+
+void EcsAABBTree_init(EcsAABBTree *tree, float margin);
+void EcsAABBTree_deinit(EcsAABBTree *tree);
+
+/**
+ * Inserts a leaf for aabb, returns the proxy id or EcsAABBTree_NullNode.
+ */
+int32_t EcsAABBTree_insert(EcsAABBTree *tree, EcsAABB *aabb, int32_t user_id);
+void EcsAABBTree_remove(EcsAABBTree *tree, int32_t proxy);
+
+/**
+ * Updates the leaf with a new tight aabb.
+ * Returns true when the leaf escaped its fattened AABB and was reinserted.
+ */
+int8_t EcsAABBTree_move(EcsAABBTree *tree, int32_t proxy, EcsAABB *aabb);
+
+int32_t EcsAABBTree_getUserId(EcsAABBTree *tree, int32_t proxy);
+EcsAABB* EcsAABBTree_getFatAABB(EcsAABBTree *tree, int32_t proxy);
+int32_t EcsAABBTree_getHeight(EcsAABBTree *tree);
+
+/**
+ * Calls callback for every leaf whose fattened AABB overlaps aabb.
+ */
+void EcsAABBTree_query(EcsAABBTree *tree, EcsAABB *aabb, EcsAABBTreeQueryCallback callback, void *ctx);
+
+/**
+ * Calls callback for every leaf whose fattened AABB the ray crosses (slab
+ * test), with the ray clipped by the previous callbacks.
+ */
+void EcsAABBTree_raycast(EcsAABBTree *tree, EcsRay *ray, EcsAABBTreeRaycastCallback callback, void *ctx);
+
+/**
+ * Calls callback for every pair of overlapping leaves of tree_a and tree_b,
+ * user_id_a belongs to tree_a and user_id_b to tree_b.
+ */
+void EcsAABBTree_queryTree(EcsAABBTree *tree_a, EcsAABBTree *tree_b, EcsAABBTreePairCallback callback, void *ctx);
+
+/**
+ * Writes up to max_pairs overlapping leaf pairs of the tree as user ids.
+ * Returns the total number of pairs found.
+ */
+int32_t EcsAABBTree_getPairs(EcsAABBTree *tree, EcsColliderPair *pairs_out, int32_t max_pairs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef PHYSICS_2D_PHYSICS_BROADPHASE_H
+#define PHYSICS_2D_PHYSICS_BROADPHASE_H
+
+#include <unistd.h>
+
+#include "physics_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sweep and prune endpoint
+ *  value: Min value of the collider AABB on the sweep axis
+ *  index: Index of the collider in the array passed to update
+ */
+typedef struct EcsSweepAndPruneEndpoint {
+    float value;
+    int32_t index;
+} EcsSweepAndPruneEndpoint;
+
+/**
+ * Sweep and prune broadphase
+ *
+ * aabbs: World AABB of every collider, indexed as the collider array
+ * endpoints: Colliders sorted by AABB min on the sweep axis
+ * ranks: Position of every collider in endpoints
+ * axis: Sweep axis (0 = X, 1 = Y), the one with the greatest variance
+ * max_extent: Largest AABB size on the sweep axis, bounds region queries.
+ *             Updates recompute it, moves grow it and recompute it when
+ *             they shrink the largest collider
+ * max_index: Collider of max_extent, -1 without colliders
+ *
+ * The sorted order is kept between updates, when the collider count and the
+ * sweep axis do not change it is refreshed with an insertion sort, which is
+ * close to O(n) for scenes where few colliders move.
+ */
+typedef struct EcsSweepAndPrune {
+    EcsAABB *aabbs;
+    EcsSweepAndPruneEndpoint *endpoints;
+    int32_t *ranks;
+    int32_t count;
+    int32_t capacity;
+    float max_extent;
+    int32_t max_index;
+    int8_t axis;
+} EcsSweepAndPrune;
+
+/**
+ * Region query callback, index is the collider index passed to update.
+ * Returns false to stop the query.
+ */
+typedef int8_t (*EcsSweepAndPruneQueryCallback)(void *ctx, int32_t index);
+
+void EcsSweepAndPrune_init(EcsSweepAndPrune *sap);
+void EcsSweepAndPrune_deinit(EcsSweepAndPrune *sap);
+
+/**
+ * Rebuilds the AABBs of colliders[0..count) and sorts them on the sweep axis.
+ * Colliders without a valid shape never produce pairs.
+ */
+int8_t EcsSweepAndPrune_update(EcsSweepAndPrune *sap, EcsColliderData **colliders, int32_t count);
+
+/**
+ * Same as EcsSweepAndPrune_update, with AABBs computed by the caller.
+ */
+int8_t EcsSweepAndPrune_updateAABBs(EcsSweepAndPrune *sap, EcsAABB *aabbs, int32_t count);
+
+/**
+ * Replaces the AABBs of the colliders in indices[0..count) with aabbs[index]
+ * and moves their endpoints back in order. The colliders and the sweep axis
+ * of the last update are kept, so the cost only depends on the colliders
+ * moved, for scenes where most colliders are at rest.
+ */
+int8_t EcsSweepAndPrune_move(EcsSweepAndPrune *sap, int32_t *indices, int32_t count, EcsAABB *aabbs);
+
+/**
+ * Writes up to max_pairs candidate pairs whose AABBs overlap (EcsAABBTest).
+ * Returns the total number of candidate pairs, which can be greater than
+ * max_pairs when pairs_out is too small.
+ */
+int32_t EcsSweepAndPrune_getPairs(EcsSweepAndPrune *sap, EcsColliderPair *pairs_out, int32_t max_pairs);
+
+/**
+ * Calls callback for every collider whose AABB overlaps aabb (EcsAABBTest).
+ * Binary searches the sorted endpoints, only the colliders within max_extent
+ * of the region on the sweep axis are tested. One large collider makes
+ * every query scan more, EcsAABBTree_query does not depend on it.
+ */
+void EcsSweepAndPrune_query(EcsSweepAndPrune *sap, EcsAABB *aabb, EcsSweepAndPruneQueryCallback callback, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
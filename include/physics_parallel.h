@@ -0,0 +1,104 @@
+#ifndef PHYSICS_2D_PHYSICS_PARALLEL_H
+#define PHYSICS_2D_PHYSICS_PARALLEL_H
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include "physics_2d.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Task of EcsThreadPool_run, worker is the index of the thread running it
+ */
+typedef void (*EcsThreadPoolTask)(void *ctx, int32_t task, int32_t worker);
+
+/**
+ * Worker of a thread pool
+ *  range: Tasks left in the deque of the worker, first in the low 32 bits
+ *         and end in the high 32 bits. The owner pops from the front and
+ *         the other workers steal from the back
+ *  generation: Last run the worker took part in, set before its thread
+ *              starts so a run started right after init is not missed
+ *  scratch: Memory owned by the worker, kept between runs
+ */
+typedef struct EcsThreadPoolWorker {
+    struct EcsThreadPool *pool;
+    int32_t index;
+    uint32_t generation;
+    uint64_t range;
+    void *scratch;
+    size_t scratch_size;
+    uint8_t padding[24];
+} EcsThreadPoolWorker;
+
+/**
+ * Work-stealing thread pool
+ *
+ * The tasks of a run are split in equal ranges, one per worker, idle workers
+ * steal the remaining tasks of the others. The calling thread works as
+ * worker 0, so thread_count - 1 threads are started by init and wait for
+ * runs until deinit.
+ */
+typedef struct EcsThreadPool {
+    EcsThreadPoolWorker *workers;
+    pthread_t *threads;
+    int32_t thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint32_t generation;
+    int32_t running;
+    int8_t quit;
+    EcsThreadPoolTask task;
+    void *ctx;
+} EcsThreadPool;
+
+/**
+ * thread_count: Workers including the calling thread, 0 for one per core
+ * and 1 to run everything on the calling thread.
+ */
+void EcsThreadPool_init(EcsThreadPool *pool, int32_t thread_count);
+void EcsThreadPool_deinit(EcsThreadPool *pool);
+int32_t EcsThreadPool_getThreadCount(EcsThreadPool *pool);
+
+/**
+ * Runs task for every task index in [0, task_count) and returns when all
+ * of them are done.
+ */
+void EcsThreadPool_run(EcsThreadPool *pool, int32_t task_count, EcsThreadPoolTask task, void *ctx);
+
+/**
+ * Scratch memory of a worker with at least size bytes, the content is kept
+ * when it grows. Only the worker itself may call it during a run.
+ * Returns NULL on allocation failure.
+ */
+void* EcsThreadPool_getScratch(EcsThreadPool *pool, int32_t worker, size_t size);
+
+/**
+ * Parallel EcsPhysis2dCollisionCheckBatch, same arguments and bit-identical
+ * output for any thread count.
+ *
+ * Pairs are split in chunks which are tested by the workers of pool into
+ * per worker buffers, then merged in pair order. The caches of ctx are
+ * filled for every pair before the parallel part so the workers only read
+ * them, pairs must be unique when ctx has a SAT cache.
+ * A NULL pool or a pool with a single thread tests the pairs on the calling
+ * thread.
+ */
+int32_t EcsPhysis2dCollisionCheckParallel(
+    EcsThreadPool *pool,
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef PHYSICS_2D_PHYSICS_SIMD_H
+#define PHYSICS_2D_PHYSICS_SIMD_H
+
+#include <unistd.h>
+
+#include "physics_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Implementations of the projection kernel
+ *  EcsProjectionKernelAuto: Best kernel supported by the CPU
+ */
+typedef enum EcsProjectionKernel {
+    EcsProjectionKernelAuto = 0,
+    EcsProjectionKernelScalar,
+    EcsProjectionKernelSse2,
+    EcsProjectionKernelAvx2,
+    EcsProjectionKernelNeon
+} EcsProjectionKernel;
+
+/**
+ * Projects count points, given as separate x and y arrays, onto axis.
+ *  out: [0] = Min dot(axis, point), [1] = Max dot(axis, point)
+ *
+ * Every kernel returns the same bits as the scalar one: products and sums
+ * are never fused and a zero result is always +0. NaN products are skipped
+ * by every kernel. The library is built with -ffp-contract=off, so the
+ * scalar projections of the other sources are not fused either.
+ */
+void EcsPhysis2d_projectSoA(EcsVector2D *axis, const float *xs, const float *ys, int32_t count, EcsVector2D *out);
+
+/**
+ * Selects the kernel used by EcsPhysis2d_projectSoA, the best one is
+ * detected on first use otherwise. Not safe while other threads collide,
+ * select it before the first parallel step.
+ * Returns false when the CPU does not support it.
+ */
+int8_t EcsPhysis2d_setProjectionKernel(EcsProjectionKernel kernel);
+EcsProjectionKernel EcsPhysis2d_getProjectionKernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef PHYSICS_2D_PHYSICS_SOLVER_H
+#define PHYSICS_2D_PHYSICS_SOLVER_H
+
+#include <unistd.h>
+
+#include "physics_2d.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Velocity of a body
+ *  linear: Velocity of the position, units per second
+ *  angular: Radians per second, counter clockwise
+ */
+typedef struct EcsVelocity2D {
+    EcsVector2D linear;
+    float angular;
+} EcsVelocity2D;
+
+/**
+ * Mass of a body around its position, which is its center of mass.
+ * Static bodies have both inverses at 0.
+ */
+typedef struct EcsMass {
+    float inverse_mass;
+    float inverse_inertia;
+} EcsMass;
+
+/**
+ * Surface of a body, the values of a contact are the square root of the
+ * product of both frictions and the max of both restitutions.
+ */
+typedef struct EcsMaterial {
+    float friction;
+    float restitution;
+} EcsMaterial;
+
+/**
+ * Bodies of a step, index i of every array is the same body. The indices
+ * of the contact pairs are indices into these arrays.
+ *  rotations: Integrated with the angular velocity (Can be NULL, the bodies
+ *             then never rotate)
+ *  materials: (Can be NULL, EcsSolverSettings::material is used)
+ *  sleeping: True for bodies at rest, they are not integrated until a
+ *            contact with a moving body wakes their island. Clearing it
+ *            from outside wakes the body (Can be NULL, with sleep_times).
+ *            When it is EcsPhysicsWorld::sleeping, call
+ *            EcsPhysicsWorld_refreshSleeping after the step
+ *  sleep_times: Seconds each body has been below the sleep speeds, kept by
+ *               the solver (Can be NULL, bodies then never sleep)
+ */
+typedef struct EcsSolverBodies {
+    EcsVector2D *positions;
+    EcsRotation *rotations;
+    EcsVelocity2D *velocities;
+    EcsMass *masses;
+    EcsMaterial *materials;
+    int8_t *sleeping;
+    float *sleep_times;
+    int32_t count;
+} EcsSolverBodies;
+
+/**
+ * Solver settings, see EcsContactSolver_init for the defaults
+ *  gravity: Acceleration of the dynamic bodies
+ *  velocity_iterations: Sequential impulse iterations on the velocities
+ *  position_iterations: Split impulse iterations on the penetration
+ *  baumgarte: Part of the penetration corrected per step
+ *  slop: Penetration left uncorrected, keeps resting contacts touching
+ *  restitution_threshold: Approach speed below which contacts do not bounce
+ *  warm_starting: Start from the impulses of the same contacts on the last
+ *                 step
+ *  material: Material of the bodies when EcsSolverBodies::materials is NULL
+ *  sleep_linear_speed, sleep_angular_speed: Speeds below which a body is
+ *                                           at rest
+ *  sleep_time: Seconds every body of an island must be at rest before the
+ *              island sleeps
+ */
+typedef struct EcsSolverSettings {
+    EcsVector2D gravity;
+    int32_t velocity_iterations;
+    int32_t position_iterations;
+    float baumgarte;
+    float slop;
+    float restitution_threshold;
+    int8_t warm_starting;
+    EcsMaterial material;
+    float sleep_linear_speed;
+    float sleep_angular_speed;
+    float sleep_time;
+} EcsSolverSettings;
+
+/**
+ * Point of a contact constraint
+ *  anchor_a, anchor_b: Contact point relative to the position of each body
+ *  normal_mass, tangent_mass: Effective mass along the normal and tangent
+ *  normal_impulse, tangent_impulse: Accumulated impulses of the step
+ *  split_impulse: Accumulated position correction impulse
+ *  velocity_bias: Target normal speed for restitution
+ *  position_bias: Target normal pseudo speed for the penetration
+ */
+typedef struct EcsSolverContactPoint {
+    EcsVector2D anchor_a;
+    EcsVector2D anchor_b;
+    float normal_mass;
+    float tangent_mass;
+    float normal_impulse;
+    float tangent_impulse;
+    float split_impulse;
+    float velocity_bias;
+    float position_bias;
+    uint32_t id;
+} EcsSolverContactPoint;
+
+/**
+ * Contact constraint built from the manifold of a pair
+ */
+typedef struct EcsSolverContact {
+    int32_t a;
+    int32_t b;
+    EcsVector2D normal;
+    float friction;
+    float restitution;
+    int8_t points_count;
+    EcsSolverContactPoint points[2];
+} EcsSolverContact;
+
+/**
+ * Accumulated impulses of a pair at the end of a step, by feature id
+ *  a: -1 for empty slots
+ */
+typedef struct EcsSolverCacheEntry {
+    int32_t a;
+    int32_t b;
+    int8_t points_count;
+    uint32_t ids[2];
+    float normal_impulses[2];
+    float tangent_impulses[2];
+} EcsSolverCacheEntry;
+
+/**
+ * Sequential impulse contact solver
+ *
+ * Solves the manifolds of a step with friction and restitution and pushes
+ * the bodies apart with split impulses, which correct the positions without
+ * adding velocity. The impulses of every contact point are kept for the
+ * next step and matched by pair and feature id, contacts that persist start
+ * from them (warm starting) so resting stacks converge in a few iterations.
+ *  contacts: Constraints of the last step
+ *  cache, spare: Impulse table of the last step and the one being built,
+ *                open addressing
+ *  split_velocities: Position correction pseudo velocities, one per body
+ *  islands: Union-find parents of the bodies during a step
+ *  island_times: Smallest sleep time of each island, by root
+ *  sleep_links: Next body of the same sleeping island, a ring per island,
+ *               -1 for awake bodies
+ */
+typedef struct EcsContactSolver {
+    EcsSolverSettings settings;
+    EcsSolverContact *contacts;
+    int32_t count;
+    int32_t capacity;
+    EcsSolverCacheEntry *cache;
+    EcsSolverCacheEntry *spare;
+    int32_t cache_size;
+    int32_t spare_size;
+    EcsVelocity2D *split_velocities;
+    int32_t *islands;
+    float *island_times;
+    int32_t *sleep_links;
+    int32_t body_capacity;
+} EcsContactSolver;
+
+/**
+ * Sets the mass and inertia of a body, a mass of 0 makes it static.
+ */
+void EcsMass_set(EcsMass *mass_out, float mass, float inertia);
+
+/**
+ * Mass of a solid circle or polygon of the given density. Polygon points
+ * are relative to the center of mass.
+ */
+int8_t EcsMass_circle(EcsMass *mass_out, EcsCircleCollider *circle, float density);
+int8_t EcsMass_polygon(EcsMass *mass_out, EcsPolygonCollider *polygon, float density);
+
+/**
+ * Mass of a solid capsule, its segment is centered on the position.
+ * Boxes never take the rotation of their body, their inertia is 0 so the
+ * body does not rotate either.
+ */
+int8_t EcsMass_capsule(EcsMass *mass_out, EcsCapsuleCollider *capsule, float density);
+int8_t EcsMass_box(EcsMass *mass_out, EcsBoxCollider *box, float density);
+
+void EcsContactSolver_init(EcsContactSolver *solver);
+void EcsContactSolver_deinit(EcsContactSolver *solver);
+
+/**
+ * Advances the bodies by dt: applies gravity, solves the contacts of
+ * manifolds[0..contact_count) between the bodies of pairs[i], integrates
+ * the positions and rotations and corrects the penetration.
+ * With EcsSolverBodies::sleeping the bodies are grouped in islands of
+ * touching dynamic bodies, an island whose bodies all stay at rest for
+ * sleep_time goes to sleep and a contact with a moving body wakes it.
+ * Manifolds are the output of EcsPhysis2dCollisionManifold, with the normal
+ * from pairs[i].a to pairs[i].b.
+ * Returns false on invalid arguments or when the buffers can not grow, the
+ * bodies are not changed then.
+ */
+int8_t EcsContactSolver_step(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count,
+    float dt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef PHYSICS_2D_PHYSICS_SPATIAL_HASH_H
+#define PHYSICS_2D_PHYSICS_SPATIAL_HASH_H
+
+#include <unistd.h>
+
+#include "physics_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Slot of the open-addressing cell table
+ *  x, y: Cell coordinates
+ *  start: First entry of the cell in EcsSpatialHash::entries
+ *  count: Number of colliders in the cell
+ *  stamp: Slot is in use when it matches EcsSpatialHash::stamp
+ */
+typedef struct EcsSpatialHashCell {
+    int32_t x;
+    int32_t y;
+    int32_t start;
+    int32_t count;
+    uint32_t stamp;
+} EcsSpatialHashCell;
+
+/**
+ * Uniform grid broadphase with a hashed cell table
+ *
+ * Meant for many colliders of similar size, the cell size should be close to
+ * the size of the typical collider. The table and entry buffers are reused
+ * between updates and only grow, a steady scene does not allocate.
+ *
+ * ranges: Cells covered by every collider [min x, min y, max x, max y]
+ * large: Colliders covering too many cells, kept out of the grid and tested
+ *   against every other collider, their range is empty
+ */
+typedef struct EcsSpatialHash {
+    float cell_size;
+    EcsAABB *aabbs;
+    int32_t (*ranges)[4];
+    int32_t count;
+    int32_t capacity;
+    int32_t *large;
+    int32_t large_count;
+    EcsSpatialHashCell *table;
+    int32_t table_size;
+    int32_t *used;
+    int32_t used_count;
+    int32_t *entries;
+    int32_t entry_capacity;
+    uint32_t stamp;
+} EcsSpatialHash;
+
+void EcsSpatialHash_init(EcsSpatialHash *hash, float cell_size);
+void EcsSpatialHash_deinit(EcsSpatialHash *hash);
+
+/**
+ * Changes the cell size, takes effect on the next update.
+ */
+void EcsSpatialHash_setCellSize(EcsSpatialHash *hash, float cell_size);
+
+/**
+ * Rebuilds the grid for colliders[0..count).
+ * Returns false when out of memory or when the colliders cover more cells
+ * than the entry buffer can index.
+ */
+int8_t EcsSpatialHash_update(EcsSpatialHash *hash, EcsColliderData **colliders, int32_t count);
+
+/**
+ * Writes up to max_pairs unique candidate pairs whose AABBs overlap.
+ * A pair sharing several cells is only reported by the first shared cell.
+ * Returns the total number of candidate pairs.
+ */
+int32_t EcsSpatialHash_getPairs(EcsSpatialHash *hash, EcsColliderPair *pairs_out, int32_t max_pairs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
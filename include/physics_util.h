@@ -1,6 +1,7 @@
 #ifndef PHYSICS_2D_PHYSICS_UTIL_H
 #define PHYSICS_2D_PHYSICS_UTIL_H
 
+#include <stdint.h>
 #include <unistd.h>
 
 #ifdef __cplusplus
@@ -24,6 +25,23 @@ typedef float EcsVector2D[2];
 typedef float EcsAABB[4];
 
 typedef float EcsMatrix3x3[3][3];
+
+/**
+ * Rotation, as the cosine and sine of its angle
+ */
+typedef struct EcsRotation {
+    float c;
+    float s;
+} EcsRotation;
+#define EcsRotation_Identity() {1, 0}
+
+/**
+ * Rigid transform, rotation followed by a translation
+ */
+typedef struct EcsTransform {
+    EcsVector2D position;
+    EcsRotation rotation;
+} EcsTransform;
 #define EcsMatrix3x3_Identity() {{1,0,0},{0,1,0},{0,0,0}}
 
 /**
@@ -37,19 +55,84 @@ typedef struct EcsCollisionInfo {
 } EcsCollisionInfo;
 
 /**
- * Components needed to represent a collider
+ * Motion of a collider during a step, from the start to the end position.
+ * The rotation does not change during the sweep.
+ */
+typedef struct EcsSweep {
+    EcsVector2D start;
+    EcsVector2D end;
+} EcsSweep;
+
+/**
+ * Segment from origin to origin + translation
+ *  max_fraction: Part of the translation tested, hits beyond it are ignored
+ */
+typedef struct EcsRay {
+    EcsVector2D origin;
+    EcsVector2D translation;
+    float max_fraction;
+} EcsRay;
+
+/**
+ * Hit of a ray
+ *  fraction: The hit point is origin + translation * fraction
+ *  normal: Unit surface normal at the hit point
+ *  point: Hit point
+ *  ray: Index of the ray in batched queries
+ *  collider: Index of the collider in batched queries
+ */
+typedef struct EcsRaycastHit {
+    float fraction;
+    EcsVector2D normal;
+    EcsVector2D point;
+    int32_t ray;
+    int32_t collider;
+} EcsRaycastHit;
+
+/**
+ * Candidate pair of colliders, as indices into a collider array.
+ *  a < b
+ */
+typedef struct EcsColliderPair {
+    int32_t a;
+    int32_t b;
+} EcsColliderPair;
+
+/**
+ * Components needed to represent a collider, one shape is used in the order
+ * circle, polygon, capsule, box. Every slot is read, set the unused ones to
+ * NULL: initialize the data with {0} or a full initializer. Code written for
+ * the older three slot layout must clear slots [3] to [5].
  *  [0] : EcsVector2D
  *  [1] : EcsCircleCollider (Can be NULL)
  *  [2] : EcsPolygonCollider (Can be NULL)
+ *  [3] : EcsRotation (Can be NULL, no rotation)
+ *  [4] : EcsCapsuleCollider (Can be NULL)
+ *  [5] : EcsBoxCollider (Can be NULL)
  */
-typedef void* EcsColliderData[3];
+typedef void* EcsColliderData[6];
 #define EcsColliderData_Vector2(pColliderData) ((EcsVector2D*)((*pColliderData)[0]))
 #define EcsColliderData_Circle(pColliderData) ((EcsCircleCollider*)((*pColliderData)[1]))
 #define EcsColliderData_Polygon(pColliderData) ((EcsPolygonCollider*)((*pColliderData)[2]))
+#define EcsColliderData_Rotation(pColliderData) ((EcsRotation*)((*pColliderData)[3]))
+#define EcsColliderData_Capsule(pColliderData) ((EcsCapsuleCollider*)((*pColliderData)[4]))
+#define EcsColliderData_Box(pColliderData) ((EcsBoxCollider*)((*pColliderData)[5]))
 
 int8_t EcsColliderData_getAABB(EcsColliderData *collider, EcsAABB *aabb_out);
+
+/**
+ * AABB covering the collider along the whole sweep, for broadphases that
+ * must not miss the pairs of fast colliders.
+ */
+int8_t EcsColliderData_getSweptAABB(EcsColliderData *collider, EcsSweep *sweep, EcsAABB *aabb_out);
 int8_t EcsAABBTest(EcsAABB *a, EcsAABB *b);
 
+/**
+ * Slab test of the ray against aabb, fraction_out (Can be NULL) gets the
+ * fraction where the ray enters it, 0 when the origin is inside.
+ */
+int8_t EcsAABBRaycast(EcsAABB *aabb, EcsRay *ray, float *fraction_out);
+
 float EcsVector2D_get_angle(EcsVector2D *vector);
 float EcsVector2D_get_magnitude(EcsVector2D *vector);
 int8_t EcsVector2D_get_normal(EcsVector2D *vector, EcsVector2D *vector_out);
@@ -68,6 +151,23 @@ void EcsMatrix3x3_add_rotation(EcsMatrix3x3 *matrix, float rad);
 void EcsMatrix3x3_add_translation(EcsMatrix3x3 *matrix, EcsVector2D *translation);
 int8_t EcsMatrix3x3_transform(EcsMatrix3x3 *matrix, EcsVector2D *src, EcsVector2D *dest, size_t size);
 
+void EcsRotation_set(EcsRotation *rotation, float rad);
+int8_t EcsRotation_rotate(EcsRotation *rotation, EcsVector2D *vector, EcsVector2D *vector_out);
+int8_t EcsRotation_invRotate(EcsRotation *rotation, EcsVector2D *vector, EcsVector2D *vector_out);
+
+/**
+ * Writes transform applied to src[0..size) into dest, src and dest can be
+ * the same array.
+ */
+int8_t EcsTransform_apply(EcsTransform *transform, EcsVector2D *src, EcsVector2D *dest, size_t size);
+int8_t EcsTransform_invApply(EcsTransform *transform, EcsVector2D *point, EcsVector2D *point_out);
+
+/**
+ * Transform of b relative to a (inverse of a, then b). Moves points of b
+ * into the local frame of a.
+ */
+int8_t EcsTransform_relative(EcsTransform *a, EcsTransform *b, EcsTransform *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,244 @@
+#ifndef PHYSICS_2D_PHYSICS_WORLD_H
+#define PHYSICS_2D_PHYSICS_WORLD_H
+
+#include <unistd.h>
+
+#include "physics_2d.h"
+#include "physics_broadphase.h"
+#include "physics_parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Stable reference to a collider of a world
+ *  Low 32 bits: Slot, High 32 bits: Generation of the slot
+ */
+typedef uint64_t EcsColliderHandle;
+#define EcsColliderHandle_Null 0
+
+/**
+ * Collider container with structure-of-arrays storage
+ *
+ * Colliders are stored densely, index i of every array is the same collider.
+ * Removing a collider moves the last one into its place, handles stay valid.
+ * Polygon points and their baked normals, supports and facing edges live in shared
+ * contiguous pools, polygons[i] points into them.
+ *
+ *  positions: World position
+ *  rotations: Rotation around the position
+ *  circles: Circle shape (radius 0 for the other shapes)
+ *  polygons: Polygon shape (NULL points for the other shapes)
+ *  capsules, boxes: Capsule and box shapes, only set for their type
+ *  vertex_offsets: First vertex of every polygon in vertices / normals
+ *  local_aabbs: AABB of the shape around the position
+ *  aabbs: World AABB, refreshed by EcsPhysicsWorld_update. Rotated
+ *         polygons are transformed into the vertex cache for it, boxes
+ *         never rotate
+ *  types: Shape of the collider
+ *  sweeps, fast: Motion of the colliders flagged as fast, their AABBs cover
+ *                the whole sweep
+ *  sleeping: Colliders at rest, their AABBs are not refreshed and pairs of
+ *            two sleeping colliders are not reported. Static colliders
+ *            can be kept sleeping. Can be shared with
+ *            EcsSolverBodies::sleeping when body i is collider i, call
+ *            EcsPhysicsWorld_refreshSleeping after writing it directly
+ *  awake, awake_count: Dense indices of the colliders not sleeping, as of
+ *                      the last update, in no particular order
+ *  awake_mask: 1 for the colliders in awake, the pair search keeps to it
+ *              when sleeping changes before EcsPhysicsWorld_getPairs
+ *  awake_ranks: Position of every collider in awake, -1 when not in it
+ *  sleep_changes: Colliders whose sleeping flag changed since the last
+ *                 update, the update applies them to awake without looking
+ *                 at the other colliders
+ *  sleep_rescan: Set when sleep_changes is full or sleeping was written
+ *                directly, the next update rebuilds awake from sleeping
+ *  tree, proxies: AABB tree over aabbs, proxies[i] is the leaf of collider
+ *                 i. Region queries and the pairs of awake colliders go
+ *                 through it, so their cost does not depend on the size of
+ *                 the largest collider
+ *  views: EcsColliderData view of every collider, for the pair based APIs
+ *  sat_cache: Separating axes of the pairs collided on the last step, its
+ *             hits and misses count the polygon pair tests
+ *  thread_pool: Workers of EcsPhysicsWorld_collide, not started (serial)
+ *               until EcsPhysicsWorld_setThreadCount
+ */
+typedef struct EcsPhysicsWorld {
+    EcsVector2D *positions;
+    EcsRotation *rotations;
+    EcsCircleCollider *circles;
+    EcsPolygonCollider *polygons;
+    EcsCapsuleCollider *capsules;
+    EcsBoxCollider *boxes;
+    int32_t *vertex_offsets;
+    EcsAABB *local_aabbs;
+    EcsAABB *aabbs;
+    int8_t *types;
+    EcsSweep *sweeps;
+    int8_t *fast;
+    int8_t *sleeping;
+    int32_t *awake;
+    int8_t *awake_mask;
+    int32_t *awake_ranks;
+    int32_t awake_count;
+    int32_t *sleep_changes;
+    int32_t sleep_change_count;
+    int8_t sleep_rescan;
+    EcsColliderHandle *handles;
+    EcsColliderData *views;
+    EcsColliderData **view_ptrs;
+    int32_t *proxies;
+    int32_t count;
+    int32_t capacity;
+
+    EcsPoint *vertices;
+    EcsVector2D *normals;
+    EcsPolygonSupport *supports;
+    int32_t *facing;
+    int32_t vertex_count;
+    int32_t vertex_capacity;
+    int32_t vertex_garbage;
+
+    int32_t *slots;
+    uint32_t *generations;
+    int32_t slot_count;
+    int32_t slot_capacity;
+    int32_t free_slot;
+
+    EcsSweepAndPrune broadphase;
+    EcsAABBTree tree;
+    EcsVertexCache vertex_cache;
+    EcsSatCache sat_cache;
+    EcsPhysis2dContext context;
+    EcsThreadPool thread_pool;
+    int8_t views_dirty;
+    int8_t broadphase_dirty;
+} EcsPhysicsWorld;
+
+void EcsPhysicsWorld_init(EcsPhysicsWorld *world);
+void EcsPhysicsWorld_deinit(EcsPhysicsWorld *world);
+
+/**
+ * Copies the collider described by the view into the world.
+ * Returns EcsColliderHandle_Null on error.
+ */
+EcsColliderHandle EcsPhysicsWorld_add(EcsPhysicsWorld *world, EcsColliderData *collider);
+void EcsPhysicsWorld_remove(EcsPhysicsWorld *world, EcsColliderHandle handle);
+
+/**
+ * Dense index of a collider, -1 when the handle is not valid.
+ * Dense indices change when colliders are removed.
+ */
+int32_t EcsPhysicsWorld_getIndex(EcsPhysicsWorld *world, EcsColliderHandle handle);
+EcsColliderHandle EcsPhysicsWorld_getHandle(EcsPhysicsWorld *world, int32_t index);
+
+int8_t EcsPhysicsWorld_setPosition(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsVector2D *position);
+EcsVector2D* EcsPhysicsWorld_getPosition(EcsPhysicsWorld *world, EcsColliderHandle handle);
+
+/**
+ * Colliders added without a rotation start with the identity.
+ */
+int8_t EcsPhysicsWorld_setRotation(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsRotation *rotation);
+EcsRotation* EcsPhysicsWorld_getRotation(EcsPhysicsWorld *world, EcsColliderHandle handle);
+
+/**
+ * Flags the collider as fast with its motion for the next steps, NULL clears
+ * the flag. Only fast colliders pay for swept AABBs and time of impact.
+ */
+int8_t EcsPhysicsWorld_setSweep(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsSweep *sweep);
+
+/**
+ * Puts a collider to sleep or wakes it up. Setting the position, rotation
+ * or sweep of a collider wakes it, writing through the pointers returned by
+ * the getters does not.
+ */
+int8_t EcsPhysicsWorld_setSleeping(EcsPhysicsWorld *world, EcsColliderHandle handle, int8_t sleeping);
+int8_t EcsPhysicsWorld_isSleeping(EcsPhysicsWorld *world, EcsColliderHandle handle);
+
+/**
+ * Makes the next update read the sleeping flag of every collider, call it
+ * after writing EcsPhysicsWorld::sleeping without EcsPhysicsWorld_setSleeping,
+ * for example when it is shared with a solver.
+ */
+void EcsPhysicsWorld_refreshSleeping(EcsPhysicsWorld *world);
+
+/**
+ * Returns an EcsColliderData view of the collider, it can be used with
+ * EcsPhysis2dCollisionCheck until the world is modified.
+ */
+EcsColliderData* EcsPhysicsWorld_getView(EcsPhysicsWorld *world, EcsColliderHandle handle);
+
+/**
+ * Threads used by EcsPhysicsWorld_collide, including the calling one. 0 uses
+ * one per core, 1 (the default) tests every pair on the calling thread. The
+ * results do not depend on the thread count.
+ */
+void EcsPhysicsWorld_setThreadCount(EcsPhysicsWorld *world, int32_t thread_count);
+
+/**
+ * Narrowphase used by EcsPhysicsWorld_collide, EcsNarrowphaseSat by default.
+ */
+void EcsPhysicsWorld_setNarrowphase(EcsPhysicsWorld *world, EcsNarrowphase narrowphase);
+
+/**
+ * Starts a step: refreshes the world AABBs and the broadphase. While some
+ * colliders sleep only the awake ones are refreshed and moved in the
+ * broadphase.
+ */
+int8_t EcsPhysicsWorld_update(EcsPhysicsWorld *world);
+
+/**
+ * Candidate pairs of the last update, as dense indices. While some colliders
+ * sleep the pairs are searched from the awake colliders only.
+ * Returns the total number of pairs.
+ */
+int32_t EcsPhysicsWorld_getPairs(EcsPhysicsWorld *world, EcsColliderPair *pairs_out, int32_t max_pairs);
+
+/**
+ * Region queries over the AABBs of the last update. They write up to
+ * max_indices dense indices and return the total number of colliders found,
+ * which can be greater than max_indices. Nothing is allocated.
+ *  queryAABB: Colliders whose AABB overlaps aabb
+ *  queryPoint: Colliders containing point
+ *  queryCircle: Colliders overlapping the circle
+ */
+int32_t EcsPhysicsWorld_queryAABB(EcsPhysicsWorld *world, EcsAABB *aabb, int32_t *indices_out, int32_t max_indices);
+int32_t EcsPhysicsWorld_queryPoint(EcsPhysicsWorld *world, EcsVector2D *point, int32_t *indices_out, int32_t max_indices);
+int32_t EcsPhysicsWorld_queryCircle(
+    EcsPhysicsWorld *world,
+    EcsVector2D *center,
+    float radius,
+    int32_t *indices_out,
+    int32_t max_indices);
+
+/**
+ * Runs the narrowphase on pairs of dense indices, see
+ * EcsPhysis2dCollisionCheckBatch.
+ */
+int32_t EcsPhysicsWorld_collide(
+    EcsPhysicsWorld *world,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out);
+
+/**
+ * Time of impact of the pairs of dense indices with a fast collider, see
+ * EcsPhysis2dTimeOfImpact. Pairs without one are skipped.
+ *  toi_out: Time of impact of every hit (pair_count entries max)
+ *  hits_out: Index in pairs of every hit (Can be NULL)
+ * Returns the number of hits.
+ */
+int32_t EcsPhysicsWorld_timeOfImpact(
+    EcsPhysicsWorld *world,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsToiInfo *toi_out,
+    int32_t *hits_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,51 +1,102 @@
 #include "include/physics_2d.h"
 #include "include/physics_util.h"
+#include "include/physics_simd.h"
 #include "private.h"
 #include <math.h>
+#include <stdlib.h>
 
 #define AXIS_MIN(minMax) ((minMax)[0])
 #define AXIS_MAX(minMax) ((minMax)[1])
+#define BATCH_SIZE 256
+
+// Specializes the fixed size paths, the vertex count becomes a constant and
+// the loops over it are unrolled
+#define FIXED_SIZE inline __attribute__((always_inline))
 
 static int8_t EcsPhysis2dCollisionCheckCircleCircle(
     ColliderData_t *circle_a, 
     ColliderData_t *circle_b, 
     EcsCollisionInfo *collision_out);
 static int8_t EcsPhysis2dCollisionCheckPolygonSat(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a, 
+    ColliderData_t *polygon_b, 
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dCollisionCheckPolygonSatVertices(
+    EcsPhysis2dContext *ctx,
     ColliderData_t *polygon_a, 
     ColliderData_t *polygon_b, 
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
     EcsCollisionInfo *collision_out);
-static int8_t EcsPhysis2dCollisionCheckCirclePolygonSat(
+static int8_t EcsPhysis2dCollisionCheckCirclePolygon(
     ColliderData_t *circle, 
     ColliderData_t *polygon, 
     int8_t invert,
     EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dCollisionCheckCirclePolygonVertices(
+    EcsVector2D *center, float radius,
+    PolygonVertices_t *vertices_a, 
+    int8_t invert,
+    EcsCollisionInfo *collision_out);
+static FIXED_SIZE int8_t EcsPhysis2dCollisionCheckCirclePolygonEdges(
+    EcsVector2D *center, float radius,
+    PolygonVertices_t *vertices_a, int32_t size_a,
+    int8_t invert,
+    EcsCollisionInfo *collision_out);
 static float EcsPhysis2dCollisionCheckPolygonSatAxis(
-    EcsPoint *vertices_a, int8_t size_a, 
-    EcsPoint *vertices_b, int8_t size_b, 
-    EcsCollisionInfo *collision_out, int8_t invert);
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out);
+static FIXED_SIZE float EcsPhysis2dCollisionCheckPolygonSatEdges(
+    PolygonVertices_t *vertices_a, int32_t size_a,
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out);
+static float EcsPhysis2dCollisionCheckBoxSatAxis(
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out);
+static float EcsPhysis2dCollisionCheckFacingSatAxis(
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out);
+static int8_t EcsPhysis2dCollisionCheckCachedAxis(
+    EcsSatCacheEntry *entry,
+    int8_t swapped,
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b);
 static void EcsPhysis2dCollisionCheckAxisSat(
     EcsVector2D *axis, 
     EcsVector2D *minMaxA,
     EcsVector2D *minMaxB,
     EcsCollisionInfo *collision_out);
-static void EcsPhysis2d_getProjection(
+static FIXED_SIZE void EcsPhysis2d_projectPoints(
     EcsVector2D *axis, 
-    EcsPoint *vertices, int8_t size, 
+    EcsPoint *points, int32_t size,
     EcsVector2D *out);
-static void EcsPhysis2d_getProjectionCircle(
-    EcsVector2D *axis,
-    EcsVector2D *center, float radius,
+static int8_t EcsPhysis2d_getShape(EcsPolygonCollider *polygon);
+static void EcsPhysis2d_getEdgeNormal(
+    PolygonVertices_t *vertices,
+    int32_t edge,
     EcsVector2D *out);
-static void EcsPhysis2d_getClosestPoint(
-    EcsVector2D *position, 
-    EcsPoint *vertices, int8_t size,
-    EcsVector2D *out
-);
 
 int8_t EcsPhysis2dCollisionCheck(
     EcsColliderData *collider_a, 
     EcsColliderData *collider_b, 
     EcsCollisionInfo *collision_out)
+{
+    return EcsPhysis2dCollisionCheckWithContext(NULL, collider_a, collider_b, collision_out);
+}
+
+int8_t EcsPhysis2dCollisionCheckWithContext(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a, 
+    EcsColliderData *collider_b, 
+    EcsCollisionInfo *collision_out)
 {
     if (collider_a == NULL || collider_b == NULL || GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL) {
         return false;
@@ -56,21 +107,127 @@ int8_t EcsPhysis2dCollisionCheck(
     
     if (type_a == ERR || type_b == ERR) {
         return false;
+    } else if (ctx != NULL && ctx->narrowphase == EcsNarrowphaseGjk) {
+        int8_t result = EcsPhysis2dGjk_collide(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), collision_out);
+        STATS_ADD(pair_tests[STATS_PAIR(type_a, type_b)], 1);
+        STATS_ADD(pair_hits[STATS_PAIR(type_a, type_b)], result);
+        return result;
+    } else if (IS_PRIMITIVE(type_a) || IS_PRIMITIVE(type_b)) {
+        return EcsPhysis2dPrimitive_collide(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), collision_out);
     } else if (type_a == type_b) {
         if (type_a == CIRCLE) {
             return EcsPhysis2dCollisionCheckCircleCircle((ColliderData_t*)collider_a, (ColliderData_t*)collider_b, collision_out);
         } else if (type_b == POLYGON) {
-            return EcsPhysis2dCollisionCheckPolygonSat((ColliderData_t*)collider_a, (ColliderData_t*)collider_b, collision_out);
+            return EcsPhysis2dCollisionCheckPolygonSat(ctx, (ColliderData_t*)collider_a, (ColliderData_t*)collider_b, collision_out);
         }
     } else {
         if (type_a == CIRCLE) {
-            return EcsPhysis2dCollisionCheckCirclePolygonSat((ColliderData_t*)collider_a, (ColliderData_t*)collider_b, true, collision_out);
+            return EcsPhysis2dCollisionCheckCirclePolygon((ColliderData_t*)collider_a, (ColliderData_t*)collider_b, true, collision_out);
         } 
-        return EcsPhysis2dCollisionCheckCirclePolygonSat((ColliderData_t*)collider_b, (ColliderData_t*)collider_a, false, collision_out);
+        return EcsPhysis2dCollisionCheckCirclePolygon((ColliderData_t*)collider_b, (ColliderData_t*)collider_a, false, collision_out);
     }
     return false;
 }
 
+int32_t EcsPhysis2dCollisionCheckBatch(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out)
+{
+    if (colliders == NULL || pairs == NULL || collisions_out == NULL) {
+        return 0;
+    }
+
+    // Chunk local buckets, indices into the chunk
+    int16_t circle_circle[BATCH_SIZE];
+    int16_t circle_polygon[BATCH_SIZE];
+    int16_t polygon_polygon[BATCH_SIZE];
+    int16_t primitive[BATCH_SIZE];
+    ColliderData_t *first[BATCH_SIZE];
+    ColliderData_t *second[BATCH_SIZE];
+    int8_t invert[BATCH_SIZE];
+    int8_t hit[BATCH_SIZE];
+    EcsCollisionInfo info[BATCH_SIZE];
+    int32_t hits = 0;
+    int8_t gjk = ctx != NULL && ctx->narrowphase == EcsNarrowphaseGjk;
+    STATS_BEGIN(timer);
+
+    for (int32_t base = 0; base < pair_count; base += BATCH_SIZE) {
+        int32_t size = (pair_count - base) < BATCH_SIZE ? (pair_count - base) : BATCH_SIZE;
+        int32_t cc_count = 0, cp_count = 0, pp_count = 0, primitive_count = 0;
+
+        for (int32_t i = 0; i < size; i++) {
+            EcsColliderData *collider_a = colliders[pairs[base + i].a];
+            EcsColliderData *collider_b = colliders[pairs[base + i].b];
+            hit[i] = false;
+            if (collider_a == NULL || collider_b == NULL || GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL) {
+                continue;
+            }
+            int8_t type_a = GET_COLLIDER_TYPE(collider_a);
+            int8_t type_b = GET_COLLIDER_TYPE(collider_b);
+            if (type_a == ERR || type_b == ERR) {
+                continue;
+            }
+            if (gjk) {
+                hit[i] = EcsPhysis2dGjk_collide(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), &info[i]);
+                STATS_ADD(pair_tests[STATS_PAIR(type_a, type_b)], 1);
+                STATS_ADD(pair_hits[STATS_PAIR(type_a, type_b)], hit[i]);
+            } else if (IS_PRIMITIVE(type_a) || IS_PRIMITIVE(type_b)) {
+                first[i] = COLLIDER_DATA(collider_a);
+                second[i] = COLLIDER_DATA(collider_b);
+                primitive[primitive_count++] = i;
+            } else if (type_a == type_b) {
+                first[i] = COLLIDER_DATA(collider_a);
+                second[i] = COLLIDER_DATA(collider_b);
+                if (type_a == CIRCLE) {
+                    circle_circle[cc_count++] = i;
+                } else {
+                    polygon_polygon[pp_count++] = i;
+                }
+            } else {
+                // Circle always goes first, invert keeps the direction relative to a
+                invert[i] = type_a == CIRCLE;
+                first[i] = COLLIDER_DATA(invert[i] ? collider_a : collider_b);
+                second[i] = COLLIDER_DATA(invert[i] ? collider_b : collider_a);
+                circle_polygon[cp_count++] = i;
+            }
+        }
+
+        for (int32_t i = 0; i < cc_count; i++) {
+            int16_t index = circle_circle[i];
+            hit[index] = EcsPhysis2dCollisionCheckCircleCircle(first[index], second[index], &info[index]);
+        }
+        for (int32_t i = 0; i < cp_count; i++) {
+            int16_t index = circle_polygon[i];
+            hit[index] = EcsPhysis2dCollisionCheckCirclePolygon(first[index], second[index], invert[index], &info[index]);
+        }
+        for (int32_t i = 0; i < pp_count; i++) {
+            int16_t index = polygon_polygon[i];
+            hit[index] = EcsPhysis2dCollisionCheckPolygonSat(ctx, first[index], second[index], &info[index]);
+        }
+        for (int32_t i = 0; i < primitive_count; i++) {
+            int16_t index = primitive[i];
+            hit[index] = EcsPhysis2dPrimitive_collide(ctx, first[index], second[index], &info[index]);
+        }
+
+        for (int32_t i = 0; i < size; i++) {
+            if (!hit[i]) {
+                continue;
+            }
+            collisions_out[hits] = info[i];
+            if (hits_out != NULL) {
+                hits_out[hits] = base + i;
+            }
+            hits++;
+        }
+    }
+    STATS_END(EcsStatsStageNarrowphase, timer);
+    return hits;
+}
+
 static int8_t EcsPhysis2dCollisionCheckCircleCircle(
     ColliderData_t *circle_a, 
     ColliderData_t *circle_b, 
@@ -78,9 +235,12 @@ static int8_t EcsPhysis2dCollisionCheckCircleCircle(
 {   
     float totalRadius = circle_a->circle->radius + circle_b->circle->radius;
     float distSqrt = EcsVector2D_distanceSqrt(circle_a->position, circle_b->position);
+    STATS_ADD(pair_tests[EcsStatsPairCircleCircle], 1);
     if (distSqrt > totalRadius*totalRadius) {
+        STATS_ADD(early_outs[EcsStatsPairCircleCircle], 1);
         return false;
     }
+    STATS_ADD(pair_hits[EcsStatsPairCircleCircle], 1);
     EcsVector2D_sub(circle_b->position, circle_a->position, &(collision_out->direction));
     EcsVector2D_normalize(&(collision_out->direction), &(collision_out->direction));
     collision_out->distance = sqrtf(distSqrt)-totalRadius;
@@ -88,114 +248,361 @@ static int8_t EcsPhysis2dCollisionCheckCircleCircle(
 }
 
 static int8_t EcsPhysis2dCollisionCheckPolygonSat(
+    EcsPhysis2dContext *ctx,
     ColliderData_t *polygon_a, 
     ColliderData_t *polygon_b, 
     EcsCollisionInfo *collision_out) 
 {
-    EcsPoint vertices_a[128];
-    EcsPoint vertices_b[128];
-    EcsMatrix3x3 transfor = {{1,0, VECTOR_X(polygon_a->position)}, {0,1, VECTOR_Y(polygon_a->position)}, {0,0,1}};
-    
-    EcsMatrix3x3_transform(&transfor, polygon_a->polygon->points, vertices_a, polygon_a->polygon->points_count);
-    transfor[0][2] = VECTOR_X(polygon_b->position);
-    transfor[1][2] = VECTOR_Y(polygon_b->position);
-    EcsMatrix3x3_transform(&transfor, polygon_b->polygon->points, vertices_b, polygon_b->polygon->points_count);
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    PolygonVertices_t vertices_a;
+    PolygonVertices_t vertices_b;
+    EcsTransform frame;
+    if (!EcsPhysis2d_getPairVertices(ctx, polygon_a, polygon_b, buffer_a, soa_a, buffer_b, soa_b, &vertices_a, &vertices_b, &frame)) {
+        return false;
+    }
+    int8_t result = EcsPhysis2dCollisionCheckPolygonSatVertices(ctx, polygon_a, polygon_b, &vertices_a, &vertices_b, collision_out);
+    STATS_ADD(pair_tests[EcsStatsPairPolygonPolygon], 1);
+    STATS_ADD(pair_hits[EcsStatsPairPolygonPolygon], result);
+    if (result) {
+        EcsRotation_rotate(&frame.rotation, &collision_out->direction, &collision_out->direction);
+    }
+    EcsPhysis2d_releaseWorldVertices(&vertices_a);
+    EcsPhysis2d_releaseWorldVertices(&vertices_b);
+    return result;
+}
 
+static int8_t EcsPhysis2dCollisionCheckPolygonSatVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a, 
+    ColliderData_t *polygon_b, 
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out)
+{
+    EcsSatCacheEntry *cached = NULL;
+    int8_t swapped = false;
+    if (ctx != NULL && ctx->sat_cache != NULL) {
+        cached = EcsSatCache_getEntry(ctx->sat_cache, polygon_a, polygon_b, &swapped);
+        if (cached != NULL && EcsPhysis2dCollisionCheckCachedAxis(cached, swapped, vertices_a, vertices_b)) {
+            ctx->sat_cache->hits++;
+            STATS_ADD(early_outs[EcsStatsPairPolygonPolygon], 1);
+            return false;
+        }
+        ctx->sat_cache->misses++;
+    }
+
+    int32_t edge;
     collision_out->distance = INFINITY;
-    if (EcsPhysis2dCollisionCheckPolygonSatAxis(vertices_a, polygon_a->polygon->points_count,
-                                                vertices_b, polygon_b->polygon->points_count, 
-                                                collision_out, false) == INFINITY) {
+    if (EcsPhysis2dCollisionCheckPolygonSatAxis(vertices_a, vertices_b, collision_out, false, &edge) == INFINITY) {
+        if (cached != NULL) {
+            cached->owner = swapped;
+            cached->edge = edge;
+        }
         return false;
     }
-    if (EcsPhysis2dCollisionCheckPolygonSatAxis(vertices_b, polygon_b->polygon->points_count,
-                                                vertices_a, polygon_a->polygon->points_count, 
-                                                collision_out, true) == INFINITY) {
+    if (EcsPhysis2dCollisionCheckPolygonSatAxis(vertices_b, vertices_a, collision_out, true, &edge) == INFINITY) {
+        if (cached != NULL) {
+            cached->owner = !swapped;
+            cached->edge = edge;
+        }
         return false;
     }
+    if (cached != NULL) {
+        cached->owner = -1;
+    }
     return true;
 }
 
-static int8_t EcsPhysis2dCollisionCheckCirclePolygonSat(
-    ColliderData_t *circle, 
-    ColliderData_t *polygon, 
-    int8_t invert,
-    EcsCollisionInfo *collision_out) 
+/*
+ * True when the axis cached for the pair still separates it, swapped when
+ * vertices_a belong to b of the entry.
+ */
+static int8_t EcsPhysis2dCollisionCheckCachedAxis(
+    EcsSatCacheEntry *entry,
+    int8_t swapped,
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b)
 {
-    EcsPoint vertices_a[128];
-    int8_t size_a = polygon->polygon->points_count;
-    EcsMatrix3x3 transfor = {{1,0, VECTOR_X(polygon->position)}, {0,1, VECTOR_Y(polygon->position)}, {0,0,1}};
-    EcsMatrix3x3_transform(&transfor, polygon->polygon->points, vertices_a, size_a); 
-
+    if (entry->owner < 0) {
+        return false;
+    }
+    PolygonVertices_t *owner = entry->owner == swapped ? vertices_a : vertices_b;
+    if (entry->edge >= owner->size) {
+        return false;
+    }
     EcsVector2D axis;
-    EcsVector2D closestPoint;
     EcsVector2D minMaxA;
     EcsVector2D minMaxB;
+    EcsPhysis2d_getEdgeNormal(owner, entry->edge, &axis);
+    EcsPhysis2d_getProjection(&axis, vertices_a, &minMaxA);
+    EcsPhysis2d_getProjection(&axis, vertices_b, &minMaxB);
+    STATS_ADD(axes_projected, 1);
+    return AXIS_MAX(minMaxA) < AXIS_MIN(minMaxB) || AXIS_MAX(minMaxB) < AXIS_MIN(minMaxA);
+}
 
-    EcsPhysis2d_getClosestPoint(circle->position, vertices_a, size_a, &closestPoint);
-    EcsVector2D_sub(circle->position, &closestPoint, &axis);
-    EcsVector2D_normalize(&axis, &axis);
-
-    EcsPhysis2d_getProjection(&axis, vertices_a, size_a, &minMaxA);
-    EcsPhysis2d_getProjectionCircle(&axis, circle->position, circle->circle->radius, &minMaxB);
-
-    //max0 < min1 || max1 < min0 
-    if (AXIS_MAX(minMaxA) < AXIS_MIN(minMaxB) || AXIS_MAX(minMaxB) < AXIS_MIN(minMaxA)) {
+/*
+ * Tested in the local frame of the polygon, only the circle center is
+ * transformed.
+ */
+static int8_t EcsPhysis2dCollisionCheckCirclePolygon(
+    ColliderData_t *circle, 
+    ColliderData_t *polygon, 
+    int8_t invert,
+    EcsCollisionInfo *collision_out) 
+{
+    PolygonVertices_t vertices_a;
+    EcsTransform transform;
+    EcsVector2D center;
+    if (!EcsPhysis2d_getFrameVertices(polygon, NULL, NULL, NULL, &vertices_a)) {
         return false;
     }
-    collision_out->distance = INFINITY;
-    EcsPhysis2dCollisionCheckAxisSat(&axis, &minMaxA, &minMaxB, collision_out);
+    EcsPhysis2d_getTransform(polygon, &transform);
+    EcsTransform_invApply(&transform, circle->position, &center);
+    int8_t result = EcsPhysis2dCollisionCheckCirclePolygonVertices(&center, circle->circle->radius, &vertices_a, invert, collision_out);
+    STATS_ADD(pair_tests[EcsStatsPairCirclePolygon], 1);
+    STATS_ADD(pair_hits[EcsStatsPairCirclePolygon], result);
+    if (result) {
+        EcsRotation_rotate(&transform.rotation, &collision_out->direction, &collision_out->direction);
+    }
+    return result;
+}
 
-    for (int8_t i = 0; i < size_a; i++){
-        EcsVector2D_sub(&vertices_a[(i+1) < size_a ? (i+1) : 0], &vertices_a[i], &axis);
-        EcsVector2D_get_normal(&axis, &axis);
-        EcsVector2D_normalize(&axis, &axis);
-        
-        EcsPhysis2d_getProjection(&axis, vertices_a, size_a, &minMaxA);
-        EcsPhysis2d_getProjectionCircle(&axis, circle->position, circle->circle->radius, &minMaxB);
-    
-        //max0 < min1 || max1 < min0 
-        if (AXIS_MAX(minMaxA) < AXIS_MIN(minMaxB) || AXIS_MAX(minMaxB) < AXIS_MIN(minMaxA)) {
+static int8_t EcsPhysis2dCollisionCheckCirclePolygonVertices(
+    EcsVector2D *center, float radius,
+    PolygonVertices_t *vertices_a, 
+    int8_t invert,
+    EcsCollisionInfo *collision_out)
+{
+    if (vertices_a->shape == EcsPolygonShapeBox) {
+        return EcsPhysis2dCollisionCheckCirclePolygonEdges(center, radius, vertices_a, 4, invert, collision_out);
+    }
+    if (vertices_a->shape == EcsPolygonShapeTriangle) {
+        return EcsPhysis2dCollisionCheckCirclePolygonEdges(center, radius, vertices_a, 3, invert, collision_out);
+    }
+    return EcsPhysis2dCollisionCheckCirclePolygonEdges(center, radius, vertices_a, vertices_a->size, invert, collision_out);
+}
+
+/*
+ * Finds the edge of greatest separation from the circle center, then the
+ * Voronoi region of the center: inside the polygon or in front of the edge
+ * the edge normal separates them, past either end of the edge the axis goes
+ * from that vertex to the center.
+ */
+static FIXED_SIZE int8_t EcsPhysis2dCollisionCheckCirclePolygonEdges(
+    EcsVector2D *center, float radius,
+    PolygonVertices_t *vertices_a, int32_t size_a,
+    int8_t invert,
+    EcsCollisionInfo *collision_out)
+{
+    EcsPoint *points = vertices_a->points;
+    float winding = EcsPhysis2d_getWinding(vertices_a);
+
+    EcsVector2D normal;
+    EcsVector2D offset;
+    int32_t edge = 0;
+    float separation = -INFINITY;
+    for (int32_t i = 0; i < size_a; i++) {
+        EcsPhysis2d_getOutwardNormal(vertices_a, winding, i, &normal);
+        EcsVector2D_sub(center, &points[i], &offset);
+        float s = EcsVector2D_dot(&normal, &offset);
+        if (s > radius) {
+            STATS_ADD(axes_projected, i + 1);
+            STATS_ADD(early_outs[EcsStatsPairCirclePolygon], 1);
             return false;
         }
-
-        EcsPhysis2dCollisionCheckAxisSat(&axis, &minMaxA, &minMaxB, collision_out);
+        if (s > separation) {
+            separation = s;
+            edge = i;
+        }
     }
 
-    if (invert) {
-        EcsVector2D_scale(&(collision_out->direction), -1, &(collision_out->direction));
+    STATS_ADD(axes_projected, size_a);
+
+    EcsPoint *v1 = &points[edge];
+    EcsPoint *v2 = &points[(edge+1) < size_a ? (edge+1) : 0];
+    EcsVector2D edge_dir;
+    EcsVector2D_sub(v2, v1, &edge_dir);
+    EcsPhysis2d_getOutwardNormal(vertices_a, winding, edge, &normal);
+    float depth = radius - separation;
+
+    if (separation > 0) {
+        EcsPoint *vertex = NULL;
+        EcsVector2D_sub(center, v1, &offset);
+        if (EcsVector2D_dot(&offset, &edge_dir) <= 0) {
+            vertex = v1;
+        } else {
+            EcsVector2D_sub(center, v2, &offset);
+            if (EcsVector2D_dot(&offset, &edge_dir) >= 0) {
+                vertex = v2;
+            }
+        }
+        if (vertex != NULL) {
+            float distSqrt = EcsVector2D_dot(&offset, &offset);
+            if (distSqrt > radius*radius) {
+                return false;
+            }
+            float dist = sqrtf(distSqrt);
+            if (dist > 0) {
+                EcsVector2D_scale(&offset, 1.0f / dist, &normal);
+            }
+            depth = radius - dist;
+        }
     }
 
+    // normal points from the polygon to the circle, direction moves the polygon
+    collision_out->distance = depth;
+    EcsVector2D_scale(&normal, invert ? 1 : -1, &(collision_out->direction));
     return true;
 }
 
 static float EcsPhysis2dCollisionCheckPolygonSatAxis(
-    EcsPoint *vertices_a, int8_t size_a, 
-    EcsPoint *vertices_b, int8_t size_b, 
-    EcsCollisionInfo *collision_out, int8_t invert)
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out)
+{
+    if (vertices_a->shape == EcsPolygonShapeBox) {
+        return EcsPhysis2dCollisionCheckBoxSatAxis(vertices_a, vertices_b, collision_out, invert, separating_edge_out);
+    }
+    if (vertices_a->shape == EcsPolygonShapeTriangle) {
+        return EcsPhysis2dCollisionCheckPolygonSatEdges(vertices_a, 3, vertices_b, collision_out, invert, separating_edge_out);
+    }
+    if (vertices_a->facing != NULL && vertices_a->size <= VERTEX_BUFFER_SIZE) {
+        return EcsPhysis2dCollisionCheckFacingSatAxis(vertices_a, vertices_b, collision_out, invert, separating_edge_out);
+    }
+    return EcsPhysis2dCollisionCheckPolygonSatEdges(vertices_a, vertices_a->size, vertices_b, collision_out, invert, separating_edge_out);
+}
+
+static FIXED_SIZE float EcsPhysis2dCollisionCheckPolygonSatEdges(
+    PolygonVertices_t *vertices_a, int32_t size_a,
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out)
 {
     EcsVector2D axis;
     EcsVector2D minMaxA;
     EcsVector2D minMaxB;
 
-    for (int8_t i = 0; i < size_a; i++){
-        EcsVector2D_sub(&vertices_a[(i+1) < size_a ? (i+1) : 0], &vertices_a[i], &axis);
-        EcsVector2D_get_normal(&axis, &axis);
-        EcsVector2D_normalize(&axis, &axis);
+    for (int32_t i = 0; i < size_a; i++){
+        EcsPhysis2d_getEdgeNormal(vertices_a, i, &axis);
         if (invert) {
-            EcsPhysis2d_getProjection(&axis, vertices_a, size_a, &minMaxB);
-            EcsPhysis2d_getProjection(&axis, vertices_b, size_b, &minMaxA);
+            EcsPhysis2d_getProjection(&axis, vertices_a, &minMaxB);
+            EcsPhysis2d_getProjection(&axis, vertices_b, &minMaxA);
         } else {
-            EcsPhysis2d_getProjection(&axis, vertices_a, size_a, &minMaxA);
-            EcsPhysis2d_getProjection(&axis, vertices_b, size_b, &minMaxB);
+            EcsPhysis2d_getProjection(&axis, vertices_a, &minMaxA);
+            EcsPhysis2d_getProjection(&axis, vertices_b, &minMaxB);
         }
         
         //max0 < min1 || max1 < min0 
         if (AXIS_MAX(minMaxA) < AXIS_MIN(minMaxB) || AXIS_MAX(minMaxB) < AXIS_MIN(minMaxA)) {
+            STATS_ADD(axes_projected, i + 1);
+            *separating_edge_out = i;
             return INFINITY;
         }
 
         EcsPhysis2dCollisionCheckAxisSat(&axis, &minMaxA, &minMaxB, collision_out);
     }
+    STATS_ADD(axes_projected, size_a);
+    return collision_out->distance;
+}
+
+/*
+ * Edges 2 and 3 of a box have the opposite normals of edges 0 and 1, their
+ * projections are the negated projections of the first two and cannot
+ * separate the pair on their own. They are still scored, in the same order
+ * as the generic loop, so both paths find the same axis.
+ */
+static float EcsPhysis2dCollisionCheckBoxSatAxis(
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out)
+{
+    EcsVector2D axes[2];
+    EcsVector2D minMaxA[2];
+    EcsVector2D minMaxB[2];
+    EcsVector2D axis;
+
+    for (int32_t i = 0; i < 2; i++) {
+        EcsPhysis2d_getEdgeNormal(vertices_a, i, &axes[i]);
+        if (invert) {
+            EcsPhysis2d_getProjection(&axes[i], vertices_a, &minMaxB[i]);
+            EcsPhysis2d_getProjection(&axes[i], vertices_b, &minMaxA[i]);
+        } else {
+            EcsPhysis2d_getProjection(&axes[i], vertices_a, &minMaxA[i]);
+            EcsPhysis2d_getProjection(&axes[i], vertices_b, &minMaxB[i]);
+        }
+        if (AXIS_MAX(minMaxA[i]) < AXIS_MIN(minMaxB[i]) || AXIS_MAX(minMaxB[i]) < AXIS_MIN(minMaxA[i])) {
+            STATS_ADD(axes_projected, i + 1);
+            *separating_edge_out = i;
+            return INFINITY;
+        }
+        VECTOR_X(&axis) = VECTOR_X(&axes[i]);
+        VECTOR_Y(&axis) = VECTOR_Y(&axes[i]);
+        EcsPhysis2dCollisionCheckAxisSat(&axis, &minMaxA[i], &minMaxB[i], collision_out);
+    }
+    for (int32_t i = 0; i < 2; i++) {
+        EcsVector2D flippedA = {-AXIS_MAX(minMaxA[i]), -AXIS_MIN(minMaxA[i])};
+        EcsVector2D flippedB = {-AXIS_MAX(minMaxB[i]), -AXIS_MIN(minMaxB[i])};
+        VECTOR_X(&axis) = -VECTOR_X(&axes[i]);
+        VECTOR_Y(&axis) = -VECTOR_Y(&axes[i]);
+        EcsPhysis2dCollisionCheckAxisSat(&axis, &flippedA, &flippedB, collision_out);
+    }
+    STATS_ADD(axes_projected, 2);
+    return collision_out->distance;
+}
+
+/*
+ * Same as the generic loop for polygons with edges facing each other, an
+ * edge facing an earlier one reuses its axis and projections negated, it
+ * cannot separate the pair when the earlier edge did not.
+ */
+static float EcsPhysis2dCollisionCheckFacingSatAxis(
+    PolygonVertices_t *vertices_a, 
+    PolygonVertices_t *vertices_b, 
+    EcsCollisionInfo *collision_out, int8_t invert,
+    int32_t *separating_edge_out)
+{
+    EcsVector2D axes[VERTEX_BUFFER_SIZE];
+    EcsVector2D minMaxA[VERTEX_BUFFER_SIZE];
+    EcsVector2D minMaxB[VERTEX_BUFFER_SIZE];
+    EcsVector2D axis;
+    int32_t *facing = vertices_a->facing;
+    int32_t projected = 0;
+
+    for (int32_t i = 0; i < vertices_a->size; i++) {
+        int32_t j = facing[i];
+        if (j >= 0) {
+            VECTOR_X(&axes[i]) = -VECTOR_X(&axes[j]);
+            VECTOR_Y(&axes[i]) = -VECTOR_Y(&axes[j]);
+            AXIS_MIN(minMaxA[i]) = -AXIS_MAX(minMaxA[j]);
+            AXIS_MAX(minMaxA[i]) = -AXIS_MIN(minMaxA[j]);
+            AXIS_MIN(minMaxB[i]) = -AXIS_MAX(minMaxB[j]);
+            AXIS_MAX(minMaxB[i]) = -AXIS_MIN(minMaxB[j]);
+        } else {
+            EcsPhysis2d_getEdgeNormal(vertices_a, i, &axes[i]);
+            if (invert) {
+                EcsPhysis2d_getProjection(&axes[i], vertices_a, &minMaxB[i]);
+                EcsPhysis2d_getProjection(&axes[i], vertices_b, &minMaxA[i]);
+            } else {
+                EcsPhysis2d_getProjection(&axes[i], vertices_a, &minMaxA[i]);
+                EcsPhysis2d_getProjection(&axes[i], vertices_b, &minMaxB[i]);
+            }
+            projected++;
+            if (AXIS_MAX(minMaxA[i]) < AXIS_MIN(minMaxB[i]) || AXIS_MAX(minMaxB[i]) < AXIS_MIN(minMaxA[i])) {
+                STATS_ADD(axes_projected, projected);
+                *separating_edge_out = i;
+                return INFINITY;
+            }
+        }
+        VECTOR_X(&axis) = VECTOR_X(&axes[i]);
+        VECTOR_Y(&axis) = VECTOR_Y(&axes[i]);
+        EcsPhysis2dCollisionCheckAxisSat(&axis, &minMaxA[i], &minMaxB[i], collision_out);
+    }
+    STATS_ADD(axes_projected, projected);
     return collision_out->distance;
 }
 
@@ -227,15 +634,43 @@ static void EcsPhysis2dCollisionCheckAxisSat(
     }
 }
 
-static void EcsPhysis2d_getProjection(
+void EcsPhysis2d_getProjection(
     EcsVector2D *axis, 
-    EcsPoint *vertices, int8_t size, 
+    PolygonVertices_t *vertices, 
     EcsVector2D *out) 
 {
-    float min = EcsVector2D_dot(axis, &vertices[0]);
+    if (vertices->shape == EcsPolygonShapeBox) {
+        EcsPhysis2d_projectPoints(axis, vertices->points, 4, out);
+        return;
+    }
+    if (vertices->shape == EcsPolygonShapeTriangle) {
+        EcsPhysis2d_projectPoints(axis, vertices->points, 3, out);
+        return;
+    }
+    if (vertices->supports != NULL && vertices->size >= EXTREME_PROJECTION_THRESHOLD) {
+        EcsVector2D opposite = {-VECTOR_X(axis), -VECTOR_Y(axis)};
+        int32_t min = EcsPhysis2d_getExtremeVertex(vertices, &opposite);
+        int32_t max = EcsPhysis2d_getExtremeVertex(vertices, axis);
+        VECTOR_X(out) = EcsVector2D_dot(axis, &vertices->points[min]);
+        VECTOR_Y(out) = EcsVector2D_dot(axis, &vertices->points[max]);
+        return;
+    }
+    if (vertices->xs != NULL) {
+        EcsPhysis2d_projectSoA(axis, vertices->xs, vertices->ys, vertices->size, out);
+        return;
+    }
+    EcsPhysis2d_projectPoints(axis, vertices->points, vertices->size, out);
+}
+
+static FIXED_SIZE void EcsPhysis2d_projectPoints(
+    EcsVector2D *axis, 
+    EcsPoint *points, int32_t size,
+    EcsVector2D *out)
+{
+    float min = EcsVector2D_dot(axis, &points[0]);
     float max = min;
     for (int i = 1; i < size; i++) {
-        float t = EcsVector2D_dot(axis, &vertices[i]);
+        float t = EcsVector2D_dot(axis, &points[i]);
         if (t < min) {
             min = t;
         } 
@@ -247,30 +682,318 @@ static void EcsPhysis2d_getProjection(
     VECTOR_Y(out) = max;
 }
 
-static void EcsPhysis2d_getProjectionCircle(
-    EcsVector2D *axis,
-    EcsVector2D *center, float radius,
+void EcsPhysis2d_getTransform(ColliderData_t *collider, EcsTransform *out)
+{
+    VECTOR_X(&out->position) = VECTOR_X(collider->position);
+    VECTOR_Y(&out->position) = VECTOR_Y(collider->position);
+    if (collider->rotation != NULL && GET_DATA_TYPE(collider) != BOX) {
+        out->rotation = *collider->rotation;
+    } else {
+        out->rotation.c = 1;
+        out->rotation.s = 0;
+    }
+}
+
+/*
+ * Fills out with the world space vertices of polygon, from the vertex cache
+ * when there is one, transformed into buffer otherwise.
+ */
+int8_t EcsPhysis2d_getWorldVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out)
+{
+    if (ctx != NULL && ctx->vertex_cache != NULL) {
+        EcsVertexCacheEntry *entry = EcsVertexCache_getEntry(ctx->vertex_cache, polygon);
+        if (entry != NULL) {
+            int32_t size = polygon->polygon->points_count;
+            out->size = size;
+            out->shape = EcsPhysis2d_getShape(polygon->polygon);
+            out->winding = polygon->polygon->normals != NULL ? polygon->polygon->winding : 0;
+            out->normals = polygon->polygon->normals;
+            out->supports = polygon->polygon->supports;
+            out->facing = polygon->polygon->facing;
+            out->rotation = entry->transform.rotation;
+            out->points = entry->vertices;
+            out->xs = NULL;
+            out->ys = NULL;
+            out->heap = NULL;
+            if (size >= SIMD_THRESHOLD) {
+                out->xs = entry->soa;
+                out->ys = entry->soa + entry->capacity;
+            }
+            return true;
+        }
+    }
+    EcsTransform transform;
+    EcsPhysis2d_getTransform(polygon, &transform);
+    return EcsPhysis2d_getFrameVertices(polygon, &transform, buffer, soa_buffer, out);
+}
+
+/*
+ * Big polygons also get a SoA copy (soa_buffer, can be NULL) for the vector
+ * projection kernel. Polygons that do not fit in the buffers are transformed
+ * into heap memory. The identity transform keeps the local vertices in place.
+ */
+int8_t EcsPhysis2d_getFrameVertices(
+    ColliderData_t *polygon,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out)
+{
+    int32_t size = polygon->polygon->points_count;
+    out->size = size;
+    out->shape = EcsPhysis2d_getShape(polygon->polygon);
+    out->winding = polygon->polygon->normals != NULL ? polygon->polygon->winding : 0;
+    out->normals = polygon->polygon->normals;
+    out->supports = polygon->polygon->supports;
+    out->facing = polygon->polygon->facing;
+    out->points = polygon->polygon->points;
+    out->xs = NULL;
+    out->ys = NULL;
+    out->heap = NULL;
+    out->rotation.c = 1;
+    out->rotation.s = 0;
+
+    if (transform != NULL && transform->rotation.c == 1 && transform->rotation.s == 0 &&
+        VECTOR_X(&transform->position) == 0 && VECTOR_Y(&transform->position) == 0) {
+        transform = NULL;
+    }
+    int8_t soa = soa_buffer != NULL && size >= SIMD_THRESHOLD;
+    if (transform == NULL && !soa) {
+        return true;
+    }
+    if (size > VERTEX_BUFFER_SIZE) {
+        out->heap = malloc(size * (sizeof(EcsPoint) + 2 * sizeof(float)));
+        if (out->heap == NULL) {
+            return false;
+        }
+        buffer = out->heap;
+        soa_buffer = (float*)&buffer[size];
+    }
+    if (transform != NULL) {
+        EcsTransform_apply(transform, polygon->polygon->points, buffer, size);
+        out->points = buffer;
+        out->rotation = transform->rotation;
+    }
+    if (soa) {
+        out->xs = soa_buffer;
+        out->ys = soa_buffer + size;
+        for (int32_t i = 0; i < size; i++) {
+            out->xs[i] = VECTOR_X(&out->points[i]);
+            out->ys[i] = VECTOR_Y(&out->points[i]);
+        }
+    }
+    return true;
+}
+
+int8_t EcsPhysis2d_getPairVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a,
+    ColliderData_t *polygon_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    EcsTransform *frame_out)
+{
+    if (ctx != NULL && ctx->vertex_cache != NULL) {
+        // Cached vertices are already in world space
+        VECTOR_X(&frame_out->position) = 0;
+        VECTOR_Y(&frame_out->position) = 0;
+        frame_out->rotation.c = 1;
+        frame_out->rotation.s = 0;
+        if (!EcsPhysis2d_getWorldVertices(ctx, polygon_a, buffer_a, soa_a, vertices_a)) {
+            return false;
+        }
+        if (!EcsPhysis2d_getWorldVertices(ctx, polygon_b, buffer_b, soa_b, vertices_b)) {
+            EcsPhysis2d_releaseWorldVertices(vertices_a);
+            return false;
+        }
+        return true;
+    }
+    EcsTransform relative;
+    EcsPhysis2d_getTransform(polygon_a, frame_out);
+    EcsPhysis2d_getTransform(polygon_b, &relative);
+    EcsTransform_relative(frame_out, &relative, &relative);
+    if (!EcsPhysis2d_getFrameVertices(polygon_a, NULL, buffer_a, soa_a, vertices_a)) {
+        return false;
+    }
+    if (!EcsPhysis2d_getFrameVertices(polygon_b, &relative, buffer_b, soa_b, vertices_b)) {
+        EcsPhysis2d_releaseWorldVertices(vertices_a);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Boxes share one set of normals, their corners are counter clockwise.
+ */
+int8_t EcsPhysis2d_getCoreVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out,
+    float *radius_out)
+{
+    static EcsVector2D box_normals[4] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+    int8_t type = GET_DATA_TYPE(collider);
+    if (type == POLYGON) {
+        *radius_out = 0;
+        return transform != NULL ?
+            EcsPhysis2d_getFrameVertices(collider, transform, buffer, soa_buffer, out) :
+            EcsPhysis2d_getWorldVertices(ctx, collider, buffer, soa_buffer, out);
+    }
+    EcsTransform own;
+    if (transform == NULL) {
+        EcsPhysis2d_getTransform(collider, &own);
+        transform = &own;
+    }
+    out->points = buffer;
+    out->xs = NULL;
+    out->ys = NULL;
+    out->normals = NULL;
+    out->supports = NULL;
+    out->facing = NULL;
+    out->rotation = transform->rotation;
+    out->shape = EcsPolygonShapeGeneric;
+    out->winding = 0;
+    out->heap = NULL;
+    if (type == CIRCLE) {
+        VECTOR_X(&buffer[0]) = VECTOR_X(&transform->position);
+        VECTOR_Y(&buffer[0]) = VECTOR_Y(&transform->position);
+        out->size = 1;
+        *radius_out = collider->circle->radius;
+    } else if (type == CAPSULE) {
+        EcsCapsuleCollider *capsule = collider->capsule;
+        EcsTransform_apply(transform, &capsule->point1, &buffer[0], 1);
+        EcsTransform_apply(transform, &capsule->point2, &buffer[1], 1);
+        out->size = VECTOR_X(&capsule->point1) == VECTOR_X(&capsule->point2) &&
+                    VECTOR_Y(&capsule->point1) == VECTOR_Y(&capsule->point2) ? 1 : 2;
+        *radius_out = capsule->radius;
+    } else {
+        float x = VECTOR_X(&collider->box->half_extents);
+        float y = VECTOR_Y(&collider->box->half_extents);
+        EcsPoint corners[4] = {{-x, -y}, {x, -y}, {x, y}, {-x, y}};
+        EcsTransform_apply(transform, corners, buffer, 4);
+        out->normals = box_normals;
+        out->shape = EcsPolygonShapeBox;
+        out->winding = 1;
+        out->size = 4;
+        *radius_out = 0;
+    }
+    return true;
+}
+
+int8_t EcsPhysis2d_getCorePairVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    PolygonVertices_t *vertices_a, float *radius_a,
+    PolygonVertices_t *vertices_b, float *radius_b,
+    EcsTransform *frame_out)
+{
+    EcsTransform identity = {{0, 0}, EcsRotation_Identity()};
+    EcsTransform relative;
+    EcsTransform *transform_a = NULL;
+    EcsTransform *transform_b = NULL;
+    *frame_out = identity;
+    if (ctx == NULL || ctx->vertex_cache == NULL) {
+        // Local frame of a, only b is transformed
+        EcsPhysis2d_getTransform(collider_a, frame_out);
+        EcsPhysis2d_getTransform(collider_b, &relative);
+        EcsTransform_relative(frame_out, &relative, &relative);
+        transform_a = &identity;
+        transform_b = &relative;
+    }
+    if (!EcsPhysis2d_getCoreVertices(ctx, collider_a, transform_a, buffer_a, soa_a, vertices_a, radius_a)) {
+        return false;
+    }
+    if (!EcsPhysis2d_getCoreVertices(ctx, collider_b, transform_b, buffer_b, soa_b, vertices_b, radius_b)) {
+        EcsPhysis2d_releaseWorldVertices(vertices_a);
+        return false;
+    }
+    return true;
+}
+
+void EcsPhysis2d_releaseWorldVertices(PolygonVertices_t *vertices)
+{
+    free(vertices->heap);
+    vertices->heap = NULL;
+}
+
+/*
+ * Shape baked for the polygon, generic when the points changed size since
+ * the last bake.
+ */
+static int8_t EcsPhysis2d_getShape(EcsPolygonCollider *polygon)
+{
+    if (polygon->normals == NULL) {
+        return EcsPolygonShapeGeneric;
+    }
+    if (polygon->shape == EcsPolygonShapeBox && polygon->points_count == 4) {
+        return EcsPolygonShapeBox;
+    }
+    if (polygon->shape == EcsPolygonShapeTriangle && polygon->points_count == 3) {
+        return EcsPolygonShapeTriangle;
+    }
+    return EcsPolygonShapeGeneric;
+}
+
+/*
+ * Unit normal of edge [edge, edge+1], rotated from the baked normals when the
+ * polygon has them. Translation does not change the normals.
+ */
+static void EcsPhysis2d_getEdgeNormal(
+    PolygonVertices_t *vertices,
+    int32_t edge,
     EcsVector2D *out)
 {
-    float mid = EcsVector2D_dot(axis, center);
-    VECTOR_X(out) = mid - radius;
-    VECTOR_Y(out) = mid + radius;
+    if (vertices->normals != NULL) {
+        float x = VECTOR_X(&vertices->normals[edge]);
+        float y = VECTOR_Y(&vertices->normals[edge]);
+        VECTOR_X(out) = vertices->rotation.c * x - vertices->rotation.s * y;
+        VECTOR_Y(out) = vertices->rotation.s * x + vertices->rotation.c * y;
+        return;
+    }
+    int32_t size = vertices->size;
+    EcsPoint *points = vertices->points;
+    EcsVector2D_sub(&points[(edge+1) < size ? (edge+1) : 0], &points[edge], out);
+    EcsVector2D_get_normal(out, out);
+    EcsVector2D_normalize(out, out);
+}
+/*
+ * Supports are sorted by local normal angle, direction is moved into the
+ * local frame of the polygon before the lookup.
+ */
+int32_t EcsPhysis2d_getExtremeVertex(PolygonVertices_t *vertices, EcsVector2D *direction)
+{
+    EcsVector2D local;
+    EcsRotation_invRotate(&vertices->rotation, direction, &local);
+    return EcsPolygonCollider_getExtremeVertex(vertices->supports, vertices->size, VECTOR_X(&local), VECTOR_Y(&local));
 }
 
-static void EcsPhysis2d_getClosestPoint(
-    EcsVector2D *position, 
-    EcsPoint *vertices, int8_t size,
+/*
+ * Rotations and translations keep the winding, the baked one holds in any
+ * frame.
+ */
+float EcsPhysis2d_getWinding(PolygonVertices_t *vertices)
+{
+    if (vertices->winding != 0) {
+        return vertices->winding;
+    }
+    return EcsPolygonCollider_computeWinding(vertices->points, vertices->size);
+}
+
+void EcsPhysis2d_getOutwardNormal(
+    PolygonVertices_t *vertices, float winding,
+    int32_t edge,
     EcsVector2D *out)
 {
-    float distance = MAXFLOAT;
-    float currDist;
-
-    for (int i = 0; i < size; i++) {
-        currDist = EcsVector2D_distanceSqrt(position, &vertices[i]);
-        if (currDist < distance) {
-            distance = currDist;
-            VECTOR_X(out) = VECTOR_X(&vertices[i]);
-            VECTOR_Y(out) = VECTOR_Y(&vertices[i]);
-        }
-    }    
-}
\ No newline at end of file
+    EcsPhysis2d_getEdgeNormal(vertices, edge, out);
+    EcsVector2D_scale(out, winding, out);
+}
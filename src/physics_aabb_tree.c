@@ -0,0 +1,576 @@
+#include "include/physics_aabb_tree.h"
+#include "private.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NULL_NODE EcsAABBTree_NullNode
+#define STACK_SIZE 256
+#define IS_LEAF(node) ((node)->child1 == NULL_NODE)
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* Traversal stack, starts on the C stack and moves to the heap if needed */
+typedef struct EcsAABBTreeStack {
+    int32_t *data;
+    int32_t count;
+    int32_t capacity;
+    int32_t local[STACK_SIZE];
+} EcsAABBTreeStack;
+
+static int32_t EcsAABBTree_allocateNode(EcsAABBTree *tree);
+static void EcsAABBTree_freeNode(EcsAABBTree *tree, int32_t node);
+static int8_t EcsAABBTree_insertLeaf(EcsAABBTree *tree, int32_t leaf);
+static void EcsAABBTree_removeLeaf(EcsAABBTree *tree, int32_t leaf);
+static void EcsAABBTree_refit(EcsAABBTree *tree, int32_t index);
+static int32_t EcsAABBTree_balance(EcsAABBTree *tree, int32_t index);
+
+static void EcsAABB_combine(EcsAABB *a, EcsAABB *b, EcsAABB *out);
+static float EcsAABB_perimeter(EcsAABB *aabb);
+static int8_t EcsAABB_contains(EcsAABB *outer, EcsAABB *inner);
+
+static void EcsAABBTreeStack_init(EcsAABBTreeStack *stack);
+static void EcsAABBTreeStack_deinit(EcsAABBTreeStack *stack);
+static int8_t EcsAABBTreeStack_push(EcsAABBTreeStack *stack, int32_t value);
+
+void EcsAABBTree_init(EcsAABBTree *tree, float margin)
+{
+    tree->nodes = NULL;
+    tree->root = NULL_NODE;
+    tree->count = 0;
+    tree->capacity = 0;
+    tree->free_list = NULL_NODE;
+    tree->margin = margin;
+}
+
+void EcsAABBTree_deinit(EcsAABBTree *tree)
+{
+    free(tree->nodes);
+    EcsAABBTree_init(tree, tree->margin);
+}
+
+int32_t EcsAABBTree_insert(EcsAABBTree *tree, EcsAABB *aabb, int32_t user_id)
+{
+    if (tree == NULL || aabb == NULL) {
+        return NULL_NODE;
+    }
+    int32_t proxy = EcsAABBTree_allocateNode(tree);
+    if (proxy == NULL_NODE) {
+        return NULL_NODE;
+    }
+    EcsAABBTreeNode *node = &tree->nodes[proxy];
+    AABB_MIN_X(&node->aabb) = AABB_MIN_X(aabb) - tree->margin;
+    AABB_MIN_Y(&node->aabb) = AABB_MIN_Y(aabb) - tree->margin;
+    AABB_MAX_X(&node->aabb) = AABB_MAX_X(aabb) + tree->margin;
+    AABB_MAX_Y(&node->aabb) = AABB_MAX_Y(aabb) + tree->margin;
+    node->user_id = user_id;
+    node->height = 0;
+
+    if (!EcsAABBTree_insertLeaf(tree, proxy)) {
+        EcsAABBTree_freeNode(tree, proxy);
+        return NULL_NODE;
+    }
+    return proxy;
+}
+
+void EcsAABBTree_remove(EcsAABBTree *tree, int32_t proxy)
+{
+    if (tree == NULL || proxy < 0 || proxy >= tree->capacity || tree->nodes[proxy].height != 0) {
+        return;
+    }
+    EcsAABBTree_removeLeaf(tree, proxy);
+    EcsAABBTree_freeNode(tree, proxy);
+}
+
+int8_t EcsAABBTree_move(EcsAABBTree *tree, int32_t proxy, EcsAABB *aabb)
+{
+    if (tree == NULL || aabb == NULL || proxy < 0 || proxy >= tree->capacity || tree->nodes[proxy].height != 0) {
+        return false;
+    }
+    EcsAABBTreeNode *node = &tree->nodes[proxy];
+    if (EcsAABB_contains(&node->aabb, aabb)) {
+        return false;
+    }
+
+    EcsAABBTree_removeLeaf(tree, proxy);
+    node = &tree->nodes[proxy];
+    AABB_MIN_X(&node->aabb) = AABB_MIN_X(aabb) - tree->margin;
+    AABB_MIN_Y(&node->aabb) = AABB_MIN_Y(aabb) - tree->margin;
+    AABB_MAX_X(&node->aabb) = AABB_MAX_X(aabb) + tree->margin;
+    AABB_MAX_Y(&node->aabb) = AABB_MAX_Y(aabb) + tree->margin;
+    // Removing the leaf freed its parent, so the new parent always fits
+    EcsAABBTree_insertLeaf(tree, proxy);
+    return true;
+}
+
+int32_t EcsAABBTree_getUserId(EcsAABBTree *tree, int32_t proxy)
+{
+    if (tree == NULL || proxy < 0 || proxy >= tree->capacity) {
+        return NULL_NODE;
+    }
+    return tree->nodes[proxy].user_id;
+}
+
+EcsAABB* EcsAABBTree_getFatAABB(EcsAABBTree *tree, int32_t proxy)
+{
+    if (tree == NULL || proxy < 0 || proxy >= tree->capacity) {
+        return NULL;
+    }
+    return &tree->nodes[proxy].aabb;
+}
+
+int32_t EcsAABBTree_getHeight(EcsAABBTree *tree)
+{
+    if (tree == NULL || tree->root == NULL_NODE) {
+        return 0;
+    }
+    return tree->nodes[tree->root].height;
+}
+
+void EcsAABBTree_query(EcsAABBTree *tree, EcsAABB *aabb, EcsAABBTreeQueryCallback callback, void *ctx)
+{
+    if (tree == NULL || aabb == NULL || tree->root == NULL_NODE) {
+        return;
+    }
+    EcsAABBTreeStack stack;
+    EcsAABBTreeStack_init(&stack);
+    EcsAABBTreeStack_push(&stack, tree->root);
+
+    while (stack.count > 0) {
+        EcsAABBTreeNode *node = &tree->nodes[stack.data[--stack.count]];
+        if (!EcsAABBTest(&node->aabb, aabb)) {
+            continue;
+        }
+        if (IS_LEAF(node)) {
+            if (!callback(ctx, node->user_id)) {
+                break;
+            }
+        } else {
+            EcsAABBTreeStack_push(&stack, node->child1);
+            EcsAABBTreeStack_push(&stack, node->child2);
+        }
+    }
+    EcsAABBTreeStack_deinit(&stack);
+}
+
+void EcsAABBTree_raycast(EcsAABBTree *tree, EcsRay *ray, EcsAABBTreeRaycastCallback callback, void *ctx)
+{
+    if (tree == NULL || ray == NULL || tree->root == NULL_NODE) {
+        return;
+    }
+    EcsRay clipped = *ray;
+    EcsAABBTreeStack stack;
+    EcsAABBTreeStack_init(&stack);
+    EcsAABBTreeStack_push(&stack, tree->root);
+
+    while (stack.count > 0) {
+        EcsAABBTreeNode *node = &tree->nodes[stack.data[--stack.count]];
+        if (!EcsAABBRaycast(&node->aabb, &clipped, NULL)) {
+            continue;
+        }
+        if (IS_LEAF(node)) {
+            float fraction = callback(ctx, &clipped, node->user_id);
+            if (fraction <= 0) {
+                break;
+            }
+            if (fraction < clipped.max_fraction) {
+                clipped.max_fraction = fraction;
+            }
+        } else {
+            EcsAABBTreeStack_push(&stack, node->child1);
+            EcsAABBTreeStack_push(&stack, node->child2);
+        }
+    }
+    EcsAABBTreeStack_deinit(&stack);
+}
+
+void EcsAABBTree_queryTree(EcsAABBTree *tree_a, EcsAABBTree *tree_b, EcsAABBTreePairCallback callback, void *ctx)
+{
+    if (tree_a == NULL || tree_b == NULL || tree_a->root == NULL_NODE || tree_b->root == NULL_NODE) {
+        return;
+    }
+    // Pairs of nodes are pushed as two consecutive entries, a then b
+    EcsAABBTreeStack stack;
+    EcsAABBTreeStack_init(&stack);
+    EcsAABBTreeStack_push(&stack, tree_a->root);
+    EcsAABBTreeStack_push(&stack, tree_b->root);
+
+    while (stack.count > 0) {
+        int32_t index_b = stack.data[--stack.count];
+        int32_t index_a = stack.data[--stack.count];
+        EcsAABBTreeNode *node_a = &tree_a->nodes[index_a];
+        EcsAABBTreeNode *node_b = &tree_b->nodes[index_b];
+        if (!EcsAABBTest(&node_a->aabb, &node_b->aabb)) {
+            continue;
+        }
+        int8_t leaf_a = IS_LEAF(node_a);
+        int8_t leaf_b = IS_LEAF(node_b);
+        if (leaf_a && leaf_b) {
+            if (!callback(ctx, node_a->user_id, node_b->user_id)) {
+                break;
+            }
+        } else if (leaf_b || (!leaf_a && EcsAABB_perimeter(&node_a->aabb) >= EcsAABB_perimeter(&node_b->aabb))) {
+            // Descend into the bigger node
+            EcsAABBTreeStack_push(&stack, node_a->child1);
+            EcsAABBTreeStack_push(&stack, index_b);
+            EcsAABBTreeStack_push(&stack, node_a->child2);
+            EcsAABBTreeStack_push(&stack, index_b);
+        } else {
+            EcsAABBTreeStack_push(&stack, index_a);
+            EcsAABBTreeStack_push(&stack, node_b->child1);
+            EcsAABBTreeStack_push(&stack, index_a);
+            EcsAABBTreeStack_push(&stack, node_b->child2);
+        }
+    }
+    EcsAABBTreeStack_deinit(&stack);
+}
+
+int32_t EcsAABBTree_getPairs(EcsAABBTree *tree, EcsColliderPair *pairs_out, int32_t max_pairs)
+{
+    if (tree == NULL || tree->root == NULL_NODE) {
+        return 0;
+    }
+    int32_t found = 0;
+    EcsAABBTreeStack stack;
+    EcsAABBTreeStack_init(&stack);
+    STATS_BEGIN(timer);
+
+    for (int32_t leaf = 0; leaf < tree->capacity; leaf++) {
+        if (tree->nodes[leaf].height != 0) {
+            continue;
+        }
+        EcsAABB *aabb = &tree->nodes[leaf].aabb;
+        stack.count = 0;
+        EcsAABBTreeStack_push(&stack, tree->root);
+        while (stack.count > 0) {
+            int32_t index = stack.data[--stack.count];
+            EcsAABBTreeNode *node = &tree->nodes[index];
+            if (!EcsAABBTest(&node->aabb, aabb)) {
+                continue;
+            }
+            if (!IS_LEAF(node)) {
+                EcsAABBTreeStack_push(&stack, node->child1);
+                EcsAABBTreeStack_push(&stack, node->child2);
+            } else if (index > leaf) {
+                // Every pair is reported once, from its lowest proxy
+                int32_t a = tree->nodes[leaf].user_id;
+                int32_t b = node->user_id;
+                if (found < max_pairs) {
+                    pairs_out[found].a = a < b ? a : b;
+                    pairs_out[found].b = a < b ? b : a;
+                }
+                found++;
+            }
+        }
+    }
+    EcsAABBTreeStack_deinit(&stack);
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return found;
+}
+
+static int32_t EcsAABBTree_allocateNode(EcsAABBTree *tree)
+{
+    if (tree->free_list == NULL_NODE) {
+        int32_t capacity = tree->capacity ? tree->capacity * 2 : 16;
+        EcsAABBTreeNode *nodes = realloc(tree->nodes, capacity * sizeof(EcsAABBTreeNode));
+        if (nodes == NULL) {
+            return NULL_NODE;
+        }
+        for (int32_t i = tree->capacity; i < capacity; i++) {
+            nodes[i].parent = (i + 1) < capacity ? (i + 1) : NULL_NODE;
+            nodes[i].height = -1;
+        }
+        tree->free_list = tree->capacity;
+        tree->nodes = nodes;
+        tree->capacity = capacity;
+    }
+    int32_t index = tree->free_list;
+    EcsAABBTreeNode *node = &tree->nodes[index];
+    tree->free_list = node->parent;
+    node->parent = NULL_NODE;
+    node->child1 = NULL_NODE;
+    node->child2 = NULL_NODE;
+    node->height = 0;
+    node->user_id = NULL_NODE;
+    tree->count++;
+    return index;
+}
+
+static void EcsAABBTree_freeNode(EcsAABBTree *tree, int32_t node)
+{
+    tree->nodes[node].parent = tree->free_list;
+    tree->nodes[node].height = -1;
+    tree->free_list = node;
+    tree->count--;
+}
+
+/*
+ * Returns false when the parent node can not be allocated, the tree is
+ * then left unchanged.
+ */
+static int8_t EcsAABBTree_insertLeaf(EcsAABBTree *tree, int32_t leaf)
+{
+    if (tree->root == NULL_NODE) {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = NULL_NODE;
+        return true;
+    }
+
+    // Find the best sibling using the perimeter heuristic
+    EcsAABB leaf_aabb;
+    memcpy(leaf_aabb, tree->nodes[leaf].aabb, sizeof(EcsAABB));
+    int32_t index = tree->root;
+    while (!IS_LEAF(&tree->nodes[index])) {
+        EcsAABBTreeNode *node = &tree->nodes[index];
+        EcsAABB combined;
+        EcsAABB_combine(&node->aabb, &leaf_aabb, &combined);
+        float area = EcsAABB_perimeter(&node->aabb);
+        float combined_area = EcsAABB_perimeter(&combined);
+
+        float cost = 2.0f * combined_area;
+        float inheritance = 2.0f * (combined_area - area);
+
+        float child_cost[2];
+        int32_t children[2] = {node->child1, node->child2};
+        for (int i = 0; i < 2; i++) {
+            EcsAABBTreeNode *child = &tree->nodes[children[i]];
+            EcsAABB_combine(&child->aabb, &leaf_aabb, &combined);
+            child_cost[i] = EcsAABB_perimeter(&combined) + inheritance;
+            if (!IS_LEAF(child)) {
+                child_cost[i] -= EcsAABB_perimeter(&child->aabb);
+            }
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1]) {
+            break;
+        }
+        index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+    }
+
+    int32_t sibling = index;
+    int32_t new_parent = EcsAABBTree_allocateNode(tree);
+    if (new_parent == NULL_NODE) {
+        return false;
+    }
+    int32_t old_parent = tree->nodes[sibling].parent;
+    EcsAABBTreeNode *parent = &tree->nodes[new_parent];
+    parent->parent = old_parent;
+    parent->height = tree->nodes[sibling].height + 1;
+    parent->child1 = sibling;
+    parent->child2 = leaf;
+    EcsAABB_combine(&leaf_aabb, &tree->nodes[sibling].aabb, &parent->aabb);
+
+    if (old_parent != NULL_NODE) {
+        if (tree->nodes[old_parent].child1 == sibling) {
+            tree->nodes[old_parent].child1 = new_parent;
+        } else {
+            tree->nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        tree->root = new_parent;
+    }
+    tree->nodes[sibling].parent = new_parent;
+    tree->nodes[leaf].parent = new_parent;
+
+    EcsAABBTree_refit(tree, new_parent);
+    return true;
+}
+
+static void EcsAABBTree_removeLeaf(EcsAABBTree *tree, int32_t leaf)
+{
+    if (leaf == tree->root) {
+        tree->root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = tree->nodes[leaf].parent;
+    int32_t grand_parent = tree->nodes[parent].parent;
+    int32_t sibling = tree->nodes[parent].child1 == leaf ? tree->nodes[parent].child2 : tree->nodes[parent].child1;
+
+    if (grand_parent != NULL_NODE) {
+        if (tree->nodes[grand_parent].child1 == parent) {
+            tree->nodes[grand_parent].child1 = sibling;
+        } else {
+            tree->nodes[grand_parent].child2 = sibling;
+        }
+        tree->nodes[sibling].parent = grand_parent;
+        EcsAABBTree_freeNode(tree, parent);
+        EcsAABBTree_refit(tree, grand_parent);
+    } else {
+        tree->root = sibling;
+        tree->nodes[sibling].parent = NULL_NODE;
+        EcsAABBTree_freeNode(tree, parent);
+    }
+    tree->nodes[leaf].parent = NULL_NODE;
+}
+
+/* Walks up from index fixing heights and AABBs, rebalancing on the way */
+static void EcsAABBTree_refit(EcsAABBTree *tree, int32_t index)
+{
+    while (index != NULL_NODE) {
+        index = EcsAABBTree_balance(tree, index);
+        EcsAABBTreeNode *node = &tree->nodes[index];
+        EcsAABBTreeNode *child1 = &tree->nodes[node->child1];
+        EcsAABBTreeNode *child2 = &tree->nodes[node->child2];
+        node->height = 1 + MAX(child1->height, child2->height);
+        EcsAABB_combine(&child1->aabb, &child2->aabb, &node->aabb);
+        index = node->parent;
+    }
+}
+
+/*
+ * Rotates the taller child of a up when the subtree is unbalanced.
+ * Returns the index of the new subtree root.
+ */
+static int32_t EcsAABBTree_balance(EcsAABBTree *tree, int32_t index_a)
+{
+    EcsAABBTreeNode *nodes = tree->nodes;
+    EcsAABBTreeNode *a = &nodes[index_a];
+    if (IS_LEAF(a) || a->height < 2) {
+        return index_a;
+    }
+
+    int32_t index_b = a->child1;
+    int32_t index_c = a->child2;
+    EcsAABBTreeNode *b = &nodes[index_b];
+    EcsAABBTreeNode *c = &nodes[index_c];
+    int32_t balance = c->height - b->height;
+
+    if (balance > 1) {
+        // Rotate c up
+        int32_t index_f = c->child1;
+        int32_t index_g = c->child2;
+        EcsAABBTreeNode *f = &nodes[index_f];
+        EcsAABBTreeNode *g = &nodes[index_g];
+
+        c->child1 = index_a;
+        c->parent = a->parent;
+        a->parent = index_c;
+        if (c->parent != NULL_NODE) {
+            if (nodes[c->parent].child1 == index_a) {
+                nodes[c->parent].child1 = index_c;
+            } else {
+                nodes[c->parent].child2 = index_c;
+            }
+        } else {
+            tree->root = index_c;
+        }
+
+        if (f->height > g->height) {
+            c->child2 = index_f;
+            a->child2 = index_g;
+            g->parent = index_a;
+            EcsAABB_combine(&b->aabb, &g->aabb, &a->aabb);
+            EcsAABB_combine(&a->aabb, &f->aabb, &c->aabb);
+            a->height = 1 + MAX(b->height, g->height);
+            c->height = 1 + MAX(a->height, f->height);
+        } else {
+            c->child2 = index_g;
+            a->child2 = index_f;
+            f->parent = index_a;
+            EcsAABB_combine(&b->aabb, &f->aabb, &a->aabb);
+            EcsAABB_combine(&a->aabb, &g->aabb, &c->aabb);
+            a->height = 1 + MAX(b->height, f->height);
+            c->height = 1 + MAX(a->height, g->height);
+        }
+        return index_c;
+    }
+
+    if (balance < -1) {
+        // Rotate b up
+        int32_t index_d = b->child1;
+        int32_t index_e = b->child2;
+        EcsAABBTreeNode *d = &nodes[index_d];
+        EcsAABBTreeNode *e = &nodes[index_e];
+
+        b->child1 = index_a;
+        b->parent = a->parent;
+        a->parent = index_b;
+        if (b->parent != NULL_NODE) {
+            if (nodes[b->parent].child1 == index_a) {
+                nodes[b->parent].child1 = index_b;
+            } else {
+                nodes[b->parent].child2 = index_b;
+            }
+        } else {
+            tree->root = index_b;
+        }
+
+        if (d->height > e->height) {
+            b->child2 = index_d;
+            a->child1 = index_e;
+            e->parent = index_a;
+            EcsAABB_combine(&c->aabb, &e->aabb, &a->aabb);
+            EcsAABB_combine(&a->aabb, &d->aabb, &b->aabb);
+            a->height = 1 + MAX(c->height, e->height);
+            b->height = 1 + MAX(a->height, d->height);
+        } else {
+            b->child2 = index_e;
+            a->child1 = index_d;
+            d->parent = index_a;
+            EcsAABB_combine(&c->aabb, &d->aabb, &a->aabb);
+            EcsAABB_combine(&a->aabb, &e->aabb, &b->aabb);
+            a->height = 1 + MAX(c->height, d->height);
+            b->height = 1 + MAX(a->height, e->height);
+        }
+        return index_b;
+    }
+
+    return index_a;
+}
+
+static void EcsAABB_combine(EcsAABB *a, EcsAABB *b, EcsAABB *out)
+{
+    AABB_MIN_X(out) = AABB_MIN_X(a) < AABB_MIN_X(b) ? AABB_MIN_X(a) : AABB_MIN_X(b);
+    AABB_MIN_Y(out) = AABB_MIN_Y(a) < AABB_MIN_Y(b) ? AABB_MIN_Y(a) : AABB_MIN_Y(b);
+    AABB_MAX_X(out) = AABB_MAX_X(a) > AABB_MAX_X(b) ? AABB_MAX_X(a) : AABB_MAX_X(b);
+    AABB_MAX_Y(out) = AABB_MAX_Y(a) > AABB_MAX_Y(b) ? AABB_MAX_Y(a) : AABB_MAX_Y(b);
+}
+
+static float EcsAABB_perimeter(EcsAABB *aabb)
+{
+    return 2.0f * ((AABB_MAX_X(aabb) - AABB_MIN_X(aabb)) + (AABB_MAX_Y(aabb) - AABB_MIN_Y(aabb)));
+}
+
+static int8_t EcsAABB_contains(EcsAABB *outer, EcsAABB *inner)
+{
+    return AABB_MIN_X(outer) <= AABB_MIN_X(inner) &&
+           AABB_MIN_Y(outer) <= AABB_MIN_Y(inner) &&
+           AABB_MAX_X(inner) <= AABB_MAX_X(outer) &&
+           AABB_MAX_Y(inner) <= AABB_MAX_Y(outer);
+}
+
+static void EcsAABBTreeStack_init(EcsAABBTreeStack *stack)
+{
+    stack->data = stack->local;
+    stack->count = 0;
+    stack->capacity = STACK_SIZE;
+}
+
+static void EcsAABBTreeStack_deinit(EcsAABBTreeStack *stack)
+{
+    if (stack->data != stack->local) {
+        free(stack->data);
+    }
+}
+
+static int8_t EcsAABBTreeStack_push(EcsAABBTreeStack *stack, int32_t value)
+{
+    if (stack->count == stack->capacity) {
+        int32_t capacity = stack->capacity * 2;
+        int32_t *data;
+        if (stack->data == stack->local) {
+            data = malloc(capacity * sizeof(int32_t));
+            if (data != NULL) {
+                memcpy(data, stack->local, stack->count * sizeof(int32_t));
+            }
+        } else {
+            data = realloc(stack->data, capacity * sizeof(int32_t));
+        }
+        if (data == NULL) {
+            return false;
+        }
+        stack->data = data;
+        stack->capacity = capacity;
+    }
+    stack->data[stack->count++] = value;
+    return true;
+}
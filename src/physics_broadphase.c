@@ -0,0 +1,295 @@
+#include "include/physics_broadphase.h"
+#include "private.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int8_t EcsSweepAndPrune_reserve(EcsSweepAndPrune *sap, int32_t count);
+static void EcsSweepAndPrune_sort(EcsSweepAndPrune *sap, int32_t count);
+static int8_t EcsSweepAndPrune_getAxis(EcsAABB *aabbs, int32_t count);
+static void EcsSweepAndPrune_computeMaxExtent(EcsSweepAndPrune *sap);
+static void EcsSweepAndPrune_insertionSort(EcsSweepAndPruneEndpoint *endpoints, int32_t count);
+static int EcsSweepAndPrune_compare(const void *a, const void *b);
+
+void EcsSweepAndPrune_init(EcsSweepAndPrune *sap)
+{
+    sap->aabbs = NULL;
+    sap->endpoints = NULL;
+    sap->ranks = NULL;
+    sap->count = 0;
+    sap->capacity = 0;
+    sap->max_extent = 0;
+    sap->max_index = -1;
+    sap->axis = 0;
+}
+
+void EcsSweepAndPrune_deinit(EcsSweepAndPrune *sap)
+{
+    free(sap->aabbs);
+    free(sap->endpoints);
+    free(sap->ranks);
+    EcsSweepAndPrune_init(sap);
+}
+
+int8_t EcsSweepAndPrune_update(EcsSweepAndPrune *sap, EcsColliderData **colliders, int32_t count)
+{
+    if (sap == NULL || (colliders == NULL && count > 0)) {
+        return false;
+    }
+    if (!EcsSweepAndPrune_reserve(sap, count)) {
+        return false;
+    }
+
+    STATS_BEGIN(timer);
+    for (int32_t i = 0; i < count; i++) {
+        EcsAABB *aabb = &sap->aabbs[i];
+        if (!EcsColliderData_getAABB(colliders[i], aabb)) {
+            AABB_MIN_X(aabb) = INFINITY;
+            AABB_MIN_Y(aabb) = INFINITY;
+            AABB_MAX_X(aabb) = -INFINITY;
+            AABB_MAX_Y(aabb) = -INFINITY;
+        }
+    }
+    STATS_END(EcsStatsStageAABB, timer);
+    EcsSweepAndPrune_sort(sap, count);
+    return true;
+}
+
+int8_t EcsSweepAndPrune_updateAABBs(EcsSweepAndPrune *sap, EcsAABB *aabbs, int32_t count)
+{
+    if (sap == NULL || (aabbs == NULL && count > 0)) {
+        return false;
+    }
+    if (!EcsSweepAndPrune_reserve(sap, count)) {
+        return false;
+    }
+    memcpy(sap->aabbs, aabbs, count * sizeof(EcsAABB));
+    EcsSweepAndPrune_sort(sap, count);
+    return true;
+}
+
+static void EcsSweepAndPrune_sort(EcsSweepAndPrune *sap, int32_t count)
+{
+    STATS_BEGIN(timer);
+    int8_t axis = EcsSweepAndPrune_getAxis(sap->aabbs, count);
+    EcsSweepAndPruneEndpoint *endpoints = sap->endpoints;
+
+    if (count == sap->count && axis == sap->axis) {
+        // Same colliders as last frame, the previous order is almost sorted
+        for (int32_t i = 0; i < count; i++) {
+            endpoints[i].value = sap->aabbs[endpoints[i].index][axis];
+        }
+        EcsSweepAndPrune_insertionSort(endpoints, count);
+    } else {
+        for (int32_t i = 0; i < count; i++) {
+            endpoints[i].value = sap->aabbs[i][axis];
+            endpoints[i].index = i;
+        }
+        qsort(endpoints, count, sizeof(EcsSweepAndPruneEndpoint), EcsSweepAndPrune_compare);
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        sap->ranks[endpoints[i].index] = i;
+    }
+
+    sap->count = count;
+    sap->axis = axis;
+    EcsSweepAndPrune_computeMaxExtent(sap);
+    STATS_END(EcsStatsStageBroadphase, timer);
+}
+
+int8_t EcsSweepAndPrune_move(EcsSweepAndPrune *sap, int32_t *indices, int32_t count, EcsAABB *aabbs)
+{
+    if (sap == NULL || (count > 0 && (indices == NULL || aabbs == NULL))) {
+        return false;
+    }
+    EcsSweepAndPruneEndpoint *endpoints = sap->endpoints;
+    int32_t *ranks = sap->ranks;
+    int8_t axis = sap->axis;
+    STATS_BEGIN(timer);
+    for (int32_t i = 0; i < count; i++) {
+        int32_t index = indices[i];
+        if (index < 0 || index >= sap->count) {
+            STATS_END(EcsStatsStageBroadphase, timer);
+            return false;
+        }
+        memcpy(sap->aabbs[index], aabbs[index], sizeof(EcsAABB));
+        float extent = aabbs[index][axis + 2] - aabbs[index][axis];
+        if (extent > sap->max_extent) {
+            sap->max_extent = extent;
+            sap->max_index = index;
+        } else if (index == sap->max_index && extent < sap->max_extent) {
+            // The largest collider shrank, another one can be the largest now
+            EcsSweepAndPrune_computeMaxExtent(sap);
+        }
+
+        // Insertion sort step of a single endpoint, in both directions
+        int32_t rank = ranks[index];
+        EcsSweepAndPruneEndpoint key = {aabbs[index][axis], index};
+        while (rank > 0 && endpoints[rank - 1].value > key.value) {
+            endpoints[rank] = endpoints[rank - 1];
+            ranks[endpoints[rank].index] = rank;
+            rank--;
+        }
+        while (rank < sap->count - 1 && endpoints[rank + 1].value < key.value) {
+            endpoints[rank] = endpoints[rank + 1];
+            ranks[endpoints[rank].index] = rank;
+            rank++;
+        }
+        endpoints[rank] = key;
+        ranks[index] = rank;
+    }
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return true;
+}
+
+int32_t EcsSweepAndPrune_getPairs(EcsSweepAndPrune *sap, EcsColliderPair *pairs_out, int32_t max_pairs)
+{
+    if (sap == NULL) {
+        return 0;
+    }
+    EcsSweepAndPruneEndpoint *endpoints = sap->endpoints;
+    int32_t found = 0;
+    int8_t max_axis = sap->axis + 2;
+    STATS_BEGIN(timer);
+
+    for (int32_t i = 0; i < sap->count; i++) {
+        int32_t a = endpoints[i].index;
+        EcsAABB *aabb_a = &sap->aabbs[a];
+        float max = (*aabb_a)[max_axis];
+        for (int32_t j = i + 1; j < sap->count && endpoints[j].value <= max; j++) {
+            int32_t b = endpoints[j].index;
+            if (!EcsAABBTest(aabb_a, &sap->aabbs[b])) {
+                continue;
+            }
+            if (found < max_pairs) {
+                pairs_out[found].a = a < b ? a : b;
+                pairs_out[found].b = a < b ? b : a;
+            }
+            found++;
+        }
+    }
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return found;
+}
+
+void EcsSweepAndPrune_query(EcsSweepAndPrune *sap, EcsAABB *aabb, EcsSweepAndPruneQueryCallback callback, void *ctx)
+{
+    if (sap == NULL || aabb == NULL || callback == NULL) {
+        return;
+    }
+    EcsSweepAndPruneEndpoint *endpoints = sap->endpoints;
+    int8_t axis = sap->axis;
+    float min = (*aabb)[axis] - sap->max_extent;
+    float max = (*aabb)[axis + 2];
+
+    // First endpoint that can reach the region
+    int32_t low = 0;
+    int32_t high = sap->count;
+    while (low < high) {
+        int32_t middle = (low + high) / 2;
+        if (endpoints[middle].value < min) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (int32_t i = low; i < sap->count && endpoints[i].value <= max; i++) {
+        int32_t index = endpoints[i].index;
+        if (!EcsAABBTest(aabb, &sap->aabbs[index])) {
+            continue;
+        }
+        if (!callback(ctx, index)) {
+            return;
+        }
+    }
+}
+
+static void EcsSweepAndPrune_computeMaxExtent(EcsSweepAndPrune *sap)
+{
+    int8_t axis = sap->axis;
+    sap->max_extent = 0;
+    sap->max_index = -1;
+    for (int32_t i = 0; i < sap->count; i++) {
+        float extent = sap->aabbs[i][axis + 2] - sap->aabbs[i][axis];
+        if (extent > sap->max_extent || sap->max_index == -1) {
+            sap->max_extent = extent > 0 ? extent : 0;
+            sap->max_index = i;
+        }
+    }
+}
+
+static int8_t EcsSweepAndPrune_reserve(EcsSweepAndPrune *sap, int32_t count)
+{
+    if (count <= sap->capacity) {
+        return true;
+    }
+    int32_t capacity = sap->capacity ? sap->capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    EcsAABB *aabbs = realloc(sap->aabbs, capacity * sizeof(EcsAABB));
+    if (aabbs == NULL) {
+        return false;
+    }
+    sap->aabbs = aabbs;
+    EcsSweepAndPruneEndpoint *endpoints = realloc(sap->endpoints, capacity * sizeof(EcsSweepAndPruneEndpoint));
+    if (endpoints == NULL) {
+        return false;
+    }
+    sap->endpoints = endpoints;
+    int32_t *ranks = realloc(sap->ranks, capacity * sizeof(int32_t));
+    if (ranks == NULL) {
+        return false;
+    }
+    sap->ranks = ranks;
+    sap->capacity = capacity;
+    return true;
+}
+
+static int8_t EcsSweepAndPrune_getAxis(EcsAABB *aabbs, int32_t count)
+{
+    float sum[2] = {0, 0};
+    float sum2[2] = {0, 0};
+    int32_t valid = 0;
+
+    for (int32_t i = 0; i < count; i++) {
+        EcsAABB *aabb = &aabbs[i];
+        if (AABB_MIN_X(aabb) > AABB_MAX_X(aabb)) {
+            continue;
+        }
+        float x = (AABB_MIN_X(aabb) + AABB_MAX_X(aabb)) * 0.5f;
+        float y = (AABB_MIN_Y(aabb) + AABB_MAX_Y(aabb)) * 0.5f;
+        sum[0] += x;
+        sum[1] += y;
+        sum2[0] += x * x;
+        sum2[1] += y * y;
+        valid++;
+    }
+    if (valid == 0) {
+        return 0;
+    }
+    float variance_x = sum2[0] - sum[0] * sum[0] / valid;
+    float variance_y = sum2[1] - sum[1] * sum[1] / valid;
+    return variance_y > variance_x ? 1 : 0;
+}
+
+static void EcsSweepAndPrune_insertionSort(EcsSweepAndPruneEndpoint *endpoints, int32_t count)
+{
+    for (int32_t i = 1; i < count; i++) {
+        EcsSweepAndPruneEndpoint key = endpoints[i];
+        int32_t j = i - 1;
+        while (j >= 0 && endpoints[j].value > key.value) {
+            endpoints[j + 1] = endpoints[j];
+            j--;
+        }
+        endpoints[j + 1] = key;
+    }
+}
+
+static int EcsSweepAndPrune_compare(const void *a, const void *b)
+{
+    float value_a = ((const EcsSweepAndPruneEndpoint*)a)->value;
+    float value_b = ((const EcsSweepAndPruneEndpoint*)b)->value;
+    return (value_a > value_b) - (value_a < value_b);
+}
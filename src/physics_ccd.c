@@ -0,0 +1,326 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <math.h>
+
+#define TOI_MAX_ITERATIONS 32
+#define TOI_TOLERANCE 1e-3f
+
+static int8_t EcsPhysis2dToi_circleCircle(
+    ColliderData_t *circle_a, EcsSweep *sweep_a,
+    ColliderData_t *circle_b, EcsSweep *sweep_b,
+    EcsToiInfo *toi_out);
+static int8_t EcsPhysis2dToi_circlePolygon(
+    ColliderData_t *circle, EcsSweep *sweep_circle,
+    ColliderData_t *polygon, EcsSweep *sweep_polygon,
+    int8_t invert,
+    EcsToiInfo *toi_out);
+static int8_t EcsPhysis2dToi_conservativeAdvancement(
+    ColliderData_t *collider_a, EcsSweep *sweep_a,
+    ColliderData_t *collider_b, EcsSweep *sweep_b,
+    EcsToiInfo *toi_out);
+static int8_t EcsPhysis2dToi_overlap(
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsToiInfo *toi_out);
+static float EcsPhysis2dToi_raycastCircle(
+    EcsVector2D *origin, EcsVector2D *motion,
+    EcsVector2D *center, float radius);
+static void EcsPhysis2dToi_getPosition(
+    ColliderData_t *collider, EcsSweep *sweep, float t,
+    EcsVector2D *out);
+static void EcsPhysis2dToi_getMotion(EcsSweep *sweep, EcsVector2D *out);
+
+int8_t EcsPhysis2dTimeOfImpact(
+    EcsColliderData *collider_a,
+    EcsSweep *sweep_a,
+    EcsColliderData *collider_b,
+    EcsSweep *sweep_b,
+    EcsToiInfo *toi_out)
+{
+    if (collider_a == NULL || collider_b == NULL || toi_out == NULL ||
+        GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL) {
+        return false;
+    }
+    int8_t type_a = GET_COLLIDER_TYPE(collider_a);
+    int8_t type_b = GET_COLLIDER_TYPE(collider_b);
+    if (type_a == ERR || type_b == ERR) {
+        return false;
+    } else if (type_a == CIRCLE && type_b == CIRCLE) {
+        return EcsPhysis2dToi_circleCircle(COLLIDER_DATA(collider_a), sweep_a, COLLIDER_DATA(collider_b), sweep_b, toi_out);
+    } else if (type_a == CIRCLE && (type_b == POLYGON || type_b == BOX)) {
+        return EcsPhysis2dToi_circlePolygon(COLLIDER_DATA(collider_a), sweep_a, COLLIDER_DATA(collider_b), sweep_b, true, toi_out);
+    } else if (type_b == CIRCLE && (type_a == POLYGON || type_a == BOX)) {
+        return EcsPhysis2dToi_circlePolygon(COLLIDER_DATA(collider_b), sweep_b, COLLIDER_DATA(collider_a), sweep_a, false, toi_out);
+    }
+    return EcsPhysis2dToi_conservativeAdvancement(COLLIDER_DATA(collider_a), sweep_a, COLLIDER_DATA(collider_b), sweep_b, toi_out);
+}
+
+/*
+ * Ray of a relative to b against a circle with both radii.
+ */
+static int8_t EcsPhysis2dToi_circleCircle(
+    ColliderData_t *circle_a, EcsSweep *sweep_a,
+    ColliderData_t *circle_b, EcsSweep *sweep_b,
+    EcsToiInfo *toi_out)
+{
+    EcsVector2D start_a, start_b, motion_a, motion_b;
+    EcsVector2D origin, motion, center = {0, 0};
+    EcsPhysis2dToi_getPosition(circle_a, sweep_a, 0, &start_a);
+    EcsPhysis2dToi_getPosition(circle_b, sweep_b, 0, &start_b);
+    EcsPhysis2dToi_getMotion(sweep_a, &motion_a);
+    EcsPhysis2dToi_getMotion(sweep_b, &motion_b);
+    EcsVector2D_sub(&start_a, &start_b, &origin);
+    EcsVector2D_sub(&motion_a, &motion_b, &motion);
+
+    float radius_b = circle_b->circle->radius;
+    float t = EcsPhysis2dToi_raycastCircle(&origin, &motion, &center, circle_a->circle->radius + radius_b);
+    if (t > 1) {
+        return false;
+    }
+    // origin becomes the center of a relative to b at t
+    VECTOR_X(&origin) += VECTOR_X(&motion) * t;
+    VECTOR_Y(&origin) += VECTOR_Y(&motion) * t;
+    if (!EcsVector2D_normalize(&origin, &origin)) {
+        VECTOR_X(&origin) = -1;
+        VECTOR_Y(&origin) = 0;
+    }
+    toi_out->time = t;
+    EcsVector2D_scale(&origin, -1, &toi_out->normal);
+    EcsPhysis2dToi_getPosition(circle_b, sweep_b, t, &toi_out->point);
+    VECTOR_X(&toi_out->point) += VECTOR_X(&origin) * radius_b;
+    VECTOR_Y(&toi_out->point) += VECTOR_Y(&origin) * radius_b;
+    return true;
+}
+
+/*
+ * Ray of the circle center against the polygon grown by the radius, in the
+ * local frame of the polygon: edges moved out along their normals and a
+ * circle at every vertex. Boxes go through their corners. invert is true
+ * when the circle is collider a.
+ */
+static int8_t EcsPhysis2dToi_circlePolygon(
+    ColliderData_t *circle, EcsSweep *sweep_circle,
+    ColliderData_t *polygon, EcsSweep *sweep_polygon,
+    int8_t invert,
+    EcsToiInfo *toi_out)
+{
+    EcsPoint circle_start;
+    EcsPoint polygon_start;
+    EcsPhysis2dToi_getPosition(circle, sweep_circle, 0, &circle_start);
+    EcsPhysis2dToi_getPosition(polygon, sweep_polygon, 0, &polygon_start);
+    ColliderData_t view_circle = *circle;
+    ColliderData_t view_polygon = *polygon;
+    view_circle.position = &circle_start;
+    view_polygon.position = &polygon_start;
+    if (invert ? EcsPhysis2dToi_overlap(&view_circle, &view_polygon, toi_out) :
+                 EcsPhysis2dToi_overlap(&view_polygon, &view_circle, toi_out)) {
+        return true;
+    }
+
+    PolygonVertices_t vertices;
+    EcsTransform identity = {{0, 0}, EcsRotation_Identity()};
+    EcsTransform transform;
+    EcsVector2D origin, motion, motion_polygon;
+    EcsPoint corners[4];
+    float core_radius;
+    if (!EcsPhysis2d_getCoreVertices(NULL, polygon, &identity, corners, NULL, &vertices, &core_radius) || vertices.size <= 0) {
+        return false;
+    }
+    EcsPhysis2d_getTransform(&view_polygon, &transform);
+    EcsTransform_invApply(&transform, &circle_start, &origin);
+    EcsPhysis2dToi_getMotion(sweep_circle, &motion);
+    EcsPhysis2dToi_getMotion(sweep_polygon, &motion_polygon);
+    EcsVector2D_sub(&motion, &motion_polygon, &motion);
+    EcsRotation_invRotate(&transform.rotation, &motion, &motion);
+
+    int32_t size = vertices.size;
+    EcsPoint *points = vertices.points;
+    float radius = circle->circle->radius;
+    float winding = EcsPhysis2d_getWinding(&vertices);
+    float best = INFINITY;
+    EcsVector2D normal = {0, 0};
+
+    for (int32_t i = 0; i < size && size > 1; i++) {
+        EcsVector2D edge_normal;
+        EcsVector2D offset;
+        EcsPhysis2d_getOutwardNormal(&vertices, winding, i, &edge_normal);
+        float closing = EcsVector2D_dot(&edge_normal, &motion);
+        if (closing >= 0) {
+            continue;
+        }
+        EcsVector2D_sub(&origin, &points[i], &offset);
+        float t = (radius - EcsVector2D_dot(&edge_normal, &offset)) / closing;
+        if (t < 0 || t >= best) {
+            continue;
+        }
+        // Hit point must fall between the ends of the edge
+        EcsVector2D edge;
+        EcsVector2D_sub(&points[(i+1) < size ? (i+1) : 0], &points[i], &edge);
+        VECTOR_X(&offset) += VECTOR_X(&motion) * t;
+        VECTOR_Y(&offset) += VECTOR_Y(&motion) * t;
+        float along = EcsVector2D_dot(&offset, &edge);
+        if (along < 0 || along > EcsVector2D_dot(&edge, &edge)) {
+            continue;
+        }
+        best = t;
+        VECTOR_X(&normal) = VECTOR_X(&edge_normal);
+        VECTOR_Y(&normal) = VECTOR_Y(&edge_normal);
+    }
+    for (int32_t i = 0; i < size; i++) {
+        float t = EcsPhysis2dToi_raycastCircle(&origin, &motion, &points[i], radius);
+        if (t >= best) {
+            continue;
+        }
+        EcsVector2D hit = {
+            VECTOR_X(&origin) + VECTOR_X(&motion) * t - VECTOR_X(&points[i]),
+            VECTOR_Y(&origin) + VECTOR_Y(&motion) * t - VECTOR_Y(&points[i])
+        };
+        if (EcsVector2D_normalize(&hit, &normal)) {
+            best = t;
+        }
+    }
+    if (best > 1) {
+        return false;
+    }
+
+    // Contact on the polygon surface, normal from the polygon to the circle
+    EcsVector2D point = {
+        VECTOR_X(&origin) + VECTOR_X(&motion) * best - VECTOR_X(&normal) * radius,
+        VECTOR_Y(&origin) + VECTOR_Y(&motion) * best - VECTOR_Y(&normal) * radius
+    };
+    EcsPhysis2dToi_getPosition(polygon, sweep_polygon, best, &transform.position);
+    EcsTransform_apply(&transform, &point, &toi_out->point, 1);
+    EcsRotation_rotate(&transform.rotation, &normal, &toi_out->normal);
+    if (invert) {
+        EcsVector2D_scale(&toi_out->normal, -1, &toi_out->normal);
+    }
+    toi_out->time = best;
+    return true;
+}
+
+/*
+ * Advances both colliders by the largest step that can not close the GJK
+ * distance, until they are closer than TOI_TOLERANCE. With translation only
+ * the distance is convex in t, so the steps never pass the first contact.
+ */
+static int8_t EcsPhysis2dToi_conservativeAdvancement(
+    ColliderData_t *collider_a, EcsSweep *sweep_a,
+    ColliderData_t *collider_b, EcsSweep *sweep_b,
+    EcsToiInfo *toi_out)
+{
+    EcsPoint position_a;
+    EcsPoint position_b;
+    EcsVector2D motion_a, motion_b, motion;
+    ColliderData_t view_a = *collider_a;
+    ColliderData_t view_b = *collider_b;
+    view_a.position = &position_a;
+    view_b.position = &position_b;
+    EcsPhysis2dToi_getMotion(sweep_a, &motion_a);
+    EcsPhysis2dToi_getMotion(sweep_b, &motion_b);
+    EcsVector2D_sub(&motion_a, &motion_b, &motion);
+
+    float t = 0;
+    for (int32_t i = 0; i < TOI_MAX_ITERATIONS; i++) {
+        EcsDistanceInfo info;
+        EcsPhysis2dToi_getPosition(collider_a, sweep_a, t, &position_a);
+        EcsPhysis2dToi_getPosition(collider_b, sweep_b, t, &position_b);
+        if (!EcsPhysis2dDistance(NULL, (EcsColliderData*)&view_a, (EcsColliderData*)&view_b, &info)) {
+            return false;
+        }
+        if (info.distance <= 0) {
+            return i == 0 ? EcsPhysis2dToi_overlap(&view_a, &view_b, toi_out) : false;
+        }
+
+        EcsVector2D normal;
+        EcsVector2D_sub(&info.point_b, &info.point_a, &normal);
+        EcsVector2D_scale(&normal, 1.0f / info.distance, &normal);
+        if (info.distance <= TOI_TOLERANCE) {
+            toi_out->time = t;
+            VECTOR_X(&toi_out->normal) = VECTOR_X(&normal);
+            VECTOR_Y(&toi_out->normal) = VECTOR_Y(&normal);
+            VECTOR_X(&toi_out->point) = (VECTOR_X(&info.point_a) + VECTOR_X(&info.point_b)) * 0.5f;
+            VECTOR_Y(&toi_out->point) = (VECTOR_Y(&info.point_a) + VECTOR_Y(&info.point_b)) * 0.5f;
+            return true;
+        }
+        float closing = EcsVector2D_dot(&motion, &normal);
+        if (closing <= 0) {
+            return false;
+        }
+        t += (info.distance - TOI_TOLERANCE * 0.5f) / closing;
+        if (t > 1) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*
+ * Fills toi_out with time 0 when the colliders overlap at their start.
+ */
+static int8_t EcsPhysis2dToi_overlap(
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsToiInfo *toi_out)
+{
+    EcsCollisionInfo info;
+    EcsDistanceInfo distance;
+    if (!EcsPhysis2dGjk_collide(NULL, collider_a, collider_b, &info)) {
+        return false;
+    }
+    // direction moves a out of b, the normal goes from a to b
+    toi_out->time = 0;
+    EcsVector2D_scale(&info.direction, -1, &toi_out->normal);
+    EcsPhysis2dDistance(NULL, (EcsColliderData*)collider_a, (EcsColliderData*)collider_b, &distance);
+    VECTOR_X(&toi_out->point) = (VECTOR_X(&distance.point_a) + VECTOR_X(&distance.point_b)) * 0.5f;
+    VECTOR_Y(&toi_out->point) = (VECTOR_Y(&distance.point_a) + VECTOR_Y(&distance.point_b)) * 0.5f;
+    return true;
+}
+
+/*
+ * First t >= 0 where origin + motion * t is radius away from center, 0 when
+ * it starts inside and INFINITY when it never gets there.
+ */
+static float EcsPhysis2dToi_raycastCircle(
+    EcsVector2D *origin, EcsVector2D *motion,
+    EcsVector2D *center, float radius)
+{
+    EcsVector2D offset;
+    EcsVector2D_sub(origin, center, &offset);
+    float c = EcsVector2D_dot(&offset, &offset) - radius * radius;
+    if (c <= 0) {
+        return 0;
+    }
+    float b = EcsVector2D_dot(&offset, motion);
+    float a = EcsVector2D_dot(motion, motion);
+    if (b >= 0 || a <= 0) {
+        return INFINITY;
+    }
+    float discriminant = b * b - a * c;
+    if (discriminant < 0) {
+        return INFINITY;
+    }
+    return (-b - sqrtf(discriminant)) / a;
+}
+
+static void EcsPhysis2dToi_getPosition(
+    ColliderData_t *collider, EcsSweep *sweep, float t,
+    EcsVector2D *out)
+{
+    if (sweep == NULL) {
+        VECTOR_X(out) = VECTOR_X(collider->position);
+        VECTOR_Y(out) = VECTOR_Y(collider->position);
+        return;
+    }
+    VECTOR_X(out) = VECTOR_X(&sweep->start) + (VECTOR_X(&sweep->end) - VECTOR_X(&sweep->start)) * t;
+    VECTOR_Y(out) = VECTOR_Y(&sweep->start) + (VECTOR_Y(&sweep->end) - VECTOR_Y(&sweep->start)) * t;
+}
+
+static void EcsPhysis2dToi_getMotion(EcsSweep *sweep, EcsVector2D *out)
+{
+    if (sweep == NULL) {
+        VECTOR_X(out) = 0;
+        VECTOR_Y(out) = 0;
+        return;
+    }
+    EcsVector2D_sub(&sweep->end, &sweep->start, out);
+}
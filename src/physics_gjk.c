@@ -0,0 +1,648 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <math.h>
+
+#define GJK_MAX_ITERATIONS 32
+#define EPA_MAX_ITERATIONS 32
+#define EPA_MAX_VERTICES (EPA_MAX_ITERATIONS + 3)
+#define EPA_TOLERANCE 1e-4f
+#define GJK_EPSILON 1e-6f
+
+typedef struct GjkProxy GjkProxy_t;
+typedef int32_t (*GjkSupportFunction)(GjkProxy_t *proxy, EcsVector2D *direction);
+
+/*
+ * Convex core of a shape plus a radius around it
+ *  support: Index of the point of points furthest along a direction
+ *  vertices: Core of the shape, see EcsPhysis2d_getCoreVertices, released
+ *            with the proxy
+ */
+struct GjkProxy {
+    EcsPoint *points;
+    int32_t count;
+    float radius;
+    GjkSupportFunction support;
+    PolygonVertices_t vertices;
+};
+
+typedef struct GjkSimplexVertex {
+    EcsVector2D wa;
+    EcsVector2D wb;
+    EcsVector2D w; // wb - wa
+    float a; // Barycentric coordinate of the closest point
+    int32_t index_a;
+    int32_t index_b;
+} GjkSimplexVertex_t;
+
+typedef struct GjkSimplex {
+    GjkSimplexVertex_t v[3];
+    int32_t count;
+} GjkSimplex_t;
+
+static int32_t EcsGjk_supportPoint(GjkProxy_t *proxy, EcsVector2D *direction);
+static int32_t EcsGjk_supportPoints(GjkProxy_t *proxy, EcsVector2D *direction);
+static int32_t EcsGjk_supportExtreme(GjkProxy_t *proxy, EcsVector2D *direction);
+static int8_t EcsGjk_makeProxies(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    EcsTransform *frame_out);
+static int8_t EcsGjk_makeProxy(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    GjkProxy_t *out);
+static int8_t EcsGjk_collideProxies(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    EcsCollisionInfo *collision_out);
+static void EcsGjk_distance(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    GjkSimplex_t *simplex,
+    EcsDistanceInfo *out);
+static void EcsGjk_solve2(GjkSimplex_t *simplex);
+static void EcsGjk_solve3(GjkSimplex_t *simplex);
+static void EcsGjk_getSearchDirection(GjkSimplex_t *simplex, EcsVector2D *out);
+static void EcsGjk_getWitnessPoints(GjkSimplex_t *simplex, EcsPoint *point_a, EcsPoint *point_b);
+static void EcsGjk_getSupport(GjkProxy_t *proxy_a, GjkProxy_t *proxy_b, EcsVector2D *direction, EcsVector2D *out);
+static int32_t EcsEpa_removeReflex(EcsVector2D *polytope, int32_t count);
+static float EcsEpa_penetration(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    GjkSimplex_t *simplex,
+    EcsVector2D *normal_out);
+
+int8_t EcsPhysis2dCollisionCheckGjk(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a,
+    EcsColliderData *collider_b,
+    EcsCollisionInfo *collision_out)
+{
+    if (collider_a == NULL || collider_b == NULL || collision_out == NULL ||
+        GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL ||
+        GET_COLLIDER_TYPE(collider_a) == ERR || GET_COLLIDER_TYPE(collider_b) == ERR) {
+        return false;
+    }
+    return EcsPhysis2dGjk_collide(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), collision_out);
+}
+
+int8_t EcsPhysis2dDistance(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a,
+    EcsColliderData *collider_b,
+    EcsDistanceInfo *distance_out)
+{
+    if (collider_a == NULL || collider_b == NULL || distance_out == NULL ||
+        GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL ||
+        GET_COLLIDER_TYPE(collider_a) == ERR || GET_COLLIDER_TYPE(collider_b) == ERR) {
+        return false;
+    }
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    GjkProxy_t proxy_a;
+    GjkProxy_t proxy_b;
+    GjkSimplex_t simplex;
+    EcsTransform frame;
+    if (!EcsGjk_makeProxies(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b),
+            buffer_a, soa_a, buffer_b, soa_b, &proxy_a, &proxy_b, &frame)) {
+        return false;
+    }
+    EcsGjk_distance(&proxy_a, &proxy_b, &simplex, distance_out);
+    EcsPhysis2d_releaseWorldVertices(&proxy_a.vertices);
+    EcsPhysis2d_releaseWorldVertices(&proxy_b.vertices);
+
+    // Move the closest points of the cores onto the surfaces
+    float radius_a = proxy_a.radius;
+    float radius_b = proxy_b.radius;
+    float distance = distance_out->distance;
+    if (distance > radius_a + radius_b && distance > GJK_EPSILON) {
+        EcsVector2D normal;
+        EcsVector2D_sub(&distance_out->point_b, &distance_out->point_a, &normal);
+        EcsVector2D_scale(&normal, 1.0f / distance, &normal);
+        VECTOR_X(&distance_out->point_a) += VECTOR_X(&normal) * radius_a;
+        VECTOR_Y(&distance_out->point_a) += VECTOR_Y(&normal) * radius_a;
+        VECTOR_X(&distance_out->point_b) -= VECTOR_X(&normal) * radius_b;
+        VECTOR_Y(&distance_out->point_b) -= VECTOR_Y(&normal) * radius_b;
+        distance_out->distance = distance - radius_a - radius_b;
+    } else {
+        // Overlapping shapes, both points at the middle of the cores
+        VECTOR_X(&distance_out->point_a) = (VECTOR_X(&distance_out->point_a) + VECTOR_X(&distance_out->point_b)) * 0.5f;
+        VECTOR_Y(&distance_out->point_a) = (VECTOR_Y(&distance_out->point_a) + VECTOR_Y(&distance_out->point_b)) * 0.5f;
+        VECTOR_X(&distance_out->point_b) = VECTOR_X(&distance_out->point_a);
+        VECTOR_Y(&distance_out->point_b) = VECTOR_Y(&distance_out->point_a);
+        distance_out->distance = 0;
+    }
+    EcsTransform_apply(&frame, &distance_out->point_a, &distance_out->point_a, 1);
+    EcsTransform_apply(&frame, &distance_out->point_b, &distance_out->point_b, 1);
+    return true;
+}
+
+int8_t EcsPhysis2dGjk_collide(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out)
+{
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    GjkProxy_t proxy_a;
+    GjkProxy_t proxy_b;
+    EcsTransform frame;
+    if (!EcsGjk_makeProxies(ctx, collider_a, collider_b, buffer_a, soa_a, buffer_b, soa_b, &proxy_a, &proxy_b, &frame)) {
+        return false;
+    }
+    int8_t result = EcsGjk_collideProxies(&proxy_a, &proxy_b, collision_out);
+    if (result) {
+        EcsRotation_rotate(&frame.rotation, &collision_out->direction, &collision_out->direction);
+    }
+    EcsPhysis2d_releaseWorldVertices(&proxy_a.vertices);
+    EcsPhysis2d_releaseWorldVertices(&proxy_b.vertices);
+    return result;
+}
+
+static int8_t EcsGjk_collideProxies(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    EcsCollisionInfo *collision_out)
+{
+    GjkSimplex_t simplex;
+    EcsDistanceInfo info;
+    EcsGjk_distance(proxy_a, proxy_b, &simplex, &info);
+
+    float radius = proxy_a->radius + proxy_b->radius;
+    if (info.distance > radius) {
+        return false;
+    }
+    if (info.distance > GJK_EPSILON) {
+        // Cores apart, only the radii overlap
+        EcsVector2D_sub(&info.point_a, &info.point_b, &collision_out->direction);
+        EcsVector2D_scale(&collision_out->direction, 1.0f / info.distance, &collision_out->direction);
+        collision_out->distance = radius - info.distance;
+        return true;
+    }
+
+    EcsVector2D normal;
+    float depth = EcsEpa_penetration(proxy_a, proxy_b, &simplex, &normal);
+    // normal points out of b - a, moving a along it separates the cores
+    VECTOR_X(&collision_out->direction) = VECTOR_X(&normal);
+    VECTOR_Y(&collision_out->direction) = VECTOR_Y(&normal);
+    collision_out->distance = depth + radius;
+    return true;
+}
+
+static int8_t EcsGjk_makeProxies(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    EcsTransform *frame_out)
+{
+    EcsTransform identity = {{0, 0}, EcsRotation_Identity()};
+    EcsTransform relative;
+    EcsTransform *transform_a = NULL;
+    EcsTransform *transform_b = NULL;
+    *frame_out = identity;
+    if (ctx == NULL || ctx->vertex_cache == NULL) {
+        // Local frame of a, only b is transformed
+        EcsPhysis2d_getTransform(collider_a, frame_out);
+        EcsPhysis2d_getTransform(collider_b, &relative);
+        EcsTransform_relative(frame_out, &relative, &relative);
+        transform_a = &identity;
+        transform_b = &relative;
+    }
+    if (!EcsGjk_makeProxy(ctx, collider_a, transform_a, buffer_a, soa_a, proxy_a)) {
+        return false;
+    }
+    if (!EcsGjk_makeProxy(ctx, collider_b, transform_b, buffer_b, soa_b, proxy_b)) {
+        EcsPhysis2d_releaseWorldVertices(&proxy_a->vertices);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * transform moves the collider into the frame of the pair, NULL for world
+ * space.
+ */
+static int8_t EcsGjk_makeProxy(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    GjkProxy_t *out)
+{
+    out->vertices.heap = NULL;
+    if (!EcsPhysis2d_getCoreVertices(ctx, collider, transform, buffer, soa_buffer, &out->vertices, &out->radius) ||
+        out->vertices.size <= 0) {
+        EcsPhysis2d_releaseWorldVertices(&out->vertices);
+        return false;
+    }
+    out->points = out->vertices.points;
+    out->count = out->vertices.size;
+    if (out->count == 1) {
+        out->support = EcsGjk_supportPoint;
+    } else {
+        out->support = out->vertices.supports != NULL ? EcsGjk_supportExtreme : EcsGjk_supportPoints;
+    }
+    return true;
+}
+
+static int32_t EcsGjk_supportPoint(GjkProxy_t *proxy, EcsVector2D *direction)
+{
+    (void)proxy;
+    (void)direction;
+    return 0;
+}
+
+static int32_t EcsGjk_supportExtreme(GjkProxy_t *proxy, EcsVector2D *direction)
+{
+    return EcsPhysis2d_getExtremeVertex(&proxy->vertices, direction);
+}
+
+static int32_t EcsGjk_supportPoints(GjkProxy_t *proxy, EcsVector2D *direction)
+{
+    int32_t best = 0;
+    float best_value = EcsVector2D_dot(&proxy->points[0], direction);
+    for (int32_t i = 1; i < proxy->count; i++) {
+        float value = EcsVector2D_dot(&proxy->points[i], direction);
+        if (value > best_value) {
+            best = i;
+            best_value = value;
+        }
+    }
+    return best;
+}
+
+/*
+ * Closest points of the cores of proxy_a and proxy_b. The final simplex is
+ * left in simplex, it has 3 vertices when the cores overlap.
+ */
+static void EcsGjk_distance(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    GjkSimplex_t *simplex,
+    EcsDistanceInfo *out)
+{
+    GjkSimplexVertex_t *v = &simplex->v[0];
+    v->index_a = 0;
+    v->index_b = 0;
+    VECTOR_X(&v->wa) = VECTOR_X(&proxy_a->points[0]);
+    VECTOR_Y(&v->wa) = VECTOR_Y(&proxy_a->points[0]);
+    VECTOR_X(&v->wb) = VECTOR_X(&proxy_b->points[0]);
+    VECTOR_Y(&v->wb) = VECTOR_Y(&proxy_b->points[0]);
+    EcsVector2D_sub(&v->wb, &v->wa, &v->w);
+    v->a = 1;
+    simplex->count = 1;
+
+    int32_t save_a[3];
+    int32_t save_b[3];
+    for (int32_t iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+        int32_t save_count = simplex->count;
+        for (int32_t i = 0; i < save_count; i++) {
+            save_a[i] = simplex->v[i].index_a;
+            save_b[i] = simplex->v[i].index_b;
+        }
+
+        if (simplex->count == 2) {
+            EcsGjk_solve2(simplex);
+        } else if (simplex->count == 3) {
+            EcsGjk_solve3(simplex);
+        }
+        if (simplex->count == 3) {
+            // Origin inside the triangle
+            break;
+        }
+
+        EcsVector2D direction;
+        EcsGjk_getSearchDirection(simplex, &direction);
+        if (EcsVector2D_dot(&direction, &direction) < GJK_EPSILON * GJK_EPSILON) {
+            // Origin on the simplex
+            break;
+        }
+
+        v = &simplex->v[simplex->count];
+        EcsVector2D negative = {-VECTOR_X(&direction), -VECTOR_Y(&direction)};
+        v->index_a = proxy_a->support(proxy_a, &negative);
+        v->index_b = proxy_b->support(proxy_b, &direction);
+        VECTOR_X(&v->wa) = VECTOR_X(&proxy_a->points[v->index_a]);
+        VECTOR_Y(&v->wa) = VECTOR_Y(&proxy_a->points[v->index_a]);
+        VECTOR_X(&v->wb) = VECTOR_X(&proxy_b->points[v->index_b]);
+        VECTOR_Y(&v->wb) = VECTOR_Y(&proxy_b->points[v->index_b]);
+        EcsVector2D_sub(&v->wb, &v->wa, &v->w);
+
+        // A support point already in the simplex means no progress
+        int8_t duplicate = false;
+        for (int32_t i = 0; i < save_count; i++) {
+            if (v->index_a == save_a[i] && v->index_b == save_b[i]) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            break;
+        }
+        simplex->count++;
+    }
+
+    EcsGjk_getWitnessPoints(simplex, &out->point_a, &out->point_b);
+    out->distance = simplex->count == 3 ? 0 : EcsVector2D_distance(&out->point_a, &out->point_b);
+}
+
+static void EcsGjk_solve2(GjkSimplex_t *simplex)
+{
+    EcsVector2D *w1 = &simplex->v[0].w;
+    EcsVector2D *w2 = &simplex->v[1].w;
+    EcsVector2D e12;
+    EcsVector2D_sub(w2, w1, &e12);
+
+    float d12_2 = -EcsVector2D_dot(w1, &e12);
+    if (d12_2 <= 0) {
+        simplex->v[0].a = 1;
+        simplex->count = 1;
+        return;
+    }
+    float d12_1 = EcsVector2D_dot(w2, &e12);
+    if (d12_1 <= 0) {
+        simplex->v[1].a = 1;
+        simplex->count = 1;
+        simplex->v[0] = simplex->v[1];
+        return;
+    }
+    float inv = 1.0f / (d12_1 + d12_2);
+    simplex->v[0].a = d12_1 * inv;
+    simplex->v[1].a = d12_2 * inv;
+    simplex->count = 2;
+}
+
+#define CROSS(a, b) (VECTOR_X(a) * VECTOR_Y(b) - VECTOR_Y(a) * VECTOR_X(b))
+
+static void EcsGjk_solve3(GjkSimplex_t *simplex)
+{
+    EcsVector2D *w1 = &simplex->v[0].w;
+    EcsVector2D *w2 = &simplex->v[1].w;
+    EcsVector2D *w3 = &simplex->v[2].w;
+    EcsVector2D e12, e13, e23;
+    EcsVector2D_sub(w2, w1, &e12);
+    EcsVector2D_sub(w3, w1, &e13);
+    EcsVector2D_sub(w3, w2, &e23);
+
+    float d12_1 = EcsVector2D_dot(w2, &e12);
+    float d12_2 = -EcsVector2D_dot(w1, &e12);
+    float d13_1 = EcsVector2D_dot(w3, &e13);
+    float d13_2 = -EcsVector2D_dot(w1, &e13);
+    float d23_1 = EcsVector2D_dot(w3, &e23);
+    float d23_2 = -EcsVector2D_dot(w2, &e23);
+
+    float n123 = CROSS(&e12, &e13);
+    float d123_1 = n123 * CROSS(w2, w3);
+    float d123_2 = n123 * CROSS(w3, w1);
+    float d123_3 = n123 * CROSS(w1, w2);
+
+    if (d12_2 <= 0 && d13_2 <= 0) {
+        simplex->v[0].a = 1;
+        simplex->count = 1;
+        return;
+    }
+    if (d12_1 > 0 && d12_2 > 0 && d123_3 <= 0) {
+        float inv = 1.0f / (d12_1 + d12_2);
+        simplex->v[0].a = d12_1 * inv;
+        simplex->v[1].a = d12_2 * inv;
+        simplex->count = 2;
+        return;
+    }
+    if (d13_1 > 0 && d13_2 > 0 && d123_2 <= 0) {
+        float inv = 1.0f / (d13_1 + d13_2);
+        simplex->v[0].a = d13_1 * inv;
+        simplex->v[2].a = d13_2 * inv;
+        simplex->count = 2;
+        simplex->v[1] = simplex->v[2];
+        return;
+    }
+    if (d12_1 <= 0 && d23_2 <= 0) {
+        simplex->v[1].a = 1;
+        simplex->count = 1;
+        simplex->v[0] = simplex->v[1];
+        return;
+    }
+    if (d13_1 <= 0 && d23_1 <= 0) {
+        simplex->v[2].a = 1;
+        simplex->count = 1;
+        simplex->v[0] = simplex->v[2];
+        return;
+    }
+    if (d23_1 > 0 && d23_2 > 0 && d123_1 <= 0) {
+        float inv = 1.0f / (d23_1 + d23_2);
+        simplex->v[1].a = d23_1 * inv;
+        simplex->v[2].a = d23_2 * inv;
+        simplex->count = 2;
+        simplex->v[0] = simplex->v[2];
+        return;
+    }
+    float inv = 1.0f / (d123_1 + d123_2 + d123_3);
+    simplex->v[0].a = d123_1 * inv;
+    simplex->v[1].a = d123_2 * inv;
+    simplex->v[2].a = d123_3 * inv;
+    simplex->count = 3;
+}
+
+/* Direction from the simplex towards the origin */
+static void EcsGjk_getSearchDirection(GjkSimplex_t *simplex, EcsVector2D *out)
+{
+    EcsVector2D *w1 = &simplex->v[0].w;
+    if (simplex->count == 1) {
+        VECTOR_X(out) = -VECTOR_X(w1);
+        VECTOR_Y(out) = -VECTOR_Y(w1);
+        return;
+    }
+    EcsVector2D e12;
+    EcsVector2D_sub(&simplex->v[1].w, w1, &e12);
+    EcsVector2D negative = {-VECTOR_X(w1), -VECTOR_Y(w1)};
+    if (CROSS(&e12, &negative) > 0) {
+        // Origin left of e12
+        VECTOR_X(out) = -VECTOR_Y(&e12);
+        VECTOR_Y(out) = VECTOR_X(&e12);
+    } else {
+        VECTOR_X(out) = VECTOR_Y(&e12);
+        VECTOR_Y(out) = -VECTOR_X(&e12);
+    }
+}
+
+static void EcsGjk_getWitnessPoints(GjkSimplex_t *simplex, EcsPoint *point_a, EcsPoint *point_b)
+{
+    VECTOR_X(point_a) = 0;
+    VECTOR_Y(point_a) = 0;
+    VECTOR_X(point_b) = 0;
+    VECTOR_Y(point_b) = 0;
+    for (int32_t i = 0; i < simplex->count; i++) {
+        GjkSimplexVertex_t *v = &simplex->v[i];
+        VECTOR_X(point_a) += v->a * VECTOR_X(&v->wa);
+        VECTOR_Y(point_a) += v->a * VECTOR_Y(&v->wa);
+        VECTOR_X(point_b) += v->a * VECTOR_X(&v->wb);
+        VECTOR_Y(point_b) += v->a * VECTOR_Y(&v->wb);
+    }
+    if (simplex->count == 3) {
+        VECTOR_X(point_b) = VECTOR_X(point_a);
+        VECTOR_Y(point_b) = VECTOR_Y(point_a);
+    }
+}
+
+/* Support point of the core of b - a */
+static void EcsGjk_getSupport(GjkProxy_t *proxy_a, GjkProxy_t *proxy_b, EcsVector2D *direction, EcsVector2D *out)
+{
+    EcsVector2D negative = {-VECTOR_X(direction), -VECTOR_Y(direction)};
+    int32_t index_a = proxy_a->support(proxy_a, &negative);
+    int32_t index_b = proxy_b->support(proxy_b, direction);
+    EcsVector2D_sub(&proxy_b->points[index_b], &proxy_a->points[index_a], out);
+}
+
+/*
+ * Expanding polytope: penetration depth of the cores, starting from the
+ * final GJK simplex. normal_out is the direction that moves a out of b.
+ */
+static float EcsEpa_penetration(
+    GjkProxy_t *proxy_a,
+    GjkProxy_t *proxy_b,
+    GjkSimplex_t *simplex,
+    EcsVector2D *normal_out)
+{
+    EcsVector2D polytope[EPA_MAX_VERTICES];
+    int32_t count = simplex->count;
+    for (int32_t i = 0; i < count; i++) {
+        VECTOR_X(&polytope[i]) = VECTOR_X(&simplex->v[i].w);
+        VECTOR_Y(&polytope[i]) = VECTOR_Y(&simplex->v[i].w);
+    }
+
+    // Touching cores leave a point or a segment, grow it into a triangle
+    static const EcsVector2D directions[4] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+    for (int32_t i = 0; count == 1 && i < 4; i++) {
+        EcsGjk_getSupport(proxy_a, proxy_b, (EcsVector2D*)&directions[i], &polytope[1]);
+        if (EcsVector2D_distanceSqrt(&polytope[0], &polytope[1]) > GJK_EPSILON * GJK_EPSILON) {
+            count = 2;
+        }
+    }
+    if (count == 2) {
+        EcsVector2D edge;
+        EcsVector2D_sub(&polytope[1], &polytope[0], &edge);
+        EcsVector2D side = {-VECTOR_Y(&edge), VECTOR_X(&edge)};
+        for (int32_t i = 0; count == 2 && i < 2; i++) {
+            EcsGjk_getSupport(proxy_a, proxy_b, &side, &polytope[2]);
+            EcsVector2D offset;
+            EcsVector2D_sub(&polytope[2], &polytope[0], &offset);
+            if (fabsf(CROSS(&edge, &offset)) > GJK_EPSILON) {
+                count = 3;
+            }
+            EcsVector2D_scale(&side, -1, &side);
+        }
+    }
+    if (count < 3) {
+        // Flat shapes, no area to expand into
+        if (count == 2) {
+            EcsVector2D edge;
+            EcsVector2D_sub(&polytope[1], &polytope[0], &edge);
+            VECTOR_X(normal_out) = -VECTOR_Y(&edge);
+            VECTOR_Y(normal_out) = VECTOR_X(&edge);
+            EcsVector2D_normalize(normal_out, normal_out);
+        } else {
+            VECTOR_X(normal_out) = 1;
+            VECTOR_Y(normal_out) = 0;
+        }
+        return 0;
+    }
+
+    // Counter clockwise order, edge normals (y, -x) point outwards
+    EcsVector2D e01, e02;
+    EcsVector2D_sub(&polytope[1], &polytope[0], &e01);
+    EcsVector2D_sub(&polytope[2], &polytope[0], &e02);
+    if (CROSS(&e01, &e02) < 0) {
+        EcsVector2D tmp = {VECTOR_X(&polytope[1]), VECTOR_Y(&polytope[1])};
+        VECTOR_X(&polytope[1]) = VECTOR_X(&polytope[2]);
+        VECTOR_Y(&polytope[1]) = VECTOR_Y(&polytope[2]);
+        VECTOR_X(&polytope[2]) = VECTOR_X(&tmp);
+        VECTOR_Y(&polytope[2]) = VECTOR_Y(&tmp);
+    }
+
+    EcsVector2D normal = {1, 0};
+    float depth = 0;
+    for (int32_t iteration = 0; iteration < EPA_MAX_ITERATIONS; iteration++) {
+        // Edge of the polytope closest to the origin
+        int32_t closest = 0;
+        depth = INFINITY;
+        for (int32_t i = 0; i < count; i++) {
+            EcsVector2D *p1 = &polytope[i];
+            EcsVector2D *p2 = &polytope[(i+1) < count ? (i+1) : 0];
+            EcsVector2D edge_normal = {VECTOR_Y(p2) - VECTOR_Y(p1), VECTOR_X(p1) - VECTOR_X(p2)};
+            if (!EcsVector2D_normalize(&edge_normal, &edge_normal)) {
+                continue;
+            }
+            float distance = EcsVector2D_dot(&edge_normal, p1);
+            if (distance < depth) {
+                depth = distance;
+                closest = i;
+                VECTOR_X(&normal) = VECTOR_X(&edge_normal);
+                VECTOR_Y(&normal) = VECTOR_Y(&edge_normal);
+            }
+        }
+
+        EcsVector2D support;
+        EcsGjk_getSupport(proxy_a, proxy_b, &normal, &support);
+        float distance = EcsVector2D_dot(&support, &normal);
+        if (distance - depth <= EPA_TOLERANCE * (1 + fabsf(depth)) || count == EPA_MAX_VERTICES) {
+            break;
+        }
+        for (int32_t i = count; i > closest + 1; i--) {
+            VECTOR_X(&polytope[i]) = VECTOR_X(&polytope[i-1]);
+            VECTOR_Y(&polytope[i]) = VECTOR_Y(&polytope[i-1]);
+        }
+        VECTOR_X(&polytope[closest + 1]) = VECTOR_X(&support);
+        VECTOR_Y(&polytope[closest + 1]) = VECTOR_Y(&support);
+        count++;
+        count = EcsEpa_removeReflex(polytope, count);
+    }
+
+    VECTOR_X(normal_out) = VECTOR_X(&normal);
+    VECTOR_Y(normal_out) = VECTOR_Y(&normal);
+    return depth;
+}
+
+/*
+ * The first GJK vertex is not a support point and can end up inside the
+ * polytope, removing the reflex vertices keeps the polytope convex.
+ */
+static int32_t EcsEpa_removeReflex(EcsVector2D *polytope, int32_t count)
+{
+    int32_t i = 0;
+    int32_t checked = 0;
+    while (count > 3 && checked < count) {
+        EcsVector2D *prev = &polytope[(i + count - 1) % count];
+        EcsVector2D *next = &polytope[(i + 1) % count];
+        EcsVector2D e1, e2;
+        EcsVector2D_sub(&polytope[i], prev, &e1);
+        EcsVector2D_sub(next, &polytope[i], &e2);
+        if (CROSS(&e1, &e2) > 0) {
+            i = (i + 1) % count;
+            checked++;
+            continue;
+        }
+        for (int32_t j = i; j < count - 1; j++) {
+            VECTOR_X(&polytope[j]) = VECTOR_X(&polytope[j+1]);
+            VECTOR_Y(&polytope[j]) = VECTOR_Y(&polytope[j+1]);
+        }
+        count--;
+        i = (i + count - 1) % count;
+        checked = 0;
+    }
+    return count;
+}
@@ -0,0 +1,484 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <math.h>
+
+// Feature id: 14 bits per index, 2 bits per feature type
+#define FEATURE_VERTEX 0
+#define FEATURE_FACE 1
+#define CONTACT_ID(index_a, index_b, type_a, type_b) \
+    (((uint32_t)(index_a) & 0x3FFF) | (((uint32_t)(index_b) & 0x3FFF) << 14) | \
+     ((uint32_t)(type_a) << 28) | ((uint32_t)(type_b) << 30))
+
+// Keeps the reference face stable when both separations are close
+#define RELATIVE_TOLERANCE 0.98f
+#define ABSOLUTE_TOLERANCE 0.001f
+// Cores apart by more than the face separation plus this touch by a vertex
+#define ROUNDED_TOLERANCE 0.005f
+
+typedef struct ClipVertex {
+    EcsVector2D v;
+    int32_t index_a;
+    int32_t index_b;
+    int8_t type_a;
+    int8_t type_b;
+} ClipVertex_t;
+
+static int8_t EcsPhysis2dManifoldCircleCircle(
+    ColliderData_t *circle_a,
+    ColliderData_t *circle_b,
+    EcsContactManifold *manifold_out);
+static int8_t EcsPhysis2dManifoldCirclePolygon(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    int8_t circle_is_a,
+    EcsContactManifold *manifold_out);
+static int8_t EcsPhysis2dManifoldPolygonPolygon(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a,
+    ColliderData_t *polygon_b,
+    EcsContactManifold *manifold_out);
+static int8_t EcsPhysis2dManifoldPolygonPolygonVertices(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsContactManifold *manifold_out);
+static int8_t EcsPhysis2dManifoldRounded(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsContactManifold *manifold_out);
+static int8_t EcsPhysis2dManifold_closestFeatures(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsContactManifold *manifold_out);
+static float EcsPhysis2dManifold_findMaxSeparation(
+    PolygonVertices_t *vertices_a, float winding_a,
+    PolygonVertices_t *vertices_b,
+    int32_t *edge_out);
+static int32_t EcsPhysis2dManifold_clipSegment(
+    ClipVertex_t *out,
+    ClipVertex_t *in,
+    EcsVector2D *normal, float offset,
+    int32_t reference_vertex);
+
+int8_t EcsPhysis2dCollisionManifold(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData *collider_a,
+    EcsColliderData *collider_b,
+    EcsContactManifold *manifold_out)
+{
+    if (collider_a == NULL || collider_b == NULL || manifold_out == NULL ||
+        GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL) {
+        return false;
+    }
+    manifold_out->points_count = 0;
+
+    int8_t type_a = GET_COLLIDER_TYPE(collider_a);
+    int8_t type_b = GET_COLLIDER_TYPE(collider_b);
+
+    if (type_a == ERR || type_b == ERR) {
+        return false;
+    } else if (IS_PRIMITIVE(type_a) || IS_PRIMITIVE(type_b)) {
+        return EcsPhysis2dManifoldRounded(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), manifold_out);
+    } else if (type_a == type_b) {
+        if (type_a == CIRCLE) {
+            return EcsPhysis2dManifoldCircleCircle(COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), manifold_out);
+        }
+        return EcsPhysis2dManifoldPolygonPolygon(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), manifold_out);
+    }
+    return EcsPhysis2dManifoldCirclePolygon(ctx, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), type_a == CIRCLE, manifold_out);
+}
+
+static int8_t EcsPhysis2dManifoldCircleCircle(
+    ColliderData_t *circle_a,
+    ColliderData_t *circle_b,
+    EcsContactManifold *manifold_out)
+{
+    float radius_a = circle_a->circle->radius;
+    float radius_b = circle_b->circle->radius;
+    EcsVector2D delta;
+    EcsVector2D_sub(circle_b->position, circle_a->position, &delta);
+    float distance = EcsVector2D_get_magnitude(&delta);
+    if (distance > radius_a + radius_b) {
+        return false;
+    }
+
+    EcsVector2D *normal = &manifold_out->normal;
+    if (distance > 0) {
+        EcsVector2D_scale(&delta, 1.0f / distance, normal);
+    } else {
+        // Concentric circles, any direction separates them
+        VECTOR_X(normal) = 1;
+        VECTOR_Y(normal) = 0;
+    }
+
+    // Midpoint of the surface point of a and the surface point of b
+    EcsContactPoint *point = &manifold_out->points[0];
+    float offset = (radius_a - radius_b + distance) * 0.5f;
+    VECTOR_X(&point->position) = VECTOR_X(circle_a->position) + VECTOR_X(normal) * offset;
+    VECTOR_Y(&point->position) = VECTOR_Y(circle_a->position) + VECTOR_Y(normal) * offset;
+    point->depth = radius_a + radius_b - distance;
+    point->id = CONTACT_ID(0, 0, FEATURE_VERTEX, FEATURE_VERTEX);
+    manifold_out->points_count = 1;
+    return true;
+}
+
+static int8_t EcsPhysis2dManifoldCirclePolygon(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    int8_t circle_is_a,
+    EcsContactManifold *manifold_out)
+{
+    EcsCollisionInfo info;
+    if (!EcsPhysis2dCollisionCheckWithContext(ctx, (EcsColliderData*)collider_a, (EcsColliderData*)collider_b, &info)) {
+        return false;
+    }
+
+    // info moves a out of b, the manifold normal points from a to b
+    EcsVector2D *normal = &manifold_out->normal;
+    EcsVector2D_scale(&info.direction, -1, normal);
+
+    ColliderData_t *circle = circle_is_a ? collider_a : collider_b;
+    float radius = circle->circle->radius;
+    float depth = info.distance;
+    // Deepest point of the circle, then halfway back to the polygon surface
+    float side = circle_is_a ? 1.0f : -1.0f;
+    float offset = side * (radius - depth * 0.5f);
+
+    EcsContactPoint *point = &manifold_out->points[0];
+    VECTOR_X(&point->position) = VECTOR_X(circle->position) + VECTOR_X(normal) * offset;
+    VECTOR_Y(&point->position) = VECTOR_Y(circle->position) + VECTOR_Y(normal) * offset;
+    point->depth = depth;
+    point->id = CONTACT_ID(0, 0, FEATURE_VERTEX, FEATURE_VERTEX);
+    manifold_out->points_count = 1;
+    return true;
+}
+
+static int8_t EcsPhysis2dManifoldPolygonPolygon(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a,
+    ColliderData_t *polygon_b,
+    EcsContactManifold *manifold_out)
+{
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    PolygonVertices_t vertices_a;
+    PolygonVertices_t vertices_b;
+    EcsTransform frame;
+    if (!EcsPhysis2d_getPairVertices(ctx, polygon_a, polygon_b, buffer_a, soa_a, buffer_b, soa_b, &vertices_a, &vertices_b, &frame)) {
+        return false;
+    }
+    int8_t result = false;
+    if (vertices_a.size >= 2 && vertices_b.size >= 2) {
+        result = EcsPhysis2dManifoldPolygonPolygonVertices(&vertices_a, 0, &vertices_b, 0, manifold_out);
+    }
+    if (result) {
+        EcsRotation_rotate(&frame.rotation, &manifold_out->normal, &manifold_out->normal);
+        for (int32_t i = 0; i < manifold_out->points_count; i++) {
+            EcsTransform_apply(&frame, &manifold_out->points[i].position, &manifold_out->points[i].position, 1);
+        }
+    }
+    EcsPhysis2d_releaseWorldVertices(&vertices_a);
+    EcsPhysis2d_releaseWorldVertices(&vertices_b);
+    return result;
+}
+
+/*
+ * Pairs with a capsule or a box, on the cores of both colliders. A core that
+ * is a single point (circles, capsules with both ends the same) gets one
+ * point on its surface like circles do, the others are clipped with their
+ * radius around them.
+ */
+static int8_t EcsPhysis2dManifoldRounded(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsContactManifold *manifold_out)
+{
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    PolygonVertices_t vertices_a;
+    PolygonVertices_t vertices_b;
+    float radius_a;
+    float radius_b;
+    EcsTransform frame;
+    if (!EcsPhysis2d_getCorePairVertices(ctx, collider_a, collider_b, buffer_a, soa_a, buffer_b, soa_b,
+            &vertices_a, &radius_a, &vertices_b, &radius_b, &frame)) {
+        return false;
+    }
+    int8_t result = false;
+    EcsCollisionInfo info;
+    if (vertices_a.size <= 0 || vertices_b.size <= 0) {
+        result = false;
+    } else if (vertices_a.size > 1 && vertices_b.size > 1) {
+        result = EcsPhysis2dManifoldPolygonPolygonVertices(&vertices_a, radius_a, &vertices_b, radius_b, manifold_out);
+    } else if (EcsPhysis2dCollisionCheckWithContext(ctx, (EcsColliderData*)collider_a, (EcsColliderData*)collider_b, &info)) {
+        // info moves a out of b in world space, the normal goes from a to b
+        // in the frame of the cores
+        EcsVector2D *normal = &manifold_out->normal;
+        EcsRotation_invRotate(&frame.rotation, &info.direction, normal);
+        EcsVector2D_scale(normal, -1, normal);
+
+        // Deepest point of the round one, then halfway back to the other
+        int8_t round_is_a = vertices_a.size == 1;
+        EcsPoint *center = round_is_a ? &vertices_a.points[0] : &vertices_b.points[0];
+        float radius = round_is_a ? radius_a : radius_b;
+        float offset = (round_is_a ? 1.0f : -1.0f) * (radius - info.distance * 0.5f);
+        EcsContactPoint *point = &manifold_out->points[0];
+        VECTOR_X(&point->position) = VECTOR_X(center) + VECTOR_X(normal) * offset;
+        VECTOR_Y(&point->position) = VECTOR_Y(center) + VECTOR_Y(normal) * offset;
+        point->depth = info.distance;
+        point->id = CONTACT_ID(0, 0, FEATURE_VERTEX, FEATURE_VERTEX);
+        manifold_out->points_count = 1;
+        result = true;
+    }
+    if (result) {
+        EcsRotation_rotate(&frame.rotation, &manifold_out->normal, &manifold_out->normal);
+        for (int32_t i = 0; i < manifold_out->points_count; i++) {
+            EcsTransform_apply(&frame, &manifold_out->points[i].position, &manifold_out->points[i].position, 1);
+        }
+    }
+    EcsPhysis2d_releaseWorldVertices(&vertices_a);
+    EcsPhysis2d_releaseWorldVertices(&vertices_b);
+    return result;
+}
+
+/*
+ * One point between the closest points of two separated cores, on the
+ * middle of the gap left by the radii.
+ */
+static int8_t EcsPhysis2dManifold_closestFeatures(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsContactManifold *manifold_out)
+{
+    EcsPoint point_a;
+    EcsPoint point_b;
+    float distance = EcsPhysis2dPrimitive_getCoreDistance(vertices_a, vertices_b, &point_a, &point_b);
+    if (distance > radius_a + radius_b || distance <= 0) {
+        return false;
+    }
+    EcsVector2D *normal = &manifold_out->normal;
+    EcsVector2D_sub(&point_b, &point_a, normal);
+    EcsVector2D_scale(normal, 1.0f / distance, normal);
+
+    EcsContactPoint *point = &manifold_out->points[0];
+    float offset = (radius_a - radius_b) * 0.5f;
+    VECTOR_X(&point->position) = (VECTOR_X(&point_a) + VECTOR_X(&point_b)) * 0.5f + VECTOR_X(normal) * offset;
+    VECTOR_Y(&point->position) = (VECTOR_Y(&point_a) + VECTOR_Y(&point_b)) * 0.5f + VECTOR_Y(normal) * offset;
+    point->depth = radius_a + radius_b - distance;
+    point->id = CONTACT_ID(0, 0, FEATURE_VERTEX, FEATURE_VERTEX);
+    manifold_out->points_count = 1;
+    return true;
+}
+
+/*
+ * Cores with the radius around them, 0 for polygons. Cores that only touch
+ * through the radii are clipped as well while a face separates them about
+ * as much as their closest points, otherwise they touch by a vertex and get
+ * one point.
+ */
+static int8_t EcsPhysis2dManifoldPolygonPolygonVertices(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsContactManifold *manifold_out)
+{
+    float winding_a = EcsPhysis2d_getWinding(vertices_a);
+    float winding_b = EcsPhysis2d_getWinding(vertices_b);
+    float radius = radius_a + radius_b;
+
+    int32_t edge_a;
+    float separation_a = EcsPhysis2dManifold_findMaxSeparation(vertices_a, winding_a, vertices_b, &edge_a);
+    if (separation_a > radius) {
+        return false;
+    }
+    int32_t edge_b;
+    float separation_b = EcsPhysis2dManifold_findMaxSeparation(vertices_b, winding_b, vertices_a, &edge_b);
+    if (separation_b > radius) {
+        return false;
+    }
+    float separation_max = separation_a > separation_b ? separation_a : separation_b;
+    if (separation_max > 0) {
+        EcsPoint point_a;
+        EcsPoint point_b;
+        float distance = EcsPhysis2dPrimitive_getCoreDistance(vertices_a, vertices_b, &point_a, &point_b);
+        if (distance > radius) {
+            return false;
+        }
+        if (distance > separation_max + ROUNDED_TOLERANCE) {
+            return EcsPhysis2dManifold_closestFeatures(vertices_a, radius_a, vertices_b, radius_b, manifold_out);
+        }
+    }
+
+    // The reference face is the one of least penetration, prefer a
+    PolygonVertices_t *reference = vertices_a;
+    PolygonVertices_t *incident = vertices_b;
+    float winding_ref = winding_a;
+    float winding_inc = winding_b;
+    float radius_ref = radius_a;
+    float radius_inc = radius_b;
+    int32_t edge = edge_a;
+    int8_t flip = false;
+    if (separation_b > RELATIVE_TOLERANCE * separation_a + ABSOLUTE_TOLERANCE) {
+        reference = vertices_b;
+        incident = vertices_a;
+        winding_ref = winding_b;
+        winding_inc = winding_a;
+        radius_ref = radius_b;
+        radius_inc = radius_a;
+        edge = edge_b;
+        flip = true;
+    }
+
+    EcsVector2D reference_normal;
+    EcsPhysis2d_getOutwardNormal(reference, winding_ref, edge, &reference_normal);
+
+    // Incident edge: the most anti-parallel to the reference normal
+    int32_t incident_edge = 0;
+    float min_dot = INFINITY;
+    for (int32_t i = 0; i < incident->size; i++) {
+        EcsVector2D normal;
+        EcsPhysis2d_getOutwardNormal(incident, winding_inc, i, &normal);
+        float dot = EcsVector2D_dot(&reference_normal, &normal);
+        if (dot < min_dot) {
+            min_dot = dot;
+            incident_edge = i;
+        }
+    }
+    int32_t incident_next = (incident_edge + 1) < incident->size ? (incident_edge + 1) : 0;
+    int32_t edge_next = (edge + 1) < reference->size ? (edge + 1) : 0;
+
+    ClipVertex_t incident_points[2];
+    VECTOR_X(&incident_points[0].v) = VECTOR_X(&incident->points[incident_edge]);
+    VECTOR_Y(&incident_points[0].v) = VECTOR_Y(&incident->points[incident_edge]);
+    incident_points[0].index_a = edge;
+    incident_points[0].index_b = incident_edge;
+    incident_points[0].type_a = FEATURE_FACE;
+    incident_points[0].type_b = FEATURE_VERTEX;
+    VECTOR_X(&incident_points[1].v) = VECTOR_X(&incident->points[incident_next]);
+    VECTOR_Y(&incident_points[1].v) = VECTOR_Y(&incident->points[incident_next]);
+    incident_points[1].index_a = edge;
+    incident_points[1].index_b = incident_next;
+    incident_points[1].type_a = FEATURE_FACE;
+    incident_points[1].type_b = FEATURE_VERTEX;
+
+    EcsPoint *v1 = &reference->points[edge];
+    EcsPoint *v2 = &reference->points[edge_next];
+    EcsVector2D tangent;
+    EcsVector2D_sub(v2, v1, &tangent);
+    EcsVector2D_normalize(&tangent, &tangent);
+    EcsVector2D negative_tangent = {-VECTOR_X(&tangent), -VECTOR_Y(&tangent)};
+
+    // Clip the incident edge against the side planes of the reference edge
+    ClipVertex_t clip1[2];
+    ClipVertex_t clip2[2];
+    float side_offset1 = -EcsVector2D_dot(&tangent, v1);
+    float side_offset2 = EcsVector2D_dot(&tangent, v2);
+    if (EcsPhysis2dManifold_clipSegment(clip1, incident_points, &negative_tangent, side_offset1, edge) < 2 ||
+        EcsPhysis2dManifold_clipSegment(clip2, clip1, &tangent, side_offset2, edge_next) < 2) {
+        return separation_max > 0 &&
+            EcsPhysis2dManifold_closestFeatures(vertices_a, radius_a, vertices_b, radius_b, manifold_out);
+    }
+
+    if (flip) {
+        EcsVector2D_scale(&reference_normal, -1, &manifold_out->normal);
+    } else {
+        VECTOR_X(&manifold_out->normal) = VECTOR_X(&reference_normal);
+        VECTOR_Y(&manifold_out->normal) = VECTOR_Y(&reference_normal);
+    }
+
+    float front_offset = EcsVector2D_dot(&reference_normal, v1);
+    int8_t count = 0;
+    for (int8_t i = 0; i < 2; i++) {
+        float separation = EcsVector2D_dot(&reference_normal, &clip2[i].v) - front_offset;
+        if (separation > radius) {
+            continue;
+        }
+        EcsContactPoint *point = &manifold_out->points[count++];
+        // Halfway between the incident surface and the reference surface
+        float offset = (radius_ref - separation - radius_inc) * 0.5f;
+        VECTOR_X(&point->position) = VECTOR_X(&clip2[i].v) + VECTOR_X(&reference_normal) * offset;
+        VECTOR_Y(&point->position) = VECTOR_Y(&clip2[i].v) + VECTOR_Y(&reference_normal) * offset;
+        point->depth = radius - separation;
+        if (flip) {
+            point->id = CONTACT_ID(clip2[i].index_b, clip2[i].index_a, clip2[i].type_b, clip2[i].type_a);
+        } else {
+            point->id = CONTACT_ID(clip2[i].index_a, clip2[i].index_b, clip2[i].type_a, clip2[i].type_b);
+        }
+    }
+    manifold_out->points_count = count;
+    return count > 0;
+}
+
+/*
+ * Greatest separation of vertices_b from the edges of vertices_a, negative
+ * when they overlap.
+ */
+static float EcsPhysis2dManifold_findMaxSeparation(
+    PolygonVertices_t *vertices_a, float winding_a,
+    PolygonVertices_t *vertices_b,
+    int32_t *edge_out)
+{
+    float max_separation = -INFINITY;
+    *edge_out = 0;
+    for (int32_t i = 0; i < vertices_a->size; i++) {
+        EcsVector2D normal;
+        EcsPhysis2d_getOutwardNormal(vertices_a, winding_a, i, &normal);
+        float offset = EcsVector2D_dot(&normal, &vertices_a->points[i]);
+        float separation = INFINITY;
+        if (vertices_b->supports != NULL) {
+            EcsVector2D direction = {-VECTOR_X(&normal), -VECTOR_Y(&normal)};
+            int32_t deepest = EcsPhysis2d_getExtremeVertex(vertices_b, &direction);
+            separation = EcsVector2D_dot(&normal, &vertices_b->points[deepest]) - offset;
+        }
+        for (int32_t j = 0; vertices_b->supports == NULL && j < vertices_b->size; j++) {
+            float distance = EcsVector2D_dot(&normal, &vertices_b->points[j]) - offset;
+            if (distance < separation) {
+                separation = distance;
+            }
+        }
+        if (separation > max_separation) {
+            max_separation = separation;
+            *edge_out = i;
+        }
+    }
+    return max_separation;
+}
+
+/*
+ * Sutherland-Hodgman clip of a segment against the half plane
+ * dot(normal, v) <= offset. New points take reference_vertex as feature.
+ */
+static int32_t EcsPhysis2dManifold_clipSegment(
+    ClipVertex_t *out,
+    ClipVertex_t *in,
+    EcsVector2D *normal, float offset,
+    int32_t reference_vertex)
+{
+    int32_t count = 0;
+    float distance0 = EcsVector2D_dot(normal, &in[0].v) - offset;
+    float distance1 = EcsVector2D_dot(normal, &in[1].v) - offset;
+
+    if (distance0 <= 0) {
+        out[count++] = in[0];
+    }
+    if (distance1 <= 0) {
+        out[count++] = in[1];
+    }
+    if (distance0 * distance1 < 0) {
+        float t = distance0 / (distance0 - distance1);
+        VECTOR_X(&out[count].v) = VECTOR_X(&in[0].v) + t * (VECTOR_X(&in[1].v) - VECTOR_X(&in[0].v));
+        VECTOR_Y(&out[count].v) = VECTOR_Y(&in[0].v) + t * (VECTOR_Y(&in[1].v) - VECTOR_Y(&in[0].v));
+        out[count].index_a = reference_vertex;
+        out[count].index_b = in[0].index_b;
+        out[count].type_a = FEATURE_VERTEX;
+        out[count].type_b = FEATURE_FACE;
+        count++;
+    }
+    return count;
+}
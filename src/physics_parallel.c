@@ -0,0 +1,398 @@
+#include "include/physics_parallel.h"
+#include "include/physics_simd.h"
+#include "private.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Pairs tested per task, a multiple of the batch size of the narrowphase
+#define CHUNK_SIZE 512
+
+#define RANGE_MAKE(first, end) (((uint64_t)(uint32_t)(end) << 32) | (uint32_t)(first))
+#define RANGE_FIRST(range) ((int32_t)((range) & 0xFFFFFFFFu))
+#define RANGE_END(range) ((int32_t)((range) >> 32))
+
+/* Hit of a chunk, index is relative to the first pair of the chunk */
+typedef struct ParallelHit {
+    EcsCollisionInfo collision;
+    int32_t index;
+} ParallelHit_t;
+
+/* Output of a chunk in the scratch buffer of the worker that tested it */
+typedef struct ParallelChunk {
+    int32_t worker;
+    int32_t offset;
+    int32_t count;
+} ParallelChunk_t;
+
+/*
+ * Per worker state, the SAT cache is a view of the shared one with its own
+ * stats. Padded so the counters of two workers never share a cache line.
+ */
+typedef struct ParallelWorker {
+    EcsPhysis2dContext ctx;
+    EcsSatCache sat_cache;
+    int32_t count;
+    int8_t failed;
+    uint8_t padding[64];
+} ParallelWorker_t;
+
+typedef struct ParallelJob {
+    EcsThreadPool *pool;
+    EcsColliderData **colliders;
+    EcsColliderPair *pairs;
+    int32_t pair_count;
+    ParallelChunk_t *chunks;
+    ParallelWorker_t *workers;
+} ParallelJob_t;
+
+static void* EcsThreadPool_main(void *arg);
+static void EcsThreadPool_work(EcsThreadPool *pool, int32_t worker);
+static int8_t EcsThreadPool_pop(EcsThreadPoolWorker *worker, int32_t *task_out);
+static int8_t EcsThreadPool_steal(EcsThreadPoolWorker *worker, int32_t *task_out);
+static int8_t EcsPhysis2dParallel_warmCaches(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count);
+static void EcsPhysis2dParallel_task(void *ctx, int32_t task, int32_t worker);
+
+void EcsThreadPool_init(EcsThreadPool *pool, int32_t thread_count)
+{
+    if (thread_count <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cores > 0 ? (int32_t)cores : 1;
+    }
+    memset(pool, 0, sizeof(EcsThreadPool));
+    pool->workers = calloc(thread_count, sizeof(EcsThreadPoolWorker));
+    pool->threads = thread_count > 1 ? calloc(thread_count - 1, sizeof(pthread_t)) : NULL;
+    if (pool->workers == NULL || (thread_count > 1 && pool->threads == NULL)) {
+        thread_count = pool->workers != NULL ? 1 : 0;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int32_t i = 0; i < thread_count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pool->workers[i].generation = pool->generation;
+    }
+
+    // Worker 0 is the calling thread, a failed start leaves fewer workers
+    pool->thread_count = thread_count > 0 ? 1 : 0;
+    for (int32_t i = 1; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i - 1], NULL, EcsThreadPool_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        pool->thread_count++;
+    }
+}
+
+void EcsThreadPool_deinit(EcsThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int32_t i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i - 1], NULL);
+    }
+    for (int32_t i = 0; i < pool->thread_count; i++) {
+        free(pool->workers[i].scratch);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool->workers);
+    memset(pool, 0, sizeof(EcsThreadPool));
+}
+
+int32_t EcsThreadPool_getThreadCount(EcsThreadPool *pool)
+{
+    return pool != NULL ? pool->thread_count : 0;
+}
+
+void EcsThreadPool_run(EcsThreadPool *pool, int32_t task_count, EcsThreadPoolTask task, void *ctx)
+{
+    if (pool == NULL || task == NULL || task_count <= 0) {
+        return;
+    }
+    int32_t thread_count = pool->thread_count;
+    if (thread_count <= 1 || task_count == 1) {
+        for (int32_t i = 0; i < task_count; i++) {
+            task(ctx, i, 0);
+        }
+        return;
+    }
+    for (int32_t i = 0; i < thread_count; i++) {
+        int32_t first = (int32_t)((int64_t)task_count * i / thread_count);
+        int32_t end = (int32_t)((int64_t)task_count * (i + 1) / thread_count);
+        __atomic_store_n(&pool->workers[i].range, RANGE_MAKE(first, end), __ATOMIC_RELAXED);
+    }
+
+    // The mutex publishes the ranges and the task to the workers
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->running = thread_count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    EcsThreadPool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void* EcsThreadPool_getScratch(EcsThreadPool *pool, int32_t worker, size_t size)
+{
+    EcsThreadPoolWorker *owner = &pool->workers[worker];
+    if (size <= owner->scratch_size) {
+        return owner->scratch;
+    }
+    size_t capacity = owner->scratch_size ? owner->scratch_size : 4096;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    void *scratch = realloc(owner->scratch, capacity);
+    if (scratch == NULL) {
+        return NULL;
+    }
+    owner->scratch = scratch;
+    owner->scratch_size = capacity;
+    return scratch;
+}
+
+int32_t EcsPhysis2dCollisionCheckParallel(
+    EcsThreadPool *pool,
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out)
+{
+    if (colliders == NULL || pairs == NULL || collisions_out == NULL) {
+        return 0;
+    }
+    int32_t chunk_count = (pair_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int32_t thread_count = EcsThreadPool_getThreadCount(pool);
+    if (thread_count <= 1 || chunk_count <= 1) {
+        return EcsPhysis2dCollisionCheckBatch(ctx, colliders, pairs, pair_count, collisions_out, hits_out);
+    }
+
+    ParallelJob_t job;
+    job.pool = pool;
+    job.colliders = colliders;
+    job.pairs = pairs;
+    job.pair_count = pair_count;
+    job.chunks = malloc(chunk_count * sizeof(ParallelChunk_t));
+    job.workers = malloc(thread_count * sizeof(ParallelWorker_t));
+    int8_t warm = EcsPhysis2dParallel_warmCaches(ctx, colliders, pairs, pair_count);
+    if (job.chunks == NULL || job.workers == NULL || !warm) {
+        free(job.chunks);
+        free(job.workers);
+        return EcsPhysis2dCollisionCheckBatch(ctx, colliders, pairs, pair_count, collisions_out, hits_out);
+    }
+    // The projection kernel is selected on first use, not from the workers
+    EcsPhysis2d_getProjectionKernel();
+
+    for (int32_t i = 0; i < thread_count; i++) {
+        ParallelWorker_t *worker = &job.workers[i];
+        memset(&worker->ctx, 0, sizeof(EcsPhysis2dContext));
+        if (ctx != NULL) {
+            worker->ctx = *ctx;
+            if (ctx->sat_cache != NULL) {
+                worker->sat_cache = *ctx->sat_cache;
+                worker->sat_cache.hits = 0;
+                worker->sat_cache.misses = 0;
+                worker->ctx.sat_cache = &worker->sat_cache;
+            }
+        }
+        worker->count = 0;
+        worker->failed = false;
+    }
+
+    EcsThreadPool_run(pool, chunk_count, EcsPhysis2dParallel_task, &job);
+
+    int8_t failed = false;
+    for (int32_t i = 0; i < thread_count; i++) {
+        failed |= job.workers[i].failed;
+        if (ctx != NULL && ctx->sat_cache != NULL) {
+            ctx->sat_cache->hits += job.workers[i].sat_cache.hits;
+            ctx->sat_cache->misses += job.workers[i].sat_cache.misses;
+        }
+    }
+    if (failed) {
+        free(job.chunks);
+        free(job.workers);
+        return EcsPhysis2dCollisionCheckBatch(ctx, colliders, pairs, pair_count, collisions_out, hits_out);
+    }
+
+    // Chunks are merged in order, which is the order of the serial batch
+    int32_t hits = 0;
+    for (int32_t c = 0; c < chunk_count; c++) {
+        ParallelChunk_t *chunk = &job.chunks[c];
+        ParallelHit_t *chunk_hits = (ParallelHit_t*)pool->workers[chunk->worker].scratch + chunk->offset;
+        for (int32_t i = 0; i < chunk->count; i++) {
+            collisions_out[hits] = chunk_hits[i].collision;
+            if (hits_out != NULL) {
+                hits_out[hits] = c * CHUNK_SIZE + chunk_hits[i].index;
+            }
+            hits++;
+        }
+    }
+    free(job.chunks);
+    free(job.workers);
+    return hits;
+}
+
+static void* EcsThreadPool_main(void *arg)
+{
+    EcsThreadPoolWorker *worker = arg;
+    EcsThreadPool *pool = worker->pool;
+    uint32_t generation = worker->generation;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->generation == generation && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        generation = pool->generation;
+        worker->generation = generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        EcsThreadPool_work(pool, worker->index);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+/* Runs the tasks of the worker, then steals from the others until all are empty */
+static void EcsThreadPool_work(EcsThreadPool *pool, int32_t worker)
+{
+    int32_t task;
+    while (EcsThreadPool_pop(&pool->workers[worker], &task)) {
+        pool->task(pool->ctx, task, worker);
+    }
+    for (int32_t i = 1; i < pool->thread_count; i++) {
+        EcsThreadPoolWorker *victim = &pool->workers[(worker + i) % pool->thread_count];
+        while (EcsThreadPool_steal(victim, &task)) {
+            pool->task(pool->ctx, task, worker);
+        }
+    }
+}
+
+static int8_t EcsThreadPool_pop(EcsThreadPoolWorker *worker, int32_t *task_out)
+{
+    uint64_t range = __atomic_load_n(&worker->range, __ATOMIC_RELAXED);
+    for (;;) {
+        int32_t first = RANGE_FIRST(range);
+        int32_t end = RANGE_END(range);
+        if (first >= end) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&worker->range, &range, RANGE_MAKE(first + 1, end),
+                true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            *task_out = first;
+            return true;
+        }
+    }
+}
+
+static int8_t EcsThreadPool_steal(EcsThreadPoolWorker *worker, int32_t *task_out)
+{
+    uint64_t range = __atomic_load_n(&worker->range, __ATOMIC_RELAXED);
+    for (;;) {
+        int32_t first = RANGE_FIRST(range);
+        int32_t end = RANGE_END(range);
+        if (first >= end) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&worker->range, &range, RANGE_MAKE(first, end - 1),
+                true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            *task_out = end - 1;
+            return true;
+        }
+    }
+}
+
+/*
+ * Creates the cache entries of every pair on the calling thread, the
+ * workers then only look them up. Returns false when an entry could not be
+ * allocated.
+ */
+static int8_t EcsPhysis2dParallel_warmCaches(
+    EcsPhysis2dContext *ctx,
+    EcsColliderData **colliders,
+    EcsColliderPair *pairs,
+    int32_t pair_count)
+{
+    if (ctx == NULL) {
+        return true;
+    }
+    int8_t sat = ctx->sat_cache != NULL && ctx->narrowphase != EcsNarrowphaseGjk;
+    for (int32_t i = 0; i < pair_count; i++) {
+        EcsColliderData *collider_a = colliders[pairs[i].a];
+        EcsColliderData *collider_b = colliders[pairs[i].b];
+        if (collider_a == NULL || collider_b == NULL || GET_POSITION(collider_a) == NULL || GET_POSITION(collider_b) == NULL) {
+            continue;
+        }
+        int8_t type_a = GET_COLLIDER_TYPE(collider_a);
+        int8_t type_b = GET_COLLIDER_TYPE(collider_b);
+        if (ctx->vertex_cache != NULL) {
+            if (type_a == POLYGON && EcsVertexCache_getEntry(ctx->vertex_cache, COLLIDER_DATA(collider_a)) == NULL) {
+                return false;
+            }
+            if (type_b == POLYGON && EcsVertexCache_getEntry(ctx->vertex_cache, COLLIDER_DATA(collider_b)) == NULL) {
+                return false;
+            }
+        }
+        int8_t swapped;
+        if (sat && type_a == POLYGON && type_b == POLYGON &&
+            EcsSatCache_getEntry(ctx->sat_cache, COLLIDER_DATA(collider_a), COLLIDER_DATA(collider_b), &swapped) == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void EcsPhysis2dParallel_task(void *ctx, int32_t task, int32_t worker)
+{
+    ParallelJob_t *job = ctx;
+    ParallelWorker_t *state = &job->workers[worker];
+    ParallelChunk_t *chunk = &job->chunks[task];
+    int32_t base = task * CHUNK_SIZE;
+    int32_t size = (job->pair_count - base) < CHUNK_SIZE ? (job->pair_count - base) : CHUNK_SIZE;
+    EcsCollisionInfo collisions[CHUNK_SIZE];
+    int32_t hits[CHUNK_SIZE];
+
+    chunk->worker = worker;
+    chunk->offset = state->count;
+    chunk->count = 0;
+    int32_t count = EcsPhysis2dCollisionCheckBatch(
+        &state->ctx, job->colliders, job->pairs + base, size, collisions, hits);
+    ParallelHit_t *output = EcsThreadPool_getScratch(
+        job->pool, worker, (state->count + count) * sizeof(ParallelHit_t));
+    if (output == NULL) {
+        state->failed = true;
+        return;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        output[state->count + i].collision = collisions[i];
+        output[state->count + i].index = hits[i];
+    }
+    chunk->count = count;
+    state->count += count;
+}
@@ -0,0 +1,309 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Largest sine of the angle between the axes of two edges facing each other
+#define FACING_TOLERANCE 1e-6f
+// Edges shorter than this fraction of the polygon extent get no support
+#define DEGENERATE_TOLERANCE 1e-5f
+
+static float EcsPolygonSupport_angle(float x, float y);
+static int EcsPolygonSupport_compare(const void *a, const void *b);
+static void EcsPolygonSupport_reverse(EcsPolygonSupport *supports, int32_t begin, int32_t end);
+
+int8_t EcsPolygonCollider_init(EcsPolygonCollider *polygon, EcsPoint *points, int32_t points_count)
+{
+    if (polygon == NULL || points == NULL || points_count <= 0) {
+        return false;
+    }
+    polygon->points = points;
+    polygon->points_count = points_count;
+    polygon->normals = NULL;
+    polygon->supports = NULL;
+    polygon->facing = NULL;
+    polygon->shape = EcsPolygonShapeGeneric;
+    polygon->winding = 1;
+    return EcsPolygonCollider_bake(polygon);
+}
+
+int8_t EcsPolygonCollider_bake(EcsPolygonCollider *polygon)
+{
+    if (polygon == NULL || polygon->points == NULL || polygon->points_count <= 0) {
+        return false;
+    }
+    int32_t size = polygon->points_count;
+    EcsVector2D *normals = realloc(polygon->normals, size * sizeof(EcsVector2D));
+    if (normals == NULL) {
+        return false;
+    }
+    EcsPolygonCollider_computeNormals(polygon->points, size, normals);
+    polygon->normals = normals;
+    polygon->shape = EcsPolygonCollider_computeShape(normals, size);
+    polygon->winding = EcsPolygonCollider_computeWinding(polygon->points, size);
+    EcsPolygonCollider_computeBounds(polygon->points, size, &polygon->aabb);
+
+    int32_t *facing = realloc(polygon->facing, size * sizeof(int32_t));
+    if (facing == NULL) {
+        return false;
+    }
+    polygon->facing = facing;
+    int32_t facing_count = EcsPolygonCollider_computeFacing(normals, size, facing);
+    if (facing_count < 0) {
+        return false;
+    }
+    if (facing_count == 0) {
+        free(polygon->facing);
+        polygon->facing = NULL;
+    }
+
+    if (size < EXTREME_THRESHOLD) {
+        free(polygon->supports);
+        polygon->supports = NULL;
+        return true;
+    }
+    EcsPolygonSupport *supports = realloc(polygon->supports, size * sizeof(EcsPolygonSupport));
+    if (supports == NULL) {
+        return false;
+    }
+    polygon->supports = supports;
+    if (!EcsPolygonCollider_computeSupports(polygon->points, normals, size, supports)) {
+        // The linear scan finds the extreme vertex of any polygon
+        free(polygon->supports);
+        polygon->supports = NULL;
+    }
+    return true;
+}
+
+void EcsPolygonCollider_release(EcsPolygonCollider *polygon)
+{
+    if (polygon == NULL) {
+        return;
+    }
+    free(polygon->normals);
+    free(polygon->supports);
+    free(polygon->facing);
+    polygon->normals = NULL;
+    polygon->supports = NULL;
+    polygon->facing = NULL;
+    polygon->shape = EcsPolygonShapeGeneric;
+}
+
+void EcsPolygonCollider_computeNormals(EcsPoint *points, int32_t size, EcsVector2D *normals_out)
+{
+    for (int32_t i = 0; i < size; i++) {
+        EcsVector2D_sub(&points[(i+1) < size ? (i+1) : 0], &points[i], &normals_out[i]);
+        EcsVector2D_get_normal(&normals_out[i], &normals_out[i]);
+        EcsVector2D_normalize(&normals_out[i], &normals_out[i]);
+    }
+}
+
+/*
+ * Walking a convex polygon counter clockwise, the outward normals turn once
+ * around, the supports are that walk rotated to start at the smallest angle.
+ * Edges shorter than DEGENERATE_TOLERANCE of the polygon extent have no
+ * reliable normal, they take the angle of the edge before them so the search
+ * lands on the vertex before them.
+ */
+int8_t EcsPolygonCollider_computeSupports(EcsPoint *points, EcsVector2D *normals, int32_t size, EcsPolygonSupport *supports_out)
+{
+    // Baked normals point outwards for counter clockwise polygons only
+    int8_t clockwise = EcsPolygonCollider_computeWinding(points, size) < 0;
+    float extent = 0;
+    for (int32_t i = 0; i < size; i++) {
+        extent = fabsf(VECTOR_X(&points[i])) > extent ? fabsf(VECTOR_X(&points[i])) : extent;
+        extent = fabsf(VECTOR_Y(&points[i])) > extent ? fabsf(VECTOR_Y(&points[i])) : extent;
+    }
+
+    // A vertex is extreme for the directions between the normals of its edges
+    int32_t first = -1;
+    for (int32_t k = 0; k < size; k++) {
+        int32_t i = clockwise ? size - 1 - k : k;
+        int32_t next = (i+1) < size ? (i+1) : 0;
+        float length = fabsf(VECTOR_X(&points[next]) - VECTOR_X(&points[i])) +
+            fabsf(VECTOR_Y(&points[next]) - VECTOR_Y(&points[i]));
+        float x = VECTOR_X(&normals[i]);
+        float y = VECTOR_Y(&normals[i]);
+        supports_out[k].angle = length <= DEGENERATE_TOLERANCE * extent ? NAN :
+            clockwise ? EcsPolygonSupport_angle(-x, -y) : EcsPolygonSupport_angle(x, y);
+        supports_out[k].vertex = clockwise ? next : i;
+        first = first < 0 && !isnan(supports_out[k].angle) ? k : first;
+    }
+    if (first < 0) {
+        return false;
+    }
+    for (int32_t k = 1; k < size; k++) {
+        int32_t j = first + k < size ? first + k : first + k - size;
+        int32_t previous = j > 0 ? j - 1 : size - 1;
+        if (isnan(supports_out[j].angle)) {
+            supports_out[j].angle = supports_out[previous].angle;
+        }
+    }
+
+    // The angles only go down where the walk passes -x, a second time means
+    // the polygon is not convex or rounding turned an edge backwards
+    int32_t start = -1;
+    for (int32_t k = 0; k < size; k++) {
+        int32_t previous = k > 0 ? k - 1 : size - 1;
+        if (supports_out[k].angle < supports_out[previous].angle) {
+            if (start >= 0) {
+                return false;
+            }
+            start = k;
+        }
+    }
+    if (start < 0) {
+        return false;
+    }
+    EcsPolygonSupport_reverse(supports_out, 0, start);
+    EcsPolygonSupport_reverse(supports_out, start, size);
+    EcsPolygonSupport_reverse(supports_out, 0, size);
+    return true;
+}
+
+/*
+ * Edges are sorted by normal angle, the edge facing another one is next to
+ * the angle of the opposite normal.
+ */
+int32_t EcsPolygonCollider_computeFacing(EcsVector2D *normals, int32_t size, int32_t *facing_out)
+{
+    for (int32_t i = 0; i < size; i++) {
+        facing_out[i] = -1;
+    }
+    if (size < 4) {
+        return 0;
+    }
+    EcsPolygonSupport *edges = malloc(size * sizeof(EcsPolygonSupport));
+    if (edges == NULL) {
+        return -1;
+    }
+    for (int32_t i = 0; i < size; i++) {
+        edges[i].angle = EcsPolygonSupport_angle(VECTOR_X(&normals[i]), VECTOR_Y(&normals[i]));
+        edges[i].vertex = i;
+    }
+    qsort(edges, size, sizeof(EcsPolygonSupport), EcsPolygonSupport_compare);
+
+    int32_t count = 0;
+    for (int32_t i = 0; i < size; i++) {
+        float x = VECTOR_X(&normals[i]);
+        float y = VECTOR_Y(&normals[i]);
+        float angle = EcsPolygonSupport_angle(-x, -y);
+        int32_t low = 0;
+        int32_t high = size;
+        while (low < high) {
+            int32_t mid = (low + high) >> 1;
+            if (edges[mid].angle < angle) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        // The angles wrap around at -x, either neighbour can be the closest
+        int32_t candidates[2] = {low < size ? low : 0, low > 0 ? low - 1 : size - 1};
+        for (int32_t c = 0; c < 2; c++) {
+            int32_t j = edges[candidates[c]].vertex;
+            EcsVector2D *normal = &normals[j];
+            float cross = x * VECTOR_Y(normal) - y * VECTOR_X(normal);
+            if (j < i && x * VECTOR_X(normal) + y * VECTOR_Y(normal) < 0 && fabsf(cross) <= FACING_TOLERANCE) {
+                facing_out[i] = j;
+                count++;
+                break;
+            }
+        }
+    }
+    free(edges);
+    return count;
+}
+
+int32_t EcsPolygonCollider_getExtremeVertex(EcsPolygonSupport *supports, int32_t size, float x, float y)
+{
+    float angle = EcsPolygonSupport_angle(x, y);
+    int32_t low = 0;
+    int32_t high = size;
+    while (low < high) {
+        int32_t mid = (low + high) >> 1;
+        if (supports[mid].angle < angle) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return supports[low < size ? low : 0].vertex;
+}
+
+int8_t EcsPolygonCollider_computeWinding(EcsPoint *points, int32_t size)
+{
+    float area = 0;
+    for (int32_t i = 0; i < size; i++) {
+        EcsPoint *p1 = &points[i];
+        EcsPoint *p2 = &points[(i+1) < size ? (i+1) : 0];
+        area += VECTOR_X(p1) * VECTOR_Y(p2) - VECTOR_Y(p1) * VECTOR_X(p2);
+    }
+    return area < 0 ? -1 : 1;
+}
+
+void EcsPolygonCollider_computeBounds(EcsPoint *points, int32_t size, EcsAABB *aabb_out)
+{
+    AABB_MIN_X(aabb_out) = FLT_MAX;
+    AABB_MIN_Y(aabb_out) = FLT_MAX;
+    AABB_MAX_X(aabb_out) = -FLT_MAX;
+    AABB_MAX_Y(aabb_out) = -FLT_MAX;
+    for (int32_t i = 0; i < size; i++) {
+        AABB_MIN_X(aabb_out) = VECTOR_X(&points[i]) < AABB_MIN_X(aabb_out) ? VECTOR_X(&points[i]) : AABB_MIN_X(aabb_out);
+        AABB_MIN_Y(aabb_out) = VECTOR_Y(&points[i]) < AABB_MIN_Y(aabb_out) ? VECTOR_Y(&points[i]) : AABB_MIN_Y(aabb_out);
+        AABB_MAX_X(aabb_out) = VECTOR_X(&points[i]) > AABB_MAX_X(aabb_out) ? VECTOR_X(&points[i]) : AABB_MAX_X(aabb_out);
+        AABB_MAX_Y(aabb_out) = VECTOR_Y(&points[i]) > AABB_MAX_Y(aabb_out) ? VECTOR_Y(&points[i]) : AABB_MAX_Y(aabb_out);
+    }
+}
+
+/*
+ * Boxes need the normals of facing edges to be exactly opposite, testing
+ * one of them is then the same as testing both.
+ */
+int8_t EcsPolygonCollider_computeShape(EcsVector2D *normals, int32_t size)
+{
+    if (size == 3) {
+        return EcsPolygonShapeTriangle;
+    }
+    if (size != 4) {
+        return EcsPolygonShapeGeneric;
+    }
+    for (int32_t i = 0; i < 2; i++) {
+        if (VECTOR_X(&normals[i]) != -VECTOR_X(&normals[i + 2]) ||
+            VECTOR_Y(&normals[i]) != -VECTOR_Y(&normals[i + 2])) {
+            return EcsPolygonShapeGeneric;
+        }
+    }
+    return EcsPolygonShapeBox;
+}
+
+/*
+ * Diamond angle, orders directions as atan2 does without the trigonometry.
+ * Goes from -2 (pointing to -x from below) to 2 (pointing to -x from above).
+ */
+static float EcsPolygonSupport_angle(float x, float y)
+{
+    float length = fabsf(x) + fabsf(y);
+    if (length == 0) {
+        return 0;
+    }
+    float p = x / length;
+    return y < 0 ? p - 1 : 1 - p;
+}
+
+static int EcsPolygonSupport_compare(const void *a, const void *b)
+{
+    float angle_a = ((const EcsPolygonSupport*)a)->angle;
+    float angle_b = ((const EcsPolygonSupport*)b)->angle;
+    return (angle_a > angle_b) - (angle_a < angle_b);
+}
+
+static void EcsPolygonSupport_reverse(EcsPolygonSupport *supports, int32_t begin, int32_t end)
+{
+    for (end--; begin < end; begin++, end--) {
+        EcsPolygonSupport support = supports[begin];
+        supports[begin] = supports[end];
+        supports[end] = support;
+    }
+}
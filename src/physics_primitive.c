@@ -0,0 +1,513 @@
+#include "include/physics_2d.h"
+#include "include/physics_util.h"
+#include "private.h"
+#include <math.h>
+
+// Closest points nearer than this are treated as touching cores, the normal
+// then comes from the SAT of the cores
+#define PRIMITIVE_EPSILON 1e-6f
+
+static int8_t EcsPhysis2dPrimitive_dispatch(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a, int8_t type_a,
+    ColliderData_t *collider_b, int8_t type_b,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveCircleCapsule(
+    ColliderData_t *circle,
+    ColliderData_t *capsule,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveCircleBox(
+    ColliderData_t *circle,
+    ColliderData_t *box,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveCapsuleCapsule(
+    ColliderData_t *capsule_a,
+    ColliderData_t *capsule_b,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveBoxBox(
+    ColliderData_t *box_a,
+    ColliderData_t *box_b,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveRounded(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveRoundedVertices(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsCollisionInfo *collision_out);
+static int8_t EcsPhysis2dPrimitiveRoundedAxes(
+    PolygonVertices_t *owner,
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    float radius,
+    float *gap,
+    EcsVector2D *direction);
+static float EcsPhysis2dPrimitive_closestOnSegment(
+    EcsPoint *point,
+    EcsPoint *p1, EcsPoint *p2,
+    EcsPoint *out);
+static float EcsPhysis2dPrimitive_closestOnSegments(
+    EcsPoint *p1, EcsPoint *q1,
+    EcsPoint *p2, EcsPoint *q2,
+    EcsPoint *c1, EcsPoint *c2);
+static int8_t EcsPhysis2dPrimitive_segmentsCross(
+    EcsPoint *p1, EcsPoint *q1,
+    EcsPoint *p2, EcsPoint *q2);
+static float EcsPhysis2dPrimitive_orientation(EcsPoint *p, EcsPoint *q, EcsPoint *point);
+
+/*
+ * The pair is ordered circle, polygon, capsule, box before the test, the
+ * direction is turned back when a and b were swapped.
+ */
+int8_t EcsPhysis2dPrimitive_collide(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out)
+{
+    int8_t type_a = GET_DATA_TYPE(collider_a);
+    int8_t type_b = GET_DATA_TYPE(collider_b);
+    int8_t result;
+    STATS_ADD(pair_tests[EcsStatsPairPrimitive], 1);
+    if (type_a > type_b) {
+        result = EcsPhysis2dPrimitive_dispatch(ctx, collider_b, type_b, collider_a, type_a, collision_out);
+        if (result) {
+            EcsVector2D_scale(&collision_out->direction, -1, &collision_out->direction);
+        }
+    } else {
+        result = EcsPhysis2dPrimitive_dispatch(ctx, collider_a, type_a, collider_b, type_b, collision_out);
+    }
+    STATS_ADD(pair_hits[EcsStatsPairPrimitive], result);
+    return result;
+}
+
+static int8_t EcsPhysis2dPrimitive_dispatch(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a, int8_t type_a,
+    ColliderData_t *collider_b, int8_t type_b,
+    EcsCollisionInfo *collision_out)
+{
+    if (type_a == CIRCLE && type_b == CAPSULE) {
+        return EcsPhysis2dPrimitiveCircleCapsule(collider_a, collider_b, collision_out);
+    } else if (type_a == CIRCLE && type_b == BOX) {
+        return EcsPhysis2dPrimitiveCircleBox(collider_a, collider_b, collision_out);
+    } else if (type_a == CAPSULE && type_b == CAPSULE) {
+        return EcsPhysis2dPrimitiveCapsuleCapsule(collider_a, collider_b, collision_out);
+    } else if (type_a == BOX && type_b == BOX) {
+        return EcsPhysis2dPrimitiveBoxBox(collider_a, collider_b, collision_out);
+    }
+    // Polygon against capsule or box, capsule against box
+    return EcsPhysis2dPrimitiveRounded(ctx, collider_a, collider_b, collision_out);
+}
+
+/*
+ * Distance from the center to the segment against both radii.
+ */
+static int8_t EcsPhysis2dPrimitiveCircleCapsule(
+    ColliderData_t *circle,
+    ColliderData_t *capsule,
+    EcsCollisionInfo *collision_out)
+{
+    EcsPoint buffer[2];
+    PolygonVertices_t segment;
+    float radius_capsule;
+    EcsPhysis2d_getCoreVertices(NULL, capsule, NULL, buffer, NULL, &segment, &radius_capsule);
+    float radius = circle->circle->radius + radius_capsule;
+
+    EcsPoint closest;
+    float distSqrt = EcsPhysis2dPrimitive_closestOnSegment(circle->position, &buffer[0], &buffer[segment.size - 1], &closest);
+    if (distSqrt > radius * radius) {
+        STATS_ADD(early_outs[EcsStatsPairPrimitive], 1);
+        return false;
+    }
+    float distance = sqrtf(distSqrt);
+    if (distance <= PRIMITIVE_EPSILON) {
+        // Center on the segment, the SAT of the cores picks the side
+        EcsPoint center;
+        PolygonVertices_t point;
+        float radius_circle;
+        EcsPhysis2d_getCoreVertices(NULL, circle, NULL, &center, NULL, &point, &radius_circle);
+        return EcsPhysis2dPrimitiveRoundedVertices(&point, radius_circle, &segment, radius_capsule, collision_out);
+    }
+    EcsVector2D_sub(circle->position, &closest, &collision_out->direction);
+    EcsVector2D_scale(&collision_out->direction, 1.0f / distance, &collision_out->direction);
+    collision_out->distance = radius - distance;
+    return true;
+}
+
+/*
+ * Clamps the center into the box, a center inside leaves through the
+ * nearest face.
+ */
+static int8_t EcsPhysis2dPrimitiveCircleBox(
+    ColliderData_t *circle,
+    ColliderData_t *box,
+    EcsCollisionInfo *collision_out)
+{
+    float radius = circle->circle->radius;
+    float half_x = VECTOR_X(&box->box->half_extents);
+    float half_y = VECTOR_Y(&box->box->half_extents);
+    EcsVector2D offset;
+    EcsVector2D_sub(circle->position, box->position, &offset);
+    float x = fminf(fmaxf(VECTOR_X(&offset), -half_x), half_x);
+    float y = fminf(fmaxf(VECTOR_Y(&offset), -half_y), half_y);
+
+    if (x != VECTOR_X(&offset) || y != VECTOR_Y(&offset)) {
+        VECTOR_X(&offset) -= x;
+        VECTOR_Y(&offset) -= y;
+        float distSqrt = EcsVector2D_dot(&offset, &offset);
+        if (distSqrt > radius * radius) {
+            STATS_ADD(early_outs[EcsStatsPairPrimitive], 1);
+            return false;
+        }
+        float distance = sqrtf(distSqrt);
+        EcsVector2D_scale(&offset, 1.0f / distance, &collision_out->direction);
+        collision_out->distance = radius - distance;
+        return true;
+    }
+
+    float exit_x = half_x - fabsf(x);
+    float exit_y = half_y - fabsf(y);
+    if (exit_x < exit_y) {
+        VECTOR_X(&collision_out->direction) = x < 0 ? -1 : 1;
+        VECTOR_Y(&collision_out->direction) = 0;
+        collision_out->distance = radius + exit_x;
+    } else {
+        VECTOR_X(&collision_out->direction) = 0;
+        VECTOR_Y(&collision_out->direction) = y < 0 ? -1 : 1;
+        collision_out->distance = radius + exit_y;
+    }
+    return true;
+}
+
+/*
+ * Closest points of both segments against both radii, crossing segments
+ * fall back to the SAT of the cores.
+ */
+static int8_t EcsPhysis2dPrimitiveCapsuleCapsule(
+    ColliderData_t *capsule_a,
+    ColliderData_t *capsule_b,
+    EcsCollisionInfo *collision_out)
+{
+    EcsPoint buffer_a[2];
+    EcsPoint buffer_b[2];
+    PolygonVertices_t segment_a;
+    PolygonVertices_t segment_b;
+    float radius_a;
+    float radius_b;
+    EcsPhysis2d_getCoreVertices(NULL, capsule_a, NULL, buffer_a, NULL, &segment_a, &radius_a);
+    EcsPhysis2d_getCoreVertices(NULL, capsule_b, NULL, buffer_b, NULL, &segment_b, &radius_b);
+    float radius = radius_a + radius_b;
+
+    EcsPoint *end_a = &buffer_a[segment_a.size - 1];
+    EcsPoint *end_b = &buffer_b[segment_b.size - 1];
+    EcsPoint closest_a;
+    EcsPoint closest_b;
+    float distSqrt = EcsPhysis2dPrimitive_closestOnSegments(
+        &buffer_a[0], end_a, &buffer_b[0], end_b, &closest_a, &closest_b);
+    if (distSqrt > radius * radius) {
+        STATS_ADD(early_outs[EcsStatsPairPrimitive], 1);
+        return false;
+    }
+    float distance = sqrtf(distSqrt);
+    // Rounding leaves crossing segments a small distance apart, with a
+    // direction that means nothing
+    if (distance <= PRIMITIVE_EPSILON ||
+        EcsPhysis2dPrimitive_segmentsCross(&buffer_a[0], end_a, &buffer_b[0], end_b)) {
+        return EcsPhysis2dPrimitiveRoundedVertices(&segment_a, radius_a, &segment_b, radius_b, collision_out);
+    }
+    EcsVector2D_sub(&closest_a, &closest_b, &collision_out->direction);
+    EcsVector2D_scale(&collision_out->direction, 1.0f / distance, &collision_out->direction);
+    collision_out->distance = radius - distance;
+    return true;
+}
+
+/*
+ * Overlap of the intervals on both world axes, the smaller one separates.
+ */
+static int8_t EcsPhysis2dPrimitiveBoxBox(
+    ColliderData_t *box_a,
+    ColliderData_t *box_b,
+    EcsCollisionInfo *collision_out)
+{
+    float dx = VECTOR_X(box_a->position) - VECTOR_X(box_b->position);
+    float dy = VECTOR_Y(box_a->position) - VECTOR_Y(box_b->position);
+    float overlap_x = VECTOR_X(&box_a->box->half_extents) + VECTOR_X(&box_b->box->half_extents) - fabsf(dx);
+    float overlap_y = VECTOR_Y(&box_a->box->half_extents) + VECTOR_Y(&box_b->box->half_extents) - fabsf(dy);
+    STATS_ADD(axes_projected, 2);
+    if (overlap_x < 0 || overlap_y < 0) {
+        STATS_ADD(early_outs[EcsStatsPairPrimitive], 1);
+        return false;
+    }
+    if (overlap_x < overlap_y) {
+        VECTOR_X(&collision_out->direction) = dx < 0 ? -1 : 1;
+        VECTOR_Y(&collision_out->direction) = 0;
+        collision_out->distance = overlap_x;
+    } else {
+        VECTOR_X(&collision_out->direction) = 0;
+        VECTOR_Y(&collision_out->direction) = dy < 0 ? -1 : 1;
+        collision_out->distance = overlap_y;
+    }
+    return true;
+}
+
+/*
+ * Cores of both colliders in the local frame of a, or in world space with
+ * the vertex cache of ctx.
+ */
+static int8_t EcsPhysis2dPrimitiveRounded(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out)
+{
+    EcsPoint buffer_a[VERTEX_BUFFER_SIZE];
+    EcsPoint buffer_b[VERTEX_BUFFER_SIZE];
+    float soa_a[VERTEX_BUFFER_SIZE * 2];
+    float soa_b[VERTEX_BUFFER_SIZE * 2];
+    PolygonVertices_t vertices_a;
+    PolygonVertices_t vertices_b;
+    float radius_a;
+    float radius_b;
+    EcsTransform frame;
+    if (!EcsPhysis2d_getCorePairVertices(ctx, collider_a, collider_b, buffer_a, soa_a, buffer_b, soa_b,
+            &vertices_a, &radius_a, &vertices_b, &radius_b, &frame)) {
+        return false;
+    }
+    int8_t result = false;
+    if (vertices_a.size > 0 && vertices_b.size > 0) {
+        result = EcsPhysis2dPrimitiveRoundedVertices(&vertices_a, radius_a, &vertices_b, radius_b, collision_out);
+    }
+    if (result) {
+        EcsRotation_rotate(&frame.rotation, &collision_out->direction, &collision_out->direction);
+    }
+    EcsPhysis2d_releaseWorldVertices(&vertices_a);
+    EcsPhysis2d_releaseWorldVertices(&vertices_b);
+    return result;
+}
+
+/*
+ * SAT of the cores with the radii around them. The largest gap on the axes
+ * is a lower bound of the distance of the cores: past both radii nothing
+ * touches, at or below 0 the cores overlap and the axis of the gap is the
+ * way out. In between only the radii overlap and the closest points of the
+ * cores give the exact normal.
+ */
+static int8_t EcsPhysis2dPrimitiveRoundedVertices(
+    PolygonVertices_t *vertices_a, float radius_a,
+    PolygonVertices_t *vertices_b, float radius_b,
+    EcsCollisionInfo *collision_out)
+{
+    float radius = radius_a + radius_b;
+    float gap = -INFINITY;
+    EcsVector2D direction = {0, 1};
+    if (!EcsPhysis2dPrimitiveRoundedAxes(vertices_a, vertices_a, vertices_b, radius, &gap, &direction) ||
+        !EcsPhysis2dPrimitiveRoundedAxes(vertices_b, vertices_a, vertices_b, radius, &gap, &direction)) {
+        STATS_ADD(early_outs[EcsStatsPairPrimitive], 1);
+        return false;
+    }
+
+    // Two points have no axes, their gap comes from the distance
+    if (gap <= 0 && (vertices_a->size > 1 || vertices_b->size > 1)) {
+        collision_out->distance = radius - gap;
+        VECTOR_X(&collision_out->direction) = VECTOR_X(&direction);
+        VECTOR_Y(&collision_out->direction) = VECTOR_Y(&direction);
+        return true;
+    }
+
+    EcsPoint point_a;
+    EcsPoint point_b;
+    float distance = EcsPhysis2dPrimitive_getCoreDistance(vertices_a, vertices_b, &point_a, &point_b);
+    if (distance > radius) {
+        return false;
+    }
+    if (distance > PRIMITIVE_EPSILON) {
+        EcsVector2D_sub(&point_a, &point_b, &collision_out->direction);
+        EcsVector2D_scale(&collision_out->direction, 1.0f / distance, &collision_out->direction);
+        collision_out->distance = radius - distance;
+    } else {
+        VECTOR_X(&collision_out->direction) = VECTOR_X(&direction);
+        VECTOR_Y(&collision_out->direction) = VECTOR_Y(&direction);
+        collision_out->distance = radius - (gap > 0 ? gap : 0);
+    }
+    return true;
+}
+
+/*
+ * Axes of owner: the edge normals of polygons and boxes, the normal and the
+ * direction of segments, none for points. Keeps the largest gap in gap and
+ * the direction moving a out of b along that axis, false when an axis
+ * separates the cores by more than radius.
+ */
+static int8_t EcsPhysis2dPrimitiveRoundedAxes(
+    PolygonVertices_t *owner,
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    float radius,
+    float *gap,
+    EcsVector2D *direction)
+{
+    int32_t count = owner->size >= 3 ? owner->size : (owner->size == 2 ? 2 : 0);
+    for (int32_t i = 0; i < count; i++) {
+        EcsVector2D axis;
+        EcsVector2D minMaxA;
+        EcsVector2D minMaxB;
+        if (owner->size >= 3) {
+            EcsPhysis2d_getOutwardNormal(owner, 1, i, &axis);
+        } else {
+            EcsVector2D_sub(&owner->points[1], &owner->points[0], &axis);
+            if (i == 0) {
+                EcsVector2D_get_normal(&axis, &axis);
+            }
+            EcsVector2D_normalize(&axis, &axis);
+        }
+        EcsPhysis2d_getProjection(&axis, vertices_a, &minMaxA);
+        EcsPhysis2d_getProjection(&axis, vertices_b, &minMaxB);
+        STATS_ADD(axes_projected, 1);
+
+        // Moving a back along the axis or forward along it
+        float backward = VECTOR_Y(&minMaxA) - VECTOR_X(&minMaxB);
+        float forward = VECTOR_Y(&minMaxB) - VECTOR_X(&minMaxA);
+        float axis_gap = -(backward < forward ? backward : forward);
+        if (axis_gap > radius) {
+            return false;
+        }
+        if (axis_gap > *gap) {
+            float sign = backward < forward ? -1.0f : 1.0f;
+            *gap = axis_gap;
+            VECTOR_X(direction) = VECTOR_X(&axis) * sign;
+            VECTOR_Y(direction) = VECTOR_Y(&axis) * sign;
+        }
+    }
+    return true;
+}
+
+float EcsPhysis2dPrimitive_getCoreDistance(
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    EcsPoint *point_a, EcsPoint *point_b)
+{
+    float best = INFINITY;
+    for (int32_t pass = 0; pass < 2; pass++) {
+        PolygonVertices_t *from = pass == 0 ? vertices_a : vertices_b;
+        PolygonVertices_t *to = pass == 0 ? vertices_b : vertices_a;
+        // A segment has one edge, a point a single degenerate one
+        int32_t edges = to->size == 2 ? 1 : to->size;
+        for (int32_t i = 0; i < from->size; i++) {
+            for (int32_t j = 0; j < edges; j++) {
+                EcsPoint closest;
+                EcsPoint *p2 = &to->points[(j+1) < to->size ? (j+1) : 0];
+                float distSqrt = EcsPhysis2dPrimitive_closestOnSegment(&from->points[i], &to->points[j], p2, &closest);
+                if (distSqrt >= best) {
+                    continue;
+                }
+                best = distSqrt;
+                EcsPoint *on_a = pass == 0 ? &from->points[i] : &closest;
+                EcsPoint *on_b = pass == 0 ? &closest : &from->points[i];
+                VECTOR_X(point_a) = VECTOR_X(on_a);
+                VECTOR_Y(point_a) = VECTOR_Y(on_a);
+                VECTOR_X(point_b) = VECTOR_X(on_b);
+                VECTOR_Y(point_b) = VECTOR_Y(on_b);
+            }
+        }
+    }
+    return sqrtf(best);
+}
+
+/*
+ * Closest point of segment [p1, p2] to point, returns the squared distance.
+ */
+static float EcsPhysis2dPrimitive_closestOnSegment(
+    EcsPoint *point,
+    EcsPoint *p1, EcsPoint *p2,
+    EcsPoint *out)
+{
+    EcsVector2D edge;
+    EcsVector2D offset;
+    EcsVector2D_sub(p2, p1, &edge);
+    EcsVector2D_sub(point, p1, &offset);
+    float length = EcsVector2D_dot(&edge, &edge);
+    float t = length > 0 ? EcsVector2D_dot(&offset, &edge) / length : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    VECTOR_X(out) = VECTOR_X(p1) + VECTOR_X(&edge) * t;
+    VECTOR_Y(out) = VECTOR_Y(p1) + VECTOR_Y(&edge) * t;
+    float x = VECTOR_X(point) - VECTOR_X(out);
+    float y = VECTOR_Y(point) - VECTOR_Y(out);
+    return x * x + y * y;
+}
+
+/*
+ * Closest points c1 on [p1, q1] and c2 on [p2, q2] (Ericson, Real-Time
+ * Collision Detection 5.1.9), returns their squared distance.
+ */
+static float EcsPhysis2dPrimitive_closestOnSegments(
+    EcsPoint *p1, EcsPoint *q1,
+    EcsPoint *p2, EcsPoint *q2,
+    EcsPoint *c1, EcsPoint *c2)
+{
+    EcsVector2D d1;
+    EcsVector2D d2;
+    EcsVector2D r;
+    EcsVector2D_sub(q1, p1, &d1);
+    EcsVector2D_sub(q2, p2, &d2);
+    EcsVector2D_sub(p1, p2, &r);
+    float a = EcsVector2D_dot(&d1, &d1);
+    float e = EcsVector2D_dot(&d2, &d2);
+    float f = EcsVector2D_dot(&d2, &r);
+    float s = 0;
+    float t = 0;
+
+    if (a <= 0 && e <= 0) {
+        // Both segments are points
+    } else if (a <= 0) {
+        t = fminf(fmaxf(f / e, 0), 1);
+    } else {
+        float c = EcsVector2D_dot(&d1, &r);
+        if (e <= 0) {
+            s = fminf(fmaxf(-c / a, 0), 1);
+        } else {
+            float b = EcsVector2D_dot(&d1, &d2);
+            float denominator = a * e - b * b;
+            // Parallel segments take any s, 0 then fixes t
+            s = denominator > 0 ? fminf(fmaxf((b * f - c * e) / denominator, 0), 1) : 0;
+            t = (b * s + f) / e;
+            if (t < 0) {
+                t = 0;
+                s = fminf(fmaxf(-c / a, 0), 1);
+            } else if (t > 1) {
+                t = 1;
+                s = fminf(fmaxf((b - c) / a, 0), 1);
+            }
+        }
+    }
+    VECTOR_X(c1) = VECTOR_X(p1) + VECTOR_X(&d1) * s;
+    VECTOR_Y(c1) = VECTOR_Y(p1) + VECTOR_Y(&d1) * s;
+    VECTOR_X(c2) = VECTOR_X(p2) + VECTOR_X(&d2) * t;
+    VECTOR_Y(c2) = VECTOR_Y(p2) + VECTOR_Y(&d2) * t;
+    float x = VECTOR_X(c1) - VECTOR_X(c2);
+    float y = VECTOR_Y(c1) - VECTOR_Y(c2);
+    return x * x + y * y;
+}
+
+/*
+ * Proper or touching intersection of [p1, q1] and [p2, q2], collinear
+ * segments count as crossing.
+ */
+static int8_t EcsPhysis2dPrimitive_segmentsCross(
+    EcsPoint *p1, EcsPoint *q1,
+    EcsPoint *p2, EcsPoint *q2)
+{
+    float side_p2 = EcsPhysis2dPrimitive_orientation(p1, q1, p2);
+    float side_q2 = EcsPhysis2dPrimitive_orientation(p1, q1, q2);
+    float side_p1 = EcsPhysis2dPrimitive_orientation(p2, q2, p1);
+    float side_q1 = EcsPhysis2dPrimitive_orientation(p2, q2, q1);
+    return side_p2 * side_q2 <= 0 && side_p1 * side_q1 <= 0;
+}
+
+static float EcsPhysis2dPrimitive_orientation(EcsPoint *p, EcsPoint *q, EcsPoint *point)
+{
+    return (VECTOR_X(q) - VECTOR_X(p)) * (VECTOR_Y(point) - VECTOR_Y(p)) -
+        (VECTOR_Y(q) - VECTOR_Y(p)) * (VECTOR_X(point) - VECTOR_X(p));
+}
@@ -0,0 +1,434 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <math.h>
+
+// Growth of the polygon bounds tested before a raycast, relative to their size
+#define BOUNDS_TOLERANCE 1e-5f
+
+/* State of EcsPhysis2dRaycastBatch shared with the tree callback */
+typedef struct RaycastQuery {
+    EcsColliderData **colliders;
+    EcsRaycastHit *hits;
+    int32_t max_hits;
+    int32_t count;
+    int32_t ray;
+    int8_t closest;
+    int8_t has_closest;
+    EcsRaycastHit closest_hit;
+} RaycastQuery_t;
+
+/* State of EcsPhysis2dShapeCastBatch shared with the tree callback */
+typedef struct ShapeCastQuery {
+    EcsColliderData **colliders;
+    EcsColliderData *shape;
+    EcsVector2D *translation;
+    EcsRaycastHit *hits;
+    int32_t max_hits;
+    int32_t count;
+    int32_t cast;
+    int8_t closest;
+    int8_t has_closest;
+    EcsRaycastHit closest_hit;
+} ShapeCastQuery_t;
+
+static int8_t EcsPhysis2dRaycastCircle(
+    ColliderData_t *circle,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out);
+static int8_t EcsPhysis2dRaycastPolygon(
+    ColliderData_t *polygon,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out);
+static int8_t EcsPhysis2dRaycastCapsule(
+    ColliderData_t *capsule,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out);
+static float EcsPhysis2dRaycast_circleFraction(
+    EcsVector2D *origin, EcsVector2D *translation,
+    EcsVector2D *center, float radius);
+static int8_t EcsPhysis2dRaycast_getBounds(ColliderData_t *collider, int8_t type, EcsAABB *aabb_out);
+static float EcsPhysis2dRaycast_treeCallback(void *ctx, EcsRay *ray, int32_t user_id);
+static int8_t EcsPhysis2dShapeCast_treeCallback(void *ctx, int32_t user_id);
+
+int8_t EcsPhysis2dRaycast(
+    EcsColliderData *collider,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out)
+{
+    if (collider == NULL || ray == NULL || hit_out == NULL || GET_POSITION(collider) == NULL) {
+        return false;
+    }
+    int8_t type = GET_COLLIDER_TYPE(collider);
+    EcsAABB aabb;
+    if (EcsPhysis2dRaycast_getBounds(COLLIDER_DATA(collider), type, &aabb) && !EcsAABBRaycast(&aabb, ray, NULL)) {
+        return false;
+    }
+    if (type == CIRCLE) {
+        return EcsPhysis2dRaycastCircle(COLLIDER_DATA(collider), ray, hit_out);
+    } else if (type == POLYGON || type == BOX) {
+        return EcsPhysis2dRaycastPolygon(COLLIDER_DATA(collider), ray, hit_out);
+    } else if (type == CAPSULE) {
+        return EcsPhysis2dRaycastCapsule(COLLIDER_DATA(collider), ray, hit_out);
+    }
+    return false;
+}
+
+int8_t EcsPhysis2dShapeCast(
+    EcsColliderData *shape,
+    EcsVector2D *translation,
+    EcsColliderData *target,
+    EcsRaycastHit *hit_out)
+{
+    if (shape == NULL || translation == NULL || hit_out == NULL || GET_POSITION(shape) == NULL) {
+        return false;
+    }
+    EcsSweep sweep;
+    EcsToiInfo toi;
+    VECTOR_X(&sweep.start) = VECTOR_X(GET_POSITION(shape));
+    VECTOR_Y(&sweep.start) = VECTOR_Y(GET_POSITION(shape));
+    EcsVector2D_add(&sweep.start, translation, &sweep.end);
+    if (!EcsPhysis2dTimeOfImpact(shape, &sweep, target, NULL, &toi)) {
+        return false;
+    }
+    hit_out->fraction = toi.time;
+    EcsVector2D_scale(&toi.normal, -1, &hit_out->normal);
+    VECTOR_X(&hit_out->point) = VECTOR_X(&toi.point);
+    VECTOR_Y(&hit_out->point) = VECTOR_Y(&toi.point);
+    hit_out->ray = 0;
+    hit_out->collider = 0;
+    return true;
+}
+
+int32_t EcsPhysis2dRaycastBatch(
+    EcsAABBTree *tree,
+    EcsColliderData **colliders,
+    EcsRay *rays,
+    int32_t ray_count,
+    int8_t closest,
+    EcsRaycastHit *hits_out,
+    int32_t max_hits)
+{
+    if (tree == NULL || colliders == NULL || rays == NULL) {
+        return 0;
+    }
+    RaycastQuery_t query;
+    query.colliders = colliders;
+    query.hits = hits_out;
+    query.max_hits = hits_out != NULL ? max_hits : 0;
+    query.count = 0;
+    query.closest = closest;
+
+    for (int32_t i = 0; i < ray_count; i++) {
+        query.ray = i;
+        query.has_closest = false;
+        EcsAABBTree_raycast(tree, &rays[i], EcsPhysis2dRaycast_treeCallback, &query);
+        if (query.has_closest) {
+            if (query.count < query.max_hits) {
+                query.hits[query.count] = query.closest_hit;
+            }
+            query.count++;
+        }
+    }
+    return query.count;
+}
+
+int32_t EcsPhysis2dShapeCastBatch(
+    EcsAABBTree *tree,
+    EcsColliderData **colliders,
+    EcsColliderData **shapes,
+    EcsVector2D *translations,
+    int32_t shape_count,
+    int8_t closest,
+    EcsRaycastHit *hits_out,
+    int32_t max_hits)
+{
+    if (tree == NULL || colliders == NULL || shapes == NULL || translations == NULL) {
+        return 0;
+    }
+    ShapeCastQuery_t query;
+    query.colliders = colliders;
+    query.hits = hits_out;
+    query.max_hits = hits_out != NULL ? max_hits : 0;
+    query.count = 0;
+    query.closest = closest;
+
+    for (int32_t i = 0; i < shape_count; i++) {
+        EcsSweep sweep;
+        EcsAABB aabb;
+        if (shapes[i] == NULL || GET_POSITION(shapes[i]) == NULL) {
+            continue;
+        }
+        VECTOR_X(&sweep.start) = VECTOR_X(GET_POSITION(shapes[i]));
+        VECTOR_Y(&sweep.start) = VECTOR_Y(GET_POSITION(shapes[i]));
+        EcsVector2D_add(&sweep.start, &translations[i], &sweep.end);
+        if (!EcsColliderData_getSweptAABB(shapes[i], &sweep, &aabb)) {
+            continue;
+        }
+        query.shape = shapes[i];
+        query.translation = &translations[i];
+        query.cast = i;
+        query.has_closest = false;
+        EcsAABBTree_query(tree, &aabb, EcsPhysis2dShapeCast_treeCallback, &query);
+        if (query.has_closest) {
+            if (query.count < query.max_hits) {
+                query.hits[query.count] = query.closest_hit;
+            }
+            query.count++;
+        }
+    }
+    return query.count;
+}
+
+/*
+ * Bounds cheaper to test than the collider: the baked bounds of polygons
+ * rotated into the world, capsules and boxes. Circles are tested exactly.
+ */
+static int8_t EcsPhysis2dRaycast_getBounds(ColliderData_t *collider, int8_t type, EcsAABB *aabb_out)
+{
+    if (type == CAPSULE || type == BOX) {
+        return EcsColliderData_getAABB((EcsColliderData*)collider, aabb_out);
+    }
+    if (type != POLYGON || collider->polygon->normals == NULL) {
+        return false;
+    }
+    EcsAABB *local = &collider->polygon->aabb;
+    EcsRotation identity = EcsRotation_Identity();
+    EcsRotation *rotation = collider->rotation != NULL ? collider->rotation : &identity;
+    // Rotated box around the local bounds, from its center and half extents,
+    // grown a little so rounding never rejects a ray touching the polygon
+    EcsVector2D center = {
+        (AABB_MIN_X(local) + AABB_MAX_X(local)) * 0.5f,
+        (AABB_MIN_Y(local) + AABB_MAX_Y(local)) * 0.5f
+    };
+    float half_x = (AABB_MAX_X(local) - AABB_MIN_X(local)) * 0.5f;
+    float half_y = (AABB_MAX_Y(local) - AABB_MIN_Y(local)) * 0.5f;
+    float c = fabsf(rotation->c);
+    float s = fabsf(rotation->s);
+    float extent_x = c * half_x + s * half_y;
+    float extent_y = s * half_x + c * half_y;
+    EcsRotation_rotate(rotation, &center, &center);
+    EcsVector2D_add(&center, collider->position, &center);
+    float padding = (fabsf(VECTOR_X(&center)) + fabsf(VECTOR_Y(&center)) + extent_x + extent_y) * BOUNDS_TOLERANCE;
+    extent_x += padding;
+    extent_y += padding;
+    AABB_MIN_X(aabb_out) = VECTOR_X(&center) - extent_x;
+    AABB_MIN_Y(aabb_out) = VECTOR_Y(&center) - extent_y;
+    AABB_MAX_X(aabb_out) = VECTOR_X(&center) + extent_x;
+    AABB_MAX_Y(aabb_out) = VECTOR_Y(&center) + extent_y;
+    return true;
+}
+
+static int8_t EcsPhysis2dShapeCast_treeCallback(void *ctx, int32_t user_id)
+{
+    ShapeCastQuery_t *query = ctx;
+    EcsColliderData *target = query->colliders[user_id];
+    EcsRaycastHit hit;
+    if (target == query->shape || !EcsPhysis2dShapeCast(query->shape, query->translation, target, &hit)) {
+        return true;
+    }
+    hit.ray = query->cast;
+    hit.collider = user_id;
+    if (query->closest) {
+        if (!query->has_closest || hit.fraction < query->closest_hit.fraction) {
+            query->closest_hit = hit;
+            query->has_closest = true;
+        }
+        return true;
+    }
+    if (query->count < query->max_hits) {
+        query->hits[query->count] = hit;
+    }
+    query->count++;
+    return true;
+}
+
+static float EcsPhysis2dRaycast_treeCallback(void *ctx, EcsRay *ray, int32_t user_id)
+{
+    RaycastQuery_t *query = ctx;
+    EcsRaycastHit hit;
+    if (!EcsPhysis2dRaycast(query->colliders[user_id], ray, &hit)) {
+        return ray->max_fraction;
+    }
+    hit.ray = query->ray;
+    hit.collider = user_id;
+    if (query->closest) {
+        // Hits beyond this one can not be the closest, clip the ray
+        query->closest_hit = hit;
+        query->has_closest = true;
+        return hit.fraction;
+    }
+    if (query->count < query->max_hits) {
+        query->hits[query->count] = hit;
+    }
+    query->count++;
+    return ray->max_fraction;
+}
+
+static int8_t EcsPhysis2dRaycastCircle(
+    ColliderData_t *circle,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out)
+{
+    float radius = circle->circle->radius;
+    float t = EcsPhysis2dRaycast_circleFraction(&ray->origin, &ray->translation, circle->position, radius);
+    if (t > ray->max_fraction) {
+        return false;
+    }
+    hit_out->fraction = t;
+    VECTOR_X(&hit_out->point) = VECTOR_X(&ray->origin) + VECTOR_X(&ray->translation) * t;
+    VECTOR_Y(&hit_out->point) = VECTOR_Y(&ray->origin) + VECTOR_Y(&ray->translation) * t;
+    EcsVector2D_sub(&hit_out->point, circle->position, &hit_out->normal);
+    EcsVector2D_scale(&hit_out->normal, 1.0f / radius, &hit_out->normal);
+    return true;
+}
+
+/*
+ * Clips the ray against the half planes of the edges (Cyrus-Beck) in the
+ * local frame of the polygon, the last edge to raise the lower bound is the
+ * one hit. Boxes are clipped against their corners.
+ */
+static int8_t EcsPhysis2dRaycastPolygon(
+    ColliderData_t *polygon,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out)
+{
+    PolygonVertices_t vertices;
+    EcsTransform identity = {{0, 0}, EcsRotation_Identity()};
+    EcsTransform transform;
+    EcsVector2D origin, translation;
+    EcsPoint corners[4];
+    float radius;
+    if (!EcsPhysis2d_getCoreVertices(NULL, polygon, &identity, corners, NULL, &vertices, &radius) || vertices.size <= 0) {
+        return false;
+    }
+    EcsPhysis2d_getTransform(polygon, &transform);
+    EcsTransform_invApply(&transform, &ray->origin, &origin);
+    EcsRotation_invRotate(&transform.rotation, &ray->translation, &translation);
+
+    float winding = EcsPhysis2d_getWinding(&vertices);
+    float lower = 0;
+    float upper = ray->max_fraction;
+    int32_t edge = -1;
+    EcsVector2D normal;
+    for (int32_t i = 0; i < vertices.size; i++) {
+        EcsVector2D offset;
+        EcsPhysis2d_getOutwardNormal(&vertices, winding, i, &normal);
+        EcsVector2D_sub(&vertices.points[i], &origin, &offset);
+        float numerator = EcsVector2D_dot(&normal, &offset);
+        float denominator = EcsVector2D_dot(&normal, &translation);
+        if (denominator == 0) {
+            if (numerator < 0) {
+                return false;
+            }
+        } else if (denominator < 0 && numerator < lower * denominator) {
+            lower = numerator / denominator;
+            edge = i;
+        } else if (denominator > 0 && numerator < upper * denominator) {
+            upper = numerator / denominator;
+        }
+        if (upper < lower) {
+            return false;
+        }
+    }
+    if (edge < 0) {
+        return false;
+    }
+    EcsPhysis2d_getOutwardNormal(&vertices, winding, edge, &normal);
+    hit_out->fraction = lower;
+    EcsRotation_rotate(&transform.rotation, &normal, &hit_out->normal);
+    VECTOR_X(&hit_out->point) = VECTOR_X(&ray->origin) + VECTOR_X(&ray->translation) * lower;
+    VECTOR_Y(&hit_out->point) = VECTOR_Y(&ray->origin) + VECTOR_Y(&ray->translation) * lower;
+    return true;
+}
+
+/*
+ * In the local frame of the capsule: the two sides of the segment moved out
+ * by the radius and a circle at both ends. Rays starting within the radius
+ * of the segment do not hit.
+ */
+static int8_t EcsPhysis2dRaycastCapsule(
+    ColliderData_t *capsule,
+    EcsRay *ray,
+    EcsRaycastHit *hit_out)
+{
+    EcsTransform transform;
+    EcsVector2D origin, translation;
+    EcsPhysis2d_getTransform(capsule, &transform);
+    EcsTransform_invApply(&transform, &ray->origin, &origin);
+    EcsRotation_invRotate(&transform.rotation, &ray->translation, &translation);
+
+    EcsPoint *p1 = &capsule->capsule->point1;
+    EcsPoint *p2 = &capsule->capsule->point2;
+    float radius = capsule->capsule->radius;
+    EcsVector2D edge, offset;
+    EcsVector2D_sub(p2, p1, &edge);
+    EcsVector2D_sub(&origin, p1, &offset);
+    float length = EcsVector2D_dot(&edge, &edge);
+    float along = length > 0 ? EcsVector2D_dot(&offset, &edge) / length : 0;
+    along = along < 0 ? 0 : (along > 1 ? 1 : along);
+    float x = VECTOR_X(&offset) - VECTOR_X(&edge) * along;
+    float y = VECTOR_Y(&offset) - VECTOR_Y(&edge) * along;
+    if (x * x + y * y <= radius * radius) {
+        return false;
+    }
+
+    float best = INFINITY;
+    EcsVector2D normal = {0, 0};
+    EcsVector2D side;
+    if (length > 0 && EcsVector2D_get_normal(&edge, &side) && EcsVector2D_normalize(&side, &side)) {
+        for (int32_t i = 0; i < 2; i++) {
+            float closing = EcsVector2D_dot(&side, &translation);
+            if (closing < 0) {
+                float t = (radius - EcsVector2D_dot(&side, &offset)) / closing;
+                float hit = EcsVector2D_dot(&offset, &edge) + EcsVector2D_dot(&translation, &edge) * t;
+                if (t >= 0 && t < best && hit >= 0 && hit <= length) {
+                    best = t;
+                    VECTOR_X(&normal) = VECTOR_X(&side);
+                    VECTOR_Y(&normal) = VECTOR_Y(&side);
+                }
+            }
+            EcsVector2D_scale(&side, -1, &side);
+        }
+    }
+    for (int32_t i = 0; i < 2; i++) {
+        EcsPoint *center = i == 0 ? p1 : p2;
+        float t = EcsPhysis2dRaycast_circleFraction(&origin, &translation, center, radius);
+        if (t >= best) {
+            continue;
+        }
+        best = t;
+        VECTOR_X(&normal) = (VECTOR_X(&origin) + VECTOR_X(&translation) * t - VECTOR_X(center)) / radius;
+        VECTOR_Y(&normal) = (VECTOR_Y(&origin) + VECTOR_Y(&translation) * t - VECTOR_Y(center)) / radius;
+    }
+    if (best > ray->max_fraction) {
+        return false;
+    }
+    hit_out->fraction = best;
+    EcsRotation_rotate(&transform.rotation, &normal, &hit_out->normal);
+    VECTOR_X(&hit_out->point) = VECTOR_X(&ray->origin) + VECTOR_X(&ray->translation) * best;
+    VECTOR_Y(&hit_out->point) = VECTOR_Y(&ray->origin) + VECTOR_Y(&ray->translation) * best;
+    return true;
+}
+
+/*
+ * First fraction where origin + translation * t is radius away from center,
+ * INFINITY when the ray starts inside or never gets there.
+ */
+static float EcsPhysis2dRaycast_circleFraction(
+    EcsVector2D *origin, EcsVector2D *translation,
+    EcsVector2D *center, float radius)
+{
+    EcsVector2D offset;
+    EcsVector2D_sub(origin, center, &offset);
+    float c = EcsVector2D_dot(&offset, &offset) - radius * radius;
+    if (c <= 0) {
+        return INFINITY;
+    }
+    float b = EcsVector2D_dot(&offset, translation);
+    float a = EcsVector2D_dot(translation, translation);
+    float discriminant = b * b - a * c;
+    if (b >= 0 || a <= 0 || discriminant < 0) {
+        return INFINITY;
+    }
+    return (-b - sqrtf(discriminant)) / a;
+}
@@ -0,0 +1,149 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <stdlib.h>
+#include <string.h>
+
+static EcsSatCacheEntry* EcsSatCache_find(
+    EcsSatCacheEntry *entries, int32_t size,
+    EcsPolygonCollider *polygon_a, EcsPoint *position_a,
+    EcsPolygonCollider *polygon_b, EcsPoint *position_b);
+static int8_t EcsSatCache_resize(EcsSatCache *cache, int32_t size);
+
+void EcsSatCache_init(EcsSatCache *cache)
+{
+    cache->entries = NULL;
+    cache->spare = NULL;
+    cache->size = 0;
+    cache->count = 0;
+    cache->stamp = 1;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+void EcsSatCache_deinit(EcsSatCache *cache)
+{
+    free(cache->entries);
+    free(cache->spare);
+    EcsSatCache_init(cache);
+}
+
+void EcsSatCache_begin(EcsSatCache *cache)
+{
+    if (cache == NULL || cache->entries == NULL) {
+        return;
+    }
+    // Rehash the pairs tested on the last step into the spare table
+    EcsSatCacheEntry *entries = cache->entries;
+    EcsSatCacheEntry *spare = cache->spare;
+    int32_t count = 0;
+    memset(spare, 0, cache->size * sizeof(EcsSatCacheEntry));
+    for (int32_t i = 0; i < cache->size; i++) {
+        if (entries[i].polygon_a == NULL || entries[i].stamp != cache->stamp) {
+            continue;
+        }
+        *EcsSatCache_find(spare, cache->size,
+            entries[i].polygon_a, entries[i].position_a,
+            entries[i].polygon_b, entries[i].position_b) = entries[i];
+        count++;
+    }
+    cache->entries = spare;
+    cache->spare = entries;
+    cache->count = count;
+    cache->stamp++;
+}
+
+void EcsSatCache_resetStats(EcsSatCache *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+EcsSatCacheEntry* EcsSatCache_getEntry(EcsSatCache *cache, ColliderData_t *collider_a, ColliderData_t *collider_b, int8_t *swapped_out)
+{
+    // The key orders the colliders by polygon, then by position
+    *swapped_out = collider_b->polygon < collider_a->polygon ||
+        (collider_b->polygon == collider_a->polygon && collider_b->position < collider_a->position);
+    if (*swapped_out) {
+        ColliderData_t *tmp = collider_a;
+        collider_a = collider_b;
+        collider_b = tmp;
+    }
+    EcsPolygonCollider *polygon_a = collider_a->polygon;
+    EcsPolygonCollider *polygon_b = collider_b->polygon;
+    EcsPoint *position_a = collider_a->position;
+    EcsPoint *position_b = collider_b->position;
+
+    // Only inserts resize the table, lookups of existing pairs never move it
+    EcsSatCacheEntry *entry = cache->size ?
+        EcsSatCache_find(cache->entries, cache->size, polygon_a, position_a, polygon_b, position_b) : NULL;
+    if ((entry == NULL || entry->polygon_a == NULL) && (cache->count + 1) * 2 > cache->size) {
+        if (!EcsSatCache_resize(cache, cache->size ? cache->size * 2 : 64)) {
+            return NULL;
+        }
+        entry = EcsSatCache_find(cache->entries, cache->size, polygon_a, position_a, polygon_b, position_b);
+    }
+    if (entry->polygon_a == NULL) {
+        entry->polygon_a = polygon_a;
+        entry->position_a = position_a;
+        entry->polygon_b = polygon_b;
+        entry->position_b = position_b;
+        entry->owner = -1;
+        entry->edge = 0;
+        cache->count++;
+    }
+    entry->stamp = cache->stamp;
+    return entry;
+}
+
+/* Returns the slot of the pair, or the empty slot where it should go */
+static EcsSatCacheEntry* EcsSatCache_find(
+    EcsSatCacheEntry *entries, int32_t size,
+    EcsPolygonCollider *polygon_a, EcsPoint *position_a,
+    EcsPolygonCollider *polygon_b, EcsPoint *position_b)
+{
+    uint32_t mask = (uint32_t)size - 1;
+    uint32_t hash = (uint32_t)((uintptr_t)polygon_a >> 4) * 2654435761u;
+    hash ^= (uint32_t)((uintptr_t)polygon_b >> 4) * 2246822519u;
+    hash ^= (uint32_t)((uintptr_t)position_a >> 4) * 3266489917u;
+    hash ^= (uint32_t)((uintptr_t)position_b >> 4) * 668265263u;
+    uint32_t slot = hash & mask;
+    for (;;) {
+        EcsSatCacheEntry *entry = &entries[slot];
+        if (entry->polygon_a == NULL ||
+            (entry->polygon_a == polygon_a && entry->position_a == position_a &&
+             entry->polygon_b == polygon_b && entry->position_b == position_b)) {
+            return entry;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static int8_t EcsSatCache_resize(EcsSatCache *cache, int32_t size)
+{
+    EcsSatCacheEntry *entries = calloc(size, sizeof(EcsSatCacheEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    EcsSatCacheEntry *spare = realloc(cache->spare, size * sizeof(EcsSatCacheEntry));
+    if (spare == NULL) {
+        free(entries);
+        return false;
+    }
+    cache->spare = spare;
+
+    EcsSatCacheEntry *old = cache->entries;
+    for (int32_t i = 0; i < cache->size; i++) {
+        if (old[i].polygon_a != NULL) {
+            *EcsSatCache_find(entries, size,
+                old[i].polygon_a, old[i].position_a,
+                old[i].polygon_b, old[i].position_b) = old[i];
+        }
+    }
+    free(old);
+    cache->entries = entries;
+    cache->size = size;
+    return true;
+}
@@ -0,0 +1,231 @@
+#include "include/physics_simd.h"
+#include "private.h"
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define PROJECTION_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PROJECTION_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Fused multiply-add would change the results of the vector kernels. The
+ * whole library is built with -ffp-contract=off, this keeps the kernels
+ * exact when the sources are built without project.json.
+ */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+typedef void (*EcsProjectionFunction)(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max);
+
+static void EcsPhysis2d_projectScalar(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max);
+#ifdef PROJECTION_X86
+static void EcsPhysis2d_projectSse2(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max);
+static void EcsPhysis2d_projectAvx2(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max);
+#endif
+#ifdef PROJECTION_NEON
+static void EcsPhysis2d_projectNeon(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max);
+#endif
+static EcsProjectionKernel EcsPhysis2d_detectKernel(void);
+static void EcsPhysis2d_initKernel(void);
+static int8_t EcsPhysis2d_selectKernel(EcsProjectionKernel kernel);
+
+static EcsProjectionFunction projection_function = NULL;
+static EcsProjectionKernel projection_kernel = EcsProjectionKernelAuto;
+// The kernel is detected once, the first projection can come from any thread
+static pthread_once_t projection_once = PTHREAD_ONCE_INIT;
+
+void EcsPhysis2d_projectSoA(EcsVector2D *axis, const float *xs, const float *ys, int32_t count, EcsVector2D *out)
+{
+    if (axis == NULL || xs == NULL || ys == NULL || out == NULL) {
+        return;
+    }
+    pthread_once(&projection_once, EcsPhysis2d_initKernel);
+    float min = INFINITY;
+    float max = -INFINITY;
+    projection_function(VECTOR_X(axis), VECTOR_Y(axis), xs, ys, count, &min, &max);
+    // -0 and +0 compare equal, so which one wins depends on the order
+    VECTOR_X(out) = min + 0.0f;
+    VECTOR_Y(out) = max + 0.0f;
+}
+
+int8_t EcsPhysis2d_setProjectionKernel(EcsProjectionKernel kernel)
+{
+    // Detect first so a later first projection does not undo the choice
+    pthread_once(&projection_once, EcsPhysis2d_initKernel);
+    return EcsPhysis2d_selectKernel(kernel);
+}
+
+static int8_t EcsPhysis2d_selectKernel(EcsProjectionKernel kernel)
+{
+    if (kernel == EcsProjectionKernelAuto) {
+        kernel = EcsPhysis2d_detectKernel();
+    }
+    switch (kernel) {
+    case EcsProjectionKernelScalar:
+        projection_function = EcsPhysis2d_projectScalar;
+        break;
+#ifdef PROJECTION_X86
+    case EcsProjectionKernelSse2:
+        if (!__builtin_cpu_supports("sse2")) {
+            return false;
+        }
+        projection_function = EcsPhysis2d_projectSse2;
+        break;
+    case EcsProjectionKernelAvx2:
+        if (!__builtin_cpu_supports("avx2")) {
+            return false;
+        }
+        projection_function = EcsPhysis2d_projectAvx2;
+        break;
+#endif
+#ifdef PROJECTION_NEON
+    case EcsProjectionKernelNeon:
+        projection_function = EcsPhysis2d_projectNeon;
+        break;
+#endif
+    default:
+        return false;
+    }
+    projection_kernel = kernel;
+    return true;
+}
+
+EcsProjectionKernel EcsPhysis2d_getProjectionKernel(void)
+{
+    pthread_once(&projection_once, EcsPhysis2d_initKernel);
+    return projection_kernel;
+}
+
+static void EcsPhysis2d_initKernel(void)
+{
+#ifdef PROJECTION_X86
+    __builtin_cpu_init();
+#endif
+    EcsPhysis2d_selectKernel(EcsProjectionKernelAuto);
+}
+
+static EcsProjectionKernel EcsPhysis2d_detectKernel(void)
+{
+#if defined(PROJECTION_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return EcsProjectionKernelAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return EcsProjectionKernelSse2;
+    }
+#elif defined(PROJECTION_NEON)
+    return EcsProjectionKernelNeon;
+#endif
+    return EcsProjectionKernelScalar;
+}
+
+static void EcsPhysis2d_projectScalar(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max)
+{
+    for (int32_t i = 0; i < count; i++) {
+        float t = ax * xs[i] + ay * ys[i];
+        if (t < *min) {
+            *min = t;
+        }
+        if (t > *max) {
+            *max = t;
+        }
+    }
+}
+
+#ifdef PROJECTION_X86
+static void EcsPhysis2d_projectSse2(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max)
+{
+    __m128 axis_x = _mm_set1_ps(ax);
+    __m128 axis_y = _mm_set1_ps(ay);
+    __m128 vmin = _mm_set1_ps(*min);
+    __m128 vmax = _mm_set1_ps(*max);
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_add_ps(_mm_mul_ps(axis_x, _mm_loadu_ps(&xs[i])),
+                              _mm_mul_ps(axis_y, _mm_loadu_ps(&ys[i])));
+        // NaN takes the second operand, so like the scalar compare it is skipped
+        vmin = _mm_min_ps(t, vmin);
+        vmax = _mm_max_ps(t, vmax);
+    }
+    float lanes_min[4];
+    float lanes_max[4];
+    _mm_storeu_ps(lanes_min, vmin);
+    _mm_storeu_ps(lanes_max, vmax);
+    for (int32_t l = 0; l < 4; l++) {
+        if (lanes_min[l] < *min) {
+            *min = lanes_min[l];
+        }
+        if (lanes_max[l] > *max) {
+            *max = lanes_max[l];
+        }
+    }
+    EcsPhysis2d_projectScalar(ax, ay, &xs[i], &ys[i], count - i, min, max);
+}
+
+__attribute__((target("avx2")))
+static void EcsPhysis2d_projectAvx2(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max)
+{
+    __m256 axis_x = _mm256_set1_ps(ax);
+    __m256 axis_y = _mm256_set1_ps(ay);
+    __m256 vmin = _mm256_set1_ps(*min);
+    __m256 vmax = _mm256_set1_ps(*max);
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 t = _mm256_add_ps(_mm256_mul_ps(axis_x, _mm256_loadu_ps(&xs[i])),
+                                 _mm256_mul_ps(axis_y, _mm256_loadu_ps(&ys[i])));
+        vmin = _mm256_min_ps(t, vmin);
+        vmax = _mm256_max_ps(t, vmax);
+    }
+    float lanes_min[8];
+    float lanes_max[8];
+    _mm256_storeu_ps(lanes_min, vmin);
+    _mm256_storeu_ps(lanes_max, vmax);
+    for (int32_t l = 0; l < 8; l++) {
+        if (lanes_min[l] < *min) {
+            *min = lanes_min[l];
+        }
+        if (lanes_max[l] > *max) {
+            *max = lanes_max[l];
+        }
+    }
+    EcsPhysis2d_projectScalar(ax, ay, &xs[i], &ys[i], count - i, min, max);
+}
+#endif
+
+#ifdef PROJECTION_NEON
+static void EcsPhysis2d_projectNeon(float ax, float ay, const float *xs, const float *ys, int32_t count, float *min, float *max)
+{
+    float32x4_t axis_x = vdupq_n_f32(ax);
+    float32x4_t axis_y = vdupq_n_f32(ay);
+    float32x4_t vmin = vdupq_n_f32(*min);
+    float32x4_t vmax = vdupq_n_f32(*max);
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t t = vaddq_f32(vmulq_f32(axis_x, vld1q_f32(&xs[i])),
+                                  vmulq_f32(axis_y, vld1q_f32(&ys[i])));
+        // vminq_f32 returns NaN, select on the compare to skip it instead
+        vmin = vbslq_f32(vcltq_f32(t, vmin), t, vmin);
+        vmax = vbslq_f32(vcgtq_f32(t, vmax), t, vmax);
+    }
+    float lanes_min[4];
+    float lanes_max[4];
+    vst1q_f32(lanes_min, vmin);
+    vst1q_f32(lanes_max, vmax);
+    for (int32_t l = 0; l < 4; l++) {
+        if (lanes_min[l] < *min) {
+            *min = lanes_min[l];
+        }
+        if (lanes_max[l] > *max) {
+            *max = lanes_max[l];
+        }
+    }
+    EcsPhysis2d_projectScalar(ax, ay, &xs[i], &ys[i], count - i, min, max);
+}
+#endif
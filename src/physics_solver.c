@@ -0,0 +1,689 @@
+#include "include/physics_solver.h"
+#include "private.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CROSS(ax, ay, bx, by) ((ax) * (by) - (ay) * (bx))
+
+static int8_t EcsContactSolver_reserve(EcsContactSolver *solver, int32_t contact_count, int32_t body_count);
+static void EcsContactSolver_prepare(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count,
+    float inv_dt);
+static void EcsContactSolver_warmStart(EcsContactSolver *solver, EcsSolverBodies *bodies);
+static void EcsContactSolver_solveVelocities(EcsContactSolver *solver, EcsSolverBodies *bodies);
+static void EcsContactSolver_solvePositions(EcsContactSolver *solver, EcsSolverBodies *bodies);
+static void EcsContactSolver_storeImpulses(EcsContactSolver *solver);
+static void EcsContactSolver_wake(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count);
+static void EcsContactSolver_wakeIsland(EcsContactSolver *solver, EcsSolverBodies *bodies, int32_t body);
+static void EcsContactSolver_updateSleep(EcsContactSolver *solver, EcsSolverBodies *bodies, float dt);
+static int8_t EcsContactSolver_isMoving(EcsSolverBodies *bodies, int32_t body);
+static int32_t EcsContactSolver_findIsland(int32_t *islands, int32_t body);
+static void EcsContactSolver_applyImpulse(
+    EcsVelocity2D *velocity_a, float inverse_mass_a, float inverse_inertia_a, EcsVector2D *anchor_a,
+    EcsVelocity2D *velocity_b, float inverse_mass_b, float inverse_inertia_b, EcsVector2D *anchor_b,
+    float x, float y);
+static void EcsContactSolver_getRelativeVelocity(
+    EcsVelocity2D *velocity_a, EcsVector2D *anchor_a,
+    EcsVelocity2D *velocity_b, EcsVector2D *anchor_b,
+    EcsVector2D *out);
+static void EcsContactSolver_integrate(EcsSolverBodies *bodies, EcsVelocity2D *velocities, float dt);
+static EcsSolverCacheEntry* EcsContactSolver_find(EcsSolverCacheEntry *table, int32_t size, int32_t a, int32_t b);
+
+void EcsMass_set(EcsMass *mass_out, float mass, float inertia)
+{
+    if (mass_out == NULL) {
+        return;
+    }
+    mass_out->inverse_mass = mass > 0 ? 1.0f / mass : 0;
+    mass_out->inverse_inertia = inertia > 0 ? 1.0f / inertia : 0;
+}
+
+int8_t EcsMass_circle(EcsMass *mass_out, EcsCircleCollider *circle, float density)
+{
+    if (mass_out == NULL || circle == NULL) {
+        return false;
+    }
+    float radius = circle->radius;
+    float mass = density * (float)M_PI * radius * radius;
+    EcsMass_set(mass_out, mass, 0.5f * mass * radius * radius);
+    return true;
+}
+
+int8_t EcsMass_polygon(EcsMass *mass_out, EcsPolygonCollider *polygon, float density)
+{
+    if (mass_out == NULL || polygon == NULL || polygon->points == NULL || polygon->points_count < 3) {
+        return false;
+    }
+    // Fan of triangles from the center of mass, signed by the winding
+    float area = 0;
+    float inertia = 0;
+    int32_t size = polygon->points_count;
+    for (int32_t i = 0; i < size; i++) {
+        EcsPoint *p1 = &polygon->points[i];
+        EcsPoint *p2 = &polygon->points[(i + 1) % size];
+        float cross = CROSS(VECTOR_X(p1), VECTOR_Y(p1), VECTOR_X(p2), VECTOR_Y(p2));
+        float xx = VECTOR_X(p1) * VECTOR_X(p1) + VECTOR_X(p1) * VECTOR_X(p2) + VECTOR_X(p2) * VECTOR_X(p2);
+        float yy = VECTOR_Y(p1) * VECTOR_Y(p1) + VECTOR_Y(p1) * VECTOR_Y(p2) + VECTOR_Y(p2) * VECTOR_Y(p2);
+        area += 0.5f * cross;
+        inertia += cross * (xx + yy) / 12.0f;
+    }
+    EcsMass_set(mass_out, density * fabsf(area), density * fabsf(inertia));
+    return true;
+}
+
+int8_t EcsMass_capsule(EcsMass *mass_out, EcsCapsuleCollider *capsule, float density)
+{
+    if (mass_out == NULL || capsule == NULL) {
+        return false;
+    }
+    // Rectangle along the segment plus two half circles at its ends
+    float radius = capsule->radius;
+    float length = EcsVector2D_distance(&capsule->point1, &capsule->point2);
+    float box_mass = density * 2.0f * radius * length;
+    float circle_mass = density * (float)M_PI * radius * radius;
+    float half = 0.5f * length;
+    float centroid = 4.0f * radius / (3.0f * (float)M_PI);
+    float circle_inertia = circle_mass * (0.5f * radius * radius + half * half + 2.0f * half * centroid);
+    float box_inertia = box_mass * (4.0f * radius * radius + length * length) / 12.0f;
+    EcsMass_set(mass_out, box_mass + circle_mass, circle_inertia + box_inertia);
+    return true;
+}
+
+int8_t EcsMass_box(EcsMass *mass_out, EcsBoxCollider *box, float density)
+{
+    if (mass_out == NULL || box == NULL) {
+        return false;
+    }
+    float mass = density * 4.0f * VECTOR_X(&box->half_extents) * VECTOR_Y(&box->half_extents);
+    EcsMass_set(mass_out, mass, 0);
+    return true;
+}
+
+void EcsContactSolver_init(EcsContactSolver *solver)
+{
+    memset(solver, 0, sizeof(EcsContactSolver));
+    solver->settings.velocity_iterations = 8;
+    solver->settings.position_iterations = 3;
+    solver->settings.baumgarte = 0.2f;
+    solver->settings.slop = 0.005f;
+    solver->settings.restitution_threshold = 1.0f;
+    solver->settings.warm_starting = true;
+    solver->settings.material.friction = 0.6f;
+    solver->settings.material.restitution = 0;
+    solver->settings.sleep_linear_speed = 0.05f;
+    solver->settings.sleep_angular_speed = 0.05f;
+    solver->settings.sleep_time = 0.5f;
+}
+
+void EcsContactSolver_deinit(EcsContactSolver *solver)
+{
+    free(solver->contacts);
+    free(solver->cache);
+    free(solver->spare);
+    free(solver->split_velocities);
+    free(solver->islands);
+    free(solver->island_times);
+    free(solver->sleep_links);
+    EcsContactSolver_init(solver);
+}
+
+int8_t EcsContactSolver_step(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count,
+    float dt)
+{
+    if (solver == NULL || bodies == NULL || bodies->positions == NULL || bodies->velocities == NULL ||
+        bodies->masses == NULL || dt <= 0 || (contact_count > 0 && (pairs == NULL || manifolds == NULL))) {
+        return false;
+    }
+    if (!EcsContactSolver_reserve(solver, contact_count, bodies->count)) {
+        return false;
+    }
+    STATS_BEGIN(timer);
+    EcsSolverSettings *settings = &solver->settings;
+    int8_t sleeps = bodies->sleeping != NULL && bodies->sleep_times != NULL;
+    if (sleeps) {
+        EcsContactSolver_wake(solver, bodies, pairs, manifolds, contact_count);
+    }
+
+    for (int32_t i = 0; i < bodies->count; i++) {
+        if (sleeps && bodies->sleeping[i]) {
+            continue;
+        }
+        if (bodies->masses[i].inverse_mass > 0) {
+            bodies->velocities[i].linear[0] += settings->gravity[0] * dt;
+            bodies->velocities[i].linear[1] += settings->gravity[1] * dt;
+        }
+    }
+
+    EcsContactSolver_prepare(solver, bodies, pairs, manifolds, contact_count, 1.0f / dt);
+    if (settings->warm_starting) {
+        EcsContactSolver_warmStart(solver, bodies);
+    }
+    for (int32_t i = 0; i < settings->velocity_iterations; i++) {
+        EcsContactSolver_solveVelocities(solver, bodies);
+    }
+    EcsContactSolver_storeImpulses(solver);
+    EcsContactSolver_integrate(bodies, bodies->velocities, dt);
+
+    // Split impulses move the bodies out of each other without keeping the
+    // velocity, Baumgarte on the real velocities would make stacks bounce
+    memset(solver->split_velocities, 0, bodies->count * sizeof(EcsVelocity2D));
+    for (int32_t i = 0; i < settings->position_iterations; i++) {
+        EcsContactSolver_solvePositions(solver, bodies);
+    }
+    EcsContactSolver_integrate(bodies, solver->split_velocities, dt);
+    if (sleeps) {
+        EcsContactSolver_updateSleep(solver, bodies, dt);
+    }
+    STATS_END(EcsStatsStageSolver, timer);
+    return true;
+}
+
+static void EcsContactSolver_prepare(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count,
+    float inv_dt)
+{
+    EcsSolverSettings *settings = &solver->settings;
+    int32_t count = 0;
+    for (int32_t i = 0; i < contact_count; i++) {
+        EcsContactManifold *manifold = &manifolds[i];
+        int32_t a = pairs[i].a;
+        int32_t b = pairs[i].b;
+        EcsMass *mass_a = &bodies->masses[a];
+        EcsMass *mass_b = &bodies->masses[b];
+        if (manifold->points_count <= 0 || (mass_a->inverse_mass == 0 && mass_b->inverse_mass == 0)) {
+            continue;
+        }
+        // Sleeping bodies only touch static bodies and each other after wake
+        if (bodies->sleeping != NULL && bodies->sleep_times != NULL &&
+            (bodies->sleeping[a] || mass_a->inverse_mass == 0) && (bodies->sleeping[b] || mass_b->inverse_mass == 0)) {
+            continue;
+        }
+        EcsMaterial *material_a = bodies->materials != NULL ? &bodies->materials[a] : &settings->material;
+        EcsMaterial *material_b = bodies->materials != NULL ? &bodies->materials[b] : &settings->material;
+        float inertia_a = bodies->rotations != NULL ? mass_a->inverse_inertia : 0;
+        float inertia_b = bodies->rotations != NULL ? mass_b->inverse_inertia : 0;
+        float nx = VECTOR_X(&manifold->normal);
+        float ny = VECTOR_Y(&manifold->normal);
+
+        EcsSolverContact *contact = &solver->contacts[count++];
+        contact->a = a;
+        contact->b = b;
+        VECTOR_X(&contact->normal) = nx;
+        VECTOR_Y(&contact->normal) = ny;
+        contact->friction = sqrtf(material_a->friction * material_b->friction);
+        contact->restitution = material_a->restitution > material_b->restitution ?
+            material_a->restitution : material_b->restitution;
+        contact->points_count = manifold->points_count;
+
+        EcsSolverCacheEntry *cached = NULL;
+        if (settings->warm_starting && solver->cache_size > 0) {
+            cached = EcsContactSolver_find(solver->cache, solver->cache_size, a, b);
+            cached = cached->a == -1 ? NULL : cached;
+        }
+
+        for (int32_t j = 0; j < manifold->points_count; j++) {
+            EcsContactPoint *source = &manifold->points[j];
+            EcsSolverContactPoint *point = &contact->points[j];
+            EcsVector2D_sub(&source->position, &bodies->positions[a], &point->anchor_a);
+            EcsVector2D_sub(&source->position, &bodies->positions[b], &point->anchor_b);
+            float rax = VECTOR_X(&point->anchor_a), ray = VECTOR_Y(&point->anchor_a);
+            float rbx = VECTOR_X(&point->anchor_b), rby = VECTOR_Y(&point->anchor_b);
+
+            float rna = CROSS(rax, ray, nx, ny);
+            float rnb = CROSS(rbx, rby, nx, ny);
+            float k = mass_a->inverse_mass + mass_b->inverse_mass + inertia_a * rna * rna + inertia_b * rnb * rnb;
+            point->normal_mass = k > 0 ? 1.0f / k : 0;
+
+            // Tangent is the normal turned clockwise, (ny, -nx)
+            float rta = CROSS(rax, ray, ny, -nx);
+            float rtb = CROSS(rbx, rby, ny, -nx);
+            k = mass_a->inverse_mass + mass_b->inverse_mass + inertia_a * rta * rta + inertia_b * rtb * rtb;
+            point->tangent_mass = k > 0 ? 1.0f / k : 0;
+
+            EcsVector2D relative;
+            EcsContactSolver_getRelativeVelocity(
+                &bodies->velocities[a], &point->anchor_a, &bodies->velocities[b], &point->anchor_b, &relative);
+            float normal_speed = VECTOR_X(&relative) * nx + VECTOR_Y(&relative) * ny;
+            point->velocity_bias = normal_speed < -settings->restitution_threshold ?
+                -contact->restitution * normal_speed : 0;
+            float penetration = source->depth - settings->slop;
+            point->position_bias = penetration > 0 ? settings->baumgarte * inv_dt * penetration : 0;
+
+            point->id = source->id;
+            point->normal_impulse = 0;
+            point->tangent_impulse = 0;
+            point->split_impulse = 0;
+            for (int32_t c = 0; cached != NULL && c < cached->points_count; c++) {
+                if (cached->ids[c] == point->id) {
+                    point->normal_impulse = cached->normal_impulses[c];
+                    point->tangent_impulse = cached->tangent_impulses[c];
+                    break;
+                }
+            }
+        }
+    }
+    solver->count = count;
+}
+
+static void EcsContactSolver_warmStart(EcsContactSolver *solver, EcsSolverBodies *bodies)
+{
+    int8_t rotates = bodies->rotations != NULL;
+    for (int32_t i = 0; i < solver->count; i++) {
+        EcsSolverContact *contact = &solver->contacts[i];
+        EcsMass *mass_a = &bodies->masses[contact->a];
+        EcsMass *mass_b = &bodies->masses[contact->b];
+        float nx = VECTOR_X(&contact->normal);
+        float ny = VECTOR_Y(&contact->normal);
+        for (int32_t j = 0; j < contact->points_count; j++) {
+            EcsSolverContactPoint *point = &contact->points[j];
+            float x = point->normal_impulse * nx + point->tangent_impulse * ny;
+            float y = point->normal_impulse * ny - point->tangent_impulse * nx;
+            EcsContactSolver_applyImpulse(
+                &bodies->velocities[contact->a], mass_a->inverse_mass, rotates ? mass_a->inverse_inertia : 0, &point->anchor_a,
+                &bodies->velocities[contact->b], mass_b->inverse_mass, rotates ? mass_b->inverse_inertia : 0, &point->anchor_b,
+                x, y);
+        }
+    }
+}
+
+static void EcsContactSolver_solveVelocities(EcsContactSolver *solver, EcsSolverBodies *bodies)
+{
+    int8_t rotates = bodies->rotations != NULL;
+    for (int32_t i = 0; i < solver->count; i++) {
+        EcsSolverContact *contact = &solver->contacts[i];
+        EcsVelocity2D *velocity_a = &bodies->velocities[contact->a];
+        EcsVelocity2D *velocity_b = &bodies->velocities[contact->b];
+        float mass_a = bodies->masses[contact->a].inverse_mass;
+        float mass_b = bodies->masses[contact->b].inverse_mass;
+        float inertia_a = rotates ? bodies->masses[contact->a].inverse_inertia : 0;
+        float inertia_b = rotates ? bodies->masses[contact->b].inverse_inertia : 0;
+        float nx = VECTOR_X(&contact->normal);
+        float ny = VECTOR_Y(&contact->normal);
+        EcsVector2D relative;
+
+        // Friction first, its bound depends on the normal impulse of the last iteration
+        for (int32_t j = 0; j < contact->points_count; j++) {
+            EcsSolverContactPoint *point = &contact->points[j];
+            EcsContactSolver_getRelativeVelocity(velocity_a, &point->anchor_a, velocity_b, &point->anchor_b, &relative);
+            float tangent_speed = VECTOR_X(&relative) * ny - VECTOR_Y(&relative) * nx;
+            float limit = contact->friction * point->normal_impulse;
+            float impulse = point->tangent_impulse - point->tangent_mass * tangent_speed;
+            impulse = impulse > limit ? limit : (impulse < -limit ? -limit : impulse);
+            float delta = impulse - point->tangent_impulse;
+            point->tangent_impulse = impulse;
+            EcsContactSolver_applyImpulse(
+                velocity_a, mass_a, inertia_a, &point->anchor_a,
+                velocity_b, mass_b, inertia_b, &point->anchor_b,
+                delta * ny, -delta * nx);
+        }
+        for (int32_t j = 0; j < contact->points_count; j++) {
+            EcsSolverContactPoint *point = &contact->points[j];
+            EcsContactSolver_getRelativeVelocity(velocity_a, &point->anchor_a, velocity_b, &point->anchor_b, &relative);
+            float normal_speed = VECTOR_X(&relative) * nx + VECTOR_Y(&relative) * ny;
+            float impulse = point->normal_impulse - point->normal_mass * (normal_speed - point->velocity_bias);
+            impulse = impulse > 0 ? impulse : 0;
+            float delta = impulse - point->normal_impulse;
+            point->normal_impulse = impulse;
+            EcsContactSolver_applyImpulse(
+                velocity_a, mass_a, inertia_a, &point->anchor_a,
+                velocity_b, mass_b, inertia_b, &point->anchor_b,
+                delta * nx, delta * ny);
+        }
+    }
+}
+
+static void EcsContactSolver_solvePositions(EcsContactSolver *solver, EcsSolverBodies *bodies)
+{
+    int8_t rotates = bodies->rotations != NULL;
+    for (int32_t i = 0; i < solver->count; i++) {
+        EcsSolverContact *contact = &solver->contacts[i];
+        EcsVelocity2D *velocity_a = &solver->split_velocities[contact->a];
+        EcsVelocity2D *velocity_b = &solver->split_velocities[contact->b];
+        float mass_a = bodies->masses[contact->a].inverse_mass;
+        float mass_b = bodies->masses[contact->b].inverse_mass;
+        float inertia_a = rotates ? bodies->masses[contact->a].inverse_inertia : 0;
+        float inertia_b = rotates ? bodies->masses[contact->b].inverse_inertia : 0;
+        float nx = VECTOR_X(&contact->normal);
+        float ny = VECTOR_Y(&contact->normal);
+        EcsVector2D relative;
+
+        for (int32_t j = 0; j < contact->points_count; j++) {
+            EcsSolverContactPoint *point = &contact->points[j];
+            if (point->position_bias == 0) {
+                continue;
+            }
+            EcsContactSolver_getRelativeVelocity(velocity_a, &point->anchor_a, velocity_b, &point->anchor_b, &relative);
+            float normal_speed = VECTOR_X(&relative) * nx + VECTOR_Y(&relative) * ny;
+            float impulse = point->split_impulse - point->normal_mass * (normal_speed - point->position_bias);
+            impulse = impulse > 0 ? impulse : 0;
+            float delta = impulse - point->split_impulse;
+            point->split_impulse = impulse;
+            EcsContactSolver_applyImpulse(
+                velocity_a, mass_a, inertia_a, &point->anchor_a,
+                velocity_b, mass_b, inertia_b, &point->anchor_b,
+                delta * nx, delta * ny);
+        }
+    }
+}
+
+/*
+ * Wakes the islands touched by a moving body and the islands of the bodies
+ * woken from outside since the last step
+ */
+static void EcsContactSolver_wake(
+    EcsContactSolver *solver,
+    EcsSolverBodies *bodies,
+    EcsColliderPair *pairs,
+    EcsContactManifold *manifolds,
+    int32_t contact_count)
+{
+    for (int32_t i = 0; i < bodies->count; i++) {
+        // Linked but not sleeping, woken from outside
+        if (!bodies->sleeping[i] && solver->sleep_links[i] != -1) {
+            EcsContactSolver_wakeIsland(solver, bodies, i);
+        }
+    }
+    for (int32_t i = 0; i < contact_count; i++) {
+        if (manifolds[i].points_count <= 0) {
+            continue;
+        }
+        int32_t a = pairs[i].a;
+        int32_t b = pairs[i].b;
+        // Static bodies can be kept sleeping, they are never woken
+        if (bodies->sleeping[a] && bodies->masses[a].inverse_mass > 0 && EcsContactSolver_isMoving(bodies, b)) {
+            EcsContactSolver_wakeIsland(solver, bodies, a);
+        } else if (bodies->sleeping[b] && bodies->masses[b].inverse_mass > 0 && EcsContactSolver_isMoving(bodies, a)) {
+            EcsContactSolver_wakeIsland(solver, bodies, b);
+        }
+    }
+}
+
+static void EcsContactSolver_wakeIsland(EcsContactSolver *solver, EcsSolverBodies *bodies, int32_t body)
+{
+    // The ring is stale when bodies were removed since the island slept, the
+    // guard stops the walk, at worst waking unrelated bodies
+    int32_t i = body;
+    for (int32_t guard = 0; guard < bodies->count; guard++) {
+        bodies->sleeping[i] = false;
+        bodies->sleep_times[i] = 0;
+        int32_t next = solver->sleep_links[i];
+        solver->sleep_links[i] = -1;
+        if (next == body || next < 0 || next >= bodies->count) {
+            break;
+        }
+        i = next;
+    }
+}
+
+/*
+ * Builds the islands of the awake dynamic bodies from the contacts of the
+ * step and puts to sleep the ones that stayed at rest for sleep_time
+ */
+static void EcsContactSolver_updateSleep(EcsContactSolver *solver, EcsSolverBodies *bodies, float dt)
+{
+    EcsSolverSettings *settings = &solver->settings;
+    int32_t *islands = solver->islands;
+    float *island_times = solver->island_times;
+    float linear2 = settings->sleep_linear_speed * settings->sleep_linear_speed;
+
+    for (int32_t i = 0; i < bodies->count; i++) {
+        islands[i] = i;
+        if (bodies->sleeping[i] || bodies->masses[i].inverse_mass == 0) {
+            continue;
+        }
+        EcsVelocity2D *velocity = &bodies->velocities[i];
+        float speed2 = velocity->linear[0] * velocity->linear[0] + velocity->linear[1] * velocity->linear[1];
+        if (speed2 > linear2 || fabsf(velocity->angular) > settings->sleep_angular_speed) {
+            bodies->sleep_times[i] = 0;
+        } else {
+            bodies->sleep_times[i] += dt;
+        }
+    }
+
+    for (int32_t i = 0; i < solver->count; i++) {
+        int32_t a = solver->contacts[i].a;
+        int32_t b = solver->contacts[i].b;
+        int8_t dynamic_a = bodies->masses[a].inverse_mass > 0;
+        int8_t dynamic_b = bodies->masses[b].inverse_mass > 0;
+        if (dynamic_a && dynamic_b) {
+            int32_t root_a = EcsContactSolver_findIsland(islands, a);
+            int32_t root_b = EcsContactSolver_findIsland(islands, b);
+            islands[root_a < root_b ? root_b : root_a] = root_a < root_b ? root_a : root_b;
+        } else if (dynamic_a && EcsContactSolver_isMoving(bodies, b)) {
+            // Pushed by a kinematic body, the island is not at rest
+            bodies->sleep_times[a] = 0;
+        } else if (dynamic_b && EcsContactSolver_isMoving(bodies, a)) {
+            bodies->sleep_times[b] = 0;
+        }
+    }
+
+    for (int32_t i = 0; i < bodies->count; i++) {
+        island_times[i] = INFINITY;
+    }
+    for (int32_t i = 0; i < bodies->count; i++) {
+        if (bodies->sleeping[i] || bodies->masses[i].inverse_mass == 0) {
+            continue;
+        }
+        int32_t root = EcsContactSolver_findIsland(islands, i);
+        if (bodies->sleep_times[i] < island_times[root]) {
+            island_times[root] = bodies->sleep_times[i];
+        }
+    }
+
+    // Roots first so every island ring starts from its root
+    for (int32_t i = 0; i < bodies->count; i++) {
+        if (islands[i] == i && island_times[i] >= settings->sleep_time && island_times[i] != INFINITY) {
+            solver->sleep_links[i] = i;
+        }
+    }
+    for (int32_t i = 0; i < bodies->count; i++) {
+        if (bodies->sleeping[i] || bodies->masses[i].inverse_mass == 0) {
+            continue;
+        }
+        int32_t root = EcsContactSolver_findIsland(islands, i);
+        if (island_times[root] < settings->sleep_time) {
+            continue;
+        }
+        if (root != i) {
+            solver->sleep_links[i] = solver->sleep_links[root];
+            solver->sleep_links[root] = i;
+        }
+        bodies->sleeping[i] = true;
+        bodies->velocities[i].linear[0] = 0;
+        bodies->velocities[i].linear[1] = 0;
+        bodies->velocities[i].angular = 0;
+    }
+}
+
+/* True for an awake body that can push others */
+static int8_t EcsContactSolver_isMoving(EcsSolverBodies *bodies, int32_t body)
+{
+    if (bodies->sleeping[body]) {
+        return false;
+    }
+    EcsVelocity2D *velocity = &bodies->velocities[body];
+    return bodies->masses[body].inverse_mass > 0 ||
+        velocity->linear[0] != 0 || velocity->linear[1] != 0 || velocity->angular != 0;
+}
+
+/* Root of the island of body, halving the path on the way */
+static int32_t EcsContactSolver_findIsland(int32_t *islands, int32_t body)
+{
+    while (islands[body] != body) {
+        islands[body] = islands[islands[body]];
+        body = islands[body];
+    }
+    return body;
+}
+
+/* Rebuilds the impulse table from the contacts of this step, reserve sized
+ * the spare table for every contact */
+static void EcsContactSolver_storeImpulses(EcsContactSolver *solver)
+{
+    int32_t size = solver->spare_size;
+    EcsSolverCacheEntry *table = solver->spare;
+    for (int32_t i = 0; i < size; i++) {
+        table[i].a = -1;
+    }
+    for (int32_t i = 0; i < solver->count; i++) {
+        EcsSolverContact *contact = &solver->contacts[i];
+        EcsSolverCacheEntry *entry = EcsContactSolver_find(table, size, contact->a, contact->b);
+        entry->a = contact->a;
+        entry->b = contact->b;
+        entry->points_count = contact->points_count;
+        for (int32_t j = 0; j < contact->points_count; j++) {
+            entry->ids[j] = contact->points[j].id;
+            entry->normal_impulses[j] = contact->points[j].normal_impulse;
+            entry->tangent_impulses[j] = contact->points[j].tangent_impulse;
+        }
+    }
+    solver->spare = solver->cache;
+    solver->spare_size = solver->cache_size;
+    solver->cache = table;
+    solver->cache_size = size;
+}
+
+static void EcsContactSolver_integrate(EcsSolverBodies *bodies, EcsVelocity2D *velocities, float dt)
+{
+    int8_t sleeps = bodies->sleeping != NULL && bodies->sleep_times != NULL;
+    for (int32_t i = 0; i < bodies->count; i++) {
+        if (sleeps && bodies->sleeping[i]) {
+            continue;
+        }
+        EcsVelocity2D *velocity = &velocities[i];
+        bodies->positions[i][0] += velocity->linear[0] * dt;
+        bodies->positions[i][1] += velocity->linear[1] * dt;
+        if (bodies->rotations == NULL || velocity->angular == 0) {
+            continue;
+        }
+        EcsRotation *rotation = &bodies->rotations[i];
+        float angle = velocity->angular * dt;
+        float c = cosf(angle);
+        float s = sinf(angle);
+        float rc = rotation->c * c - rotation->s * s;
+        float rs = rotation->s * c + rotation->c * s;
+        // Renormalize so the rounding does not accumulate into a scale
+        float length = sqrtf(rc * rc + rs * rs);
+        rotation->c = rc / length;
+        rotation->s = rs / length;
+    }
+}
+
+static void EcsContactSolver_applyImpulse(
+    EcsVelocity2D *velocity_a, float inverse_mass_a, float inverse_inertia_a, EcsVector2D *anchor_a,
+    EcsVelocity2D *velocity_b, float inverse_mass_b, float inverse_inertia_b, EcsVector2D *anchor_b,
+    float x, float y)
+{
+    velocity_a->linear[0] -= inverse_mass_a * x;
+    velocity_a->linear[1] -= inverse_mass_a * y;
+    velocity_a->angular -= inverse_inertia_a * CROSS(VECTOR_X(anchor_a), VECTOR_Y(anchor_a), x, y);
+    velocity_b->linear[0] += inverse_mass_b * x;
+    velocity_b->linear[1] += inverse_mass_b * y;
+    velocity_b->angular += inverse_inertia_b * CROSS(VECTOR_X(anchor_b), VECTOR_Y(anchor_b), x, y);
+}
+
+/* Velocity of the anchor of b relative to the anchor of a */
+static void EcsContactSolver_getRelativeVelocity(
+    EcsVelocity2D *velocity_a, EcsVector2D *anchor_a,
+    EcsVelocity2D *velocity_b, EcsVector2D *anchor_b,
+    EcsVector2D *out)
+{
+    VECTOR_X(out) = velocity_b->linear[0] - velocity_b->angular * VECTOR_Y(anchor_b)
+                  - velocity_a->linear[0] + velocity_a->angular * VECTOR_Y(anchor_a);
+    VECTOR_Y(out) = velocity_b->linear[1] + velocity_b->angular * VECTOR_X(anchor_b)
+                  - velocity_a->linear[1] - velocity_a->angular * VECTOR_X(anchor_a);
+}
+
+/* Returns the slot of the pair, or the empty slot where it should go */
+static EcsSolverCacheEntry* EcsContactSolver_find(EcsSolverCacheEntry *table, int32_t size, int32_t a, int32_t b)
+{
+    uint32_t mask = (uint32_t)size - 1;
+    uint32_t slot = ((uint32_t)a * 2654435761u ^ (uint32_t)b * 2246822519u) & mask;
+    for (;;) {
+        EcsSolverCacheEntry *entry = &table[slot];
+        if (entry->a == -1 || (entry->a == a && entry->b == b)) {
+            return entry;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static int8_t EcsContactSolver_reserve(EcsContactSolver *solver, int32_t contact_count, int32_t body_count)
+{
+    if (contact_count > solver->capacity) {
+        int32_t capacity = solver->capacity ? solver->capacity : 64;
+        while (capacity < contact_count) {
+            capacity *= 2;
+        }
+        EcsSolverContact *contacts = realloc(solver->contacts, capacity * sizeof(EcsSolverContact));
+        if (contacts == NULL) {
+            return false;
+        }
+        solver->contacts = contacts;
+        solver->capacity = capacity;
+    }
+    // The impulse table is kept at most half full, allocated before the
+    // bodies move so a step never fails halfway
+    int32_t table_size = 16;
+    while (table_size < contact_count * 2) {
+        table_size *= 2;
+    }
+    if (table_size > solver->spare_size) {
+        EcsSolverCacheEntry *spare = realloc(solver->spare, table_size * sizeof(EcsSolverCacheEntry));
+        if (spare == NULL) {
+            return false;
+        }
+        solver->spare = spare;
+        solver->spare_size = table_size;
+    }
+    if (body_count > solver->body_capacity) {
+        int32_t capacity = solver->body_capacity ? solver->body_capacity : 64;
+        while (capacity < body_count) {
+            capacity *= 2;
+        }
+        EcsVelocity2D *velocities = realloc(solver->split_velocities, capacity * sizeof(EcsVelocity2D));
+        if (velocities == NULL) {
+            return false;
+        }
+        solver->split_velocities = velocities;
+        int32_t *islands = realloc(solver->islands, capacity * sizeof(int32_t));
+        if (islands == NULL) {
+            return false;
+        }
+        solver->islands = islands;
+        float *island_times = realloc(solver->island_times, capacity * sizeof(float));
+        if (island_times == NULL) {
+            return false;
+        }
+        solver->island_times = island_times;
+        int32_t *links = realloc(solver->sleep_links, capacity * sizeof(int32_t));
+        if (links == NULL) {
+            return false;
+        }
+        for (int32_t i = solver->body_capacity; i < capacity; i++) {
+            links[i] = -1;
+        }
+        solver->sleep_links = links;
+        solver->body_capacity = capacity;
+    }
+    return true;
+}
@@ -0,0 +1,292 @@
+#include "include/physics_spatial_hash.h"
+#include "private.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANGE_MIN_X(range) ((range)[0])
+#define RANGE_MIN_Y(range) ((range)[1])
+#define RANGE_MAX_X(range) ((range)[2])
+#define RANGE_MAX_Y(range) ((range)[3])
+#define RANGE_IS_EMPTY(range) ((range)[2] < (range)[0])
+
+// Colliders covering more cells than this skip the grid
+#define LARGE_CELLS 1024
+// Cell coordinates are clamped to this, which keeps them and their spans
+// inside int32_t
+#define CELL_LIMIT 1073741824.0f
+
+static int8_t EcsSpatialHash_reserve(EcsSpatialHash *hash, int32_t count);
+static int8_t EcsSpatialHash_reserveEntries(EcsSpatialHash *hash, int32_t entries);
+static EcsSpatialHashCell* EcsSpatialHash_getCell(EcsSpatialHash *hash, int32_t x, int32_t y);
+static float EcsSpatialHash_getCoordinate(float value, float inv_cell_size);
+
+void EcsSpatialHash_init(EcsSpatialHash *hash, float cell_size)
+{
+    memset(hash, 0, sizeof(EcsSpatialHash));
+    hash->cell_size = cell_size;
+}
+
+void EcsSpatialHash_deinit(EcsSpatialHash *hash)
+{
+    free(hash->aabbs);
+    free(hash->ranges);
+    free(hash->large);
+    free(hash->table);
+    free(hash->used);
+    free(hash->entries);
+    EcsSpatialHash_init(hash, hash->cell_size);
+}
+
+void EcsSpatialHash_setCellSize(EcsSpatialHash *hash, float cell_size)
+{
+    if (hash == NULL || cell_size <= 0) {
+        return;
+    }
+    hash->cell_size = cell_size;
+}
+
+int8_t EcsSpatialHash_update(EcsSpatialHash *hash, EcsColliderData **colliders, int32_t count)
+{
+    if (hash == NULL || hash->cell_size <= 0 || (colliders == NULL && count > 0)) {
+        return false;
+    }
+    if (!EcsSpatialHash_reserve(hash, count)) {
+        return false;
+    }
+
+    STATS_BEGIN(timer);
+    float inv_cell_size = 1.0f / hash->cell_size;
+    int64_t entry_count = 0;
+    hash->large_count = 0;
+    for (int32_t i = 0; i < count; i++) {
+        EcsAABB *aabb = &hash->aabbs[i];
+        int32_t *range = hash->ranges[i];
+        RANGE_MIN_X(range) = RANGE_MIN_Y(range) = 0;
+        RANGE_MAX_X(range) = RANGE_MAX_Y(range) = -1;
+        if (!EcsColliderData_getAABB(colliders[i], aabb)) {
+            continue;
+        }
+        float min_x = EcsSpatialHash_getCoordinate(AABB_MIN_X(aabb), inv_cell_size);
+        float min_y = EcsSpatialHash_getCoordinate(AABB_MIN_Y(aabb), inv_cell_size);
+        float max_x = EcsSpatialHash_getCoordinate(AABB_MAX_X(aabb), inv_cell_size);
+        float max_y = EcsSpatialHash_getCoordinate(AABB_MAX_Y(aabb), inv_cell_size);
+        int64_t cells = (int64_t)(max_x - min_x + 1) * (int64_t)(max_y - min_y + 1);
+        if (cells > LARGE_CELLS) {
+            hash->large[hash->large_count++] = i;
+            continue;
+        }
+        RANGE_MIN_X(range) = (int32_t)min_x;
+        RANGE_MIN_Y(range) = (int32_t)min_y;
+        RANGE_MAX_X(range) = (int32_t)max_x;
+        RANGE_MAX_Y(range) = (int32_t)max_y;
+        entry_count += cells;
+    }
+    // The table takes twice as many slots as entries
+    if (entry_count > INT32_MAX / 4 || !EcsSpatialHash_reserveEntries(hash, (int32_t)entry_count)) {
+        STATS_END(EcsStatsStageBroadphase, timer);
+        return false;
+    }
+
+    // A new stamp empties the table without clearing it
+    hash->stamp++;
+    if (hash->stamp == 0) {
+        memset(hash->table, 0, hash->table_size * sizeof(EcsSpatialHashCell));
+        hash->stamp = 1;
+    }
+    hash->used_count = 0;
+    hash->count = count;
+
+    // Count colliders per cell
+    for (int32_t i = 0; i < count; i++) {
+        int32_t *range = hash->ranges[i];
+        for (int32_t y = RANGE_MIN_Y(range); y <= RANGE_MAX_Y(range); y++) {
+            for (int32_t x = RANGE_MIN_X(range); x <= RANGE_MAX_X(range); x++) {
+                EcsSpatialHash_getCell(hash, x, y)->count++;
+            }
+        }
+    }
+
+    // Assign every cell its slice of the entry buffer
+    int32_t start = 0;
+    for (int32_t i = 0; i < hash->used_count; i++) {
+        EcsSpatialHashCell *cell = &hash->table[hash->used[i]];
+        cell->start = start;
+        start += cell->count;
+        cell->count = 0;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        int32_t *range = hash->ranges[i];
+        for (int32_t y = RANGE_MIN_Y(range); y <= RANGE_MAX_Y(range); y++) {
+            for (int32_t x = RANGE_MIN_X(range); x <= RANGE_MAX_X(range); x++) {
+                EcsSpatialHashCell *cell = EcsSpatialHash_getCell(hash, x, y);
+                hash->entries[cell->start + cell->count++] = i;
+            }
+        }
+    }
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return true;
+}
+
+int32_t EcsSpatialHash_getPairs(EcsSpatialHash *hash, EcsColliderPair *pairs_out, int32_t max_pairs)
+{
+    if (hash == NULL) {
+        return 0;
+    }
+    int32_t found = 0;
+    STATS_BEGIN(timer);
+    for (int32_t c = 0; c < hash->used_count; c++) {
+        EcsSpatialHashCell *cell = &hash->table[hash->used[c]];
+        int32_t *entries = &hash->entries[cell->start];
+        for (int32_t i = 0; i < cell->count; i++) {
+            int32_t a = entries[i];
+            int32_t *range_a = hash->ranges[a];
+            for (int32_t j = i + 1; j < cell->count; j++) {
+                int32_t b = entries[j];
+                int32_t *range_b = hash->ranges[b];
+                // Only the first cell both colliders share reports the pair
+                int32_t x = RANGE_MIN_X(range_a) > RANGE_MIN_X(range_b) ? RANGE_MIN_X(range_a) : RANGE_MIN_X(range_b);
+                int32_t y = RANGE_MIN_Y(range_a) > RANGE_MIN_Y(range_b) ? RANGE_MIN_Y(range_a) : RANGE_MIN_Y(range_b);
+                if (x != cell->x || y != cell->y) {
+                    continue;
+                }
+                if (!EcsAABBTest(&hash->aabbs[a], &hash->aabbs[b])) {
+                    continue;
+                }
+                if (found < max_pairs) {
+                    pairs_out[found].a = a < b ? a : b;
+                    pairs_out[found].b = a < b ? b : a;
+                }
+                found++;
+            }
+        }
+    }
+
+    // Large colliders against everything else, including each other once
+    for (int32_t l = 0; l < hash->large_count; l++) {
+        int32_t a = hash->large[l];
+        for (int32_t b = 0; b < hash->count; b++) {
+            if (RANGE_IS_EMPTY(hash->ranges[b]) || !EcsAABBTest(&hash->aabbs[a], &hash->aabbs[b])) {
+                continue;
+            }
+            if (found < max_pairs) {
+                pairs_out[found].a = a < b ? a : b;
+                pairs_out[found].b = a < b ? b : a;
+            }
+            found++;
+        }
+        for (int32_t k = l + 1; k < hash->large_count; k++) {
+            int32_t b = hash->large[k];
+            if (!EcsAABBTest(&hash->aabbs[a], &hash->aabbs[b])) {
+                continue;
+            }
+            if (found < max_pairs) {
+                pairs_out[found].a = a < b ? a : b;
+                pairs_out[found].b = a < b ? b : a;
+            }
+            found++;
+        }
+    }
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return found;
+}
+
+static int8_t EcsSpatialHash_reserve(EcsSpatialHash *hash, int32_t count)
+{
+    if (count <= hash->capacity) {
+        return true;
+    }
+    int32_t capacity = hash->capacity ? hash->capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    EcsAABB *aabbs = realloc(hash->aabbs, capacity * sizeof(EcsAABB));
+    if (aabbs == NULL) {
+        return false;
+    }
+    hash->aabbs = aabbs;
+    int32_t (*ranges)[4] = realloc(hash->ranges, capacity * sizeof(*ranges));
+    if (ranges == NULL) {
+        return false;
+    }
+    hash->ranges = ranges;
+    int32_t *large = realloc(hash->large, capacity * sizeof(int32_t));
+    if (large == NULL) {
+        return false;
+    }
+    hash->large = large;
+    hash->capacity = capacity;
+    return true;
+}
+
+static int8_t EcsSpatialHash_reserveEntries(EcsSpatialHash *hash, int32_t entries)
+{
+    if (entries > hash->entry_capacity) {
+        int32_t capacity = hash->entry_capacity ? hash->entry_capacity : 64;
+        while (capacity < entries) {
+            capacity *= 2;
+        }
+        int32_t *data = realloc(hash->entries, capacity * sizeof(int32_t));
+        if (data == NULL) {
+            return false;
+        }
+        hash->entries = data;
+        int32_t *used = realloc(hash->used, capacity * sizeof(int32_t));
+        if (used == NULL) {
+            return false;
+        }
+        hash->used = used;
+        hash->entry_capacity = capacity;
+    }
+
+    // Keep the load factor of the table at or below 1/2
+    if (entries * 2 > hash->table_size) {
+        int32_t size = hash->table_size ? hash->table_size : 128;
+        while (size < entries * 2) {
+            size *= 2;
+        }
+        EcsSpatialHashCell *table = realloc(hash->table, size * sizeof(EcsSpatialHashCell));
+        if (table == NULL) {
+            return false;
+        }
+        memset(table, 0, size * sizeof(EcsSpatialHashCell));
+        hash->table = table;
+        hash->table_size = size;
+        hash->stamp = 0;
+    }
+    return true;
+}
+
+/* Finds the slot of cell (x, y), claiming an empty one if it is not in use */
+static EcsSpatialHashCell* EcsSpatialHash_getCell(EcsSpatialHash *hash, int32_t x, int32_t y)
+{
+    uint32_t mask = (uint32_t)hash->table_size - 1;
+    uint32_t slot = (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & mask;
+    for (;;) {
+        EcsSpatialHashCell *cell = &hash->table[slot];
+        if (cell->stamp != hash->stamp) {
+            cell->stamp = hash->stamp;
+            cell->x = x;
+            cell->y = y;
+            cell->count = 0;
+            hash->used[hash->used_count++] = slot;
+            return cell;
+        }
+        if (cell->x == x && cell->y == y) {
+            return cell;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/* Cell coordinate of value, clamped so the cast to int32_t is defined */
+static float EcsSpatialHash_getCoordinate(float value, float inv_cell_size)
+{
+    float cell = floorf(value * inv_cell_size);
+    // NaN fails both tests and ends on the upper limit
+    if (cell > -CELL_LIMIT && cell < CELL_LIMIT) {
+        return cell;
+    }
+    return cell <= -CELL_LIMIT ? -CELL_LIMIT : CELL_LIMIT;
+}
@@ -0,0 +1,125 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef ECS_PHYSICS_STATS
+
+#include <pthread.h>
+
+// Threads are given a free slot and release it when they exit. Past that,
+// threads share the last slot and add to it atomically
+#define STATS_SLOTS 64
+#define STATS_COUNTERS (sizeof(EcsPhysicsStats) / sizeof(uint64_t))
+
+// A cache line of its own for every slot, so threads never write to the
+// lines of others
+typedef struct StatsSlot {
+    EcsPhysicsStats stats;
+    int32_t used;
+    uint8_t padding[64 - (sizeof(EcsPhysicsStats) + sizeof(int32_t)) % 64];
+} StatsSlot_t;
+
+static void EcsPhysicsStats_createKey(void);
+static void EcsPhysicsStats_releaseSlot(void *slot);
+
+static StatsSlot_t slots[STATS_SLOTS] __attribute__((aligned(64)));
+// Slots below slot_count have been used, their counts are kept on release
+static int32_t slot_count = 0;
+static pthread_key_t slot_key;
+static pthread_once_t slot_once = PTHREAD_ONCE_INIT;
+
+__thread EcsPhysicsStats *EcsPhysicsStats_slot = NULL;
+__thread int8_t EcsPhysicsStats_shared = false;
+
+EcsPhysicsStats* EcsPhysicsStats_getSlot(void)
+{
+    pthread_once(&slot_once, EcsPhysicsStats_createKey);
+    int32_t index = 0;
+    for (; index < STATS_SLOTS - 1; index++) {
+        int32_t expected = 0;
+        if (__atomic_compare_exchange_n(&slots[index].used, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            pthread_setspecific(slot_key, &slots[index]);
+            break;
+        }
+    }
+    EcsPhysicsStats_shared = index == STATS_SLOTS - 1;
+    int32_t count = __atomic_load_n(&slot_count, __ATOMIC_RELAXED);
+    while (count <= index &&
+        !__atomic_compare_exchange_n(&slot_count, &count, index + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    EcsPhysicsStats_slot = &slots[index].stats;
+    return EcsPhysicsStats_slot;
+}
+
+static void EcsPhysicsStats_createKey(void)
+{
+    pthread_key_create(&slot_key, EcsPhysicsStats_releaseSlot);
+}
+
+/* Runs when the owner thread exits, the next thread keeps adding to it */
+static void EcsPhysicsStats_releaseSlot(void *slot)
+{
+    __atomic_store_n(&((StatsSlot_t*)slot)->used, 0, __ATOMIC_RELEASE);
+}
+
+uint64_t EcsPhysicsStats_now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+int8_t EcsPhysicsStats_isEnabled(void)
+{
+    return true;
+}
+
+void EcsPhysicsStats_get(EcsPhysicsStats *stats_out)
+{
+    if (stats_out == NULL) {
+        return;
+    }
+    uint64_t *out = (uint64_t*)stats_out;
+    memset(stats_out, 0, sizeof(EcsPhysicsStats));
+    int32_t count = __atomic_load_n(&slot_count, __ATOMIC_RELAXED);
+    count = count < STATS_SLOTS ? count : STATS_SLOTS;
+    for (int32_t i = 0; i < count; i++) {
+        uint64_t *counters = (uint64_t*)&slots[i].stats;
+        for (size_t c = 0; c < STATS_COUNTERS; c++) {
+            out[c] += __atomic_load_n(&counters[c], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void EcsPhysicsStats_reset(void)
+{
+    int32_t count = __atomic_load_n(&slot_count, __ATOMIC_RELAXED);
+    count = count < STATS_SLOTS ? count : STATS_SLOTS;
+    for (int32_t i = 0; i < count; i++) {
+        uint64_t *counters = (uint64_t*)&slots[i].stats;
+        for (size_t c = 0; c < STATS_COUNTERS; c++) {
+            __atomic_store_n(&counters[c], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+#else
+
+int8_t EcsPhysicsStats_isEnabled(void)
+{
+    return false;
+}
+
+void EcsPhysicsStats_get(EcsPhysicsStats *stats_out)
+{
+    if (stats_out != NULL) {
+        memset(stats_out, 0, sizeof(EcsPhysicsStats));
+    }
+}
+
+void EcsPhysicsStats_reset(void)
+{
+}
+
+#endif
@@ -17,25 +17,57 @@ static int8_t EcsColliderData_getPolygonAABB(ColliderData_t *collider, EcsAABB *
     if (iter == NULL || iter >= end) {
         return false;
     }
+    EcsRotation identity = EcsRotation_Identity();
+    EcsRotation *rotation = collider->rotation != NULL ? collider->rotation : &identity;
 
     AABB_MIN_X(aabb_out) = FLT_MAX;
     AABB_MIN_Y(aabb_out) = FLT_MAX;
-    AABB_MAX_X(aabb_out) = FLT_MIN;
-    AABB_MAX_Y(aabb_out) = FLT_MIN;
+    AABB_MAX_X(aabb_out) = -FLT_MAX;
+    AABB_MAX_Y(aabb_out) = -FLT_MAX;
     for (; iter < end; iter++) {
-        if (AABB_MIN_X(aabb_out) > VECTOR_X(iter)) {
-            AABB_MIN_X(aabb_out) = VECTOR_X(iter);
+        EcsVector2D point;
+        EcsRotation_rotate(rotation, iter, &point);
+        if (AABB_MIN_X(aabb_out) > VECTOR_X(&point)) {
+            AABB_MIN_X(aabb_out) = VECTOR_X(&point);
         }
-        if (AABB_MIN_Y(aabb_out) > VECTOR_Y(iter)) {
-            AABB_MIN_Y(aabb_out) = VECTOR_Y(iter);
+        if (AABB_MIN_Y(aabb_out) > VECTOR_Y(&point)) {
+            AABB_MIN_Y(aabb_out) = VECTOR_Y(&point);
         }
-        if (AABB_MAX_X(aabb_out) < VECTOR_X(iter)) {
-            AABB_MAX_X(aabb_out) = VECTOR_X(iter);
+        if (AABB_MAX_X(aabb_out) < VECTOR_X(&point)) {
+            AABB_MAX_X(aabb_out) = VECTOR_X(&point);
         }
-        if (AABB_MAX_Y(aabb_out) < VECTOR_Y(iter)) {
-            AABB_MAX_Y(aabb_out) = VECTOR_Y(iter);
+        if (AABB_MAX_Y(aabb_out) < VECTOR_Y(&point)) {
+            AABB_MAX_Y(aabb_out) = VECTOR_Y(&point);
         }
     }
+    AABB_MIN_X(aabb_out) += VECTOR_X(collider->position);
+    AABB_MIN_Y(aabb_out) += VECTOR_Y(collider->position);
+    AABB_MAX_X(aabb_out) += VECTOR_X(collider->position);
+    AABB_MAX_Y(aabb_out) += VECTOR_Y(collider->position);
+    return true;
+}
+
+static int8_t EcsColliderData_getCapsuleAABB(ColliderData_t *collider, EcsAABB *aabb_out) {
+    EcsRotation identity = EcsRotation_Identity();
+    EcsRotation *rotation = collider->rotation != NULL ? collider->rotation : &identity;
+    float radius = collider->capsule->radius;
+    EcsVector2D p1;
+    EcsVector2D p2;
+    EcsRotation_rotate(rotation, &collider->capsule->point1, &p1);
+    EcsRotation_rotate(rotation, &collider->capsule->point2, &p2);
+    AABB_MIN_X(aabb_out) = VECTOR_X(collider->position) + fminf(VECTOR_X(&p1), VECTOR_X(&p2)) - radius;
+    AABB_MIN_Y(aabb_out) = VECTOR_Y(collider->position) + fminf(VECTOR_Y(&p1), VECTOR_Y(&p2)) - radius;
+    AABB_MAX_X(aabb_out) = VECTOR_X(collider->position) + fmaxf(VECTOR_X(&p1), VECTOR_X(&p2)) + radius;
+    AABB_MAX_Y(aabb_out) = VECTOR_Y(collider->position) + fmaxf(VECTOR_Y(&p1), VECTOR_Y(&p2)) + radius;
+    return true;
+}
+
+static int8_t EcsColliderData_getBoxAABB(ColliderData_t *collider, EcsAABB *aabb_out) {
+    EcsVector2D *half_extents = &collider->box->half_extents;
+    AABB_MIN_X(aabb_out) = VECTOR_X(collider->position) - VECTOR_X(half_extents);
+    AABB_MIN_Y(aabb_out) = VECTOR_Y(collider->position) - VECTOR_Y(half_extents);
+    AABB_MAX_X(aabb_out) = VECTOR_X(collider->position) + VECTOR_X(half_extents);
+    AABB_MAX_Y(aabb_out) = VECTOR_Y(collider->position) + VECTOR_Y(half_extents);
     return true;
 }
 
@@ -45,14 +77,40 @@ int8_t EcsColliderData_getAABB(EcsColliderData *collider, EcsAABB *aabb_out)
         return false;
     }
     int8_t type = GET_COLLIDER_TYPE(collider);
+    STATS_ADD(aabbs, 1);
     if (type == CIRCLE) {
         return EcsColliderData_getCircleAABB(COLLIDER_DATA(collider), aabb_out);
     } else if (type == POLYGON) {
         return EcsColliderData_getPolygonAABB(COLLIDER_DATA(collider), aabb_out);
+    } else if (type == CAPSULE) {
+        return EcsColliderData_getCapsuleAABB(COLLIDER_DATA(collider), aabb_out);
+    } else if (type == BOX) {
+        return EcsColliderData_getBoxAABB(COLLIDER_DATA(collider), aabb_out);
     }
     return false;
 }
 
+int8_t EcsColliderData_getSweptAABB(EcsColliderData *collider, EcsSweep *sweep, EcsAABB *aabb_out)
+{
+    if (sweep == NULL || !EcsColliderData_getAABB(collider, aabb_out)) {
+        return false;
+    }
+    EcsAABB_sweep(aabb_out, GET_POSITION(collider), sweep);
+    return true;
+}
+
+void EcsAABB_sweep(EcsAABB *aabb, EcsVector2D *position, EcsSweep *sweep)
+{
+    float start_x = VECTOR_X(&sweep->start) - VECTOR_X(position);
+    float start_y = VECTOR_Y(&sweep->start) - VECTOR_Y(position);
+    float end_x = VECTOR_X(&sweep->end) - VECTOR_X(position);
+    float end_y = VECTOR_Y(&sweep->end) - VECTOR_Y(position);
+    AABB_MIN_X(aabb) += start_x < end_x ? start_x : end_x;
+    AABB_MIN_Y(aabb) += start_y < end_y ? start_y : end_y;
+    AABB_MAX_X(aabb) += start_x > end_x ? start_x : end_x;
+    AABB_MAX_Y(aabb) += start_y > end_y ? start_y : end_y;
+}
+
 int8_t EcsAABBTest(EcsAABB *a, EcsAABB *b) {
     if (a == NULL || b == NULL) {
         return false;
@@ -63,6 +121,43 @@ int8_t EcsAABBTest(EcsAABB *a, EcsAABB *b) {
              (AABB_MAX_Y(b) < AABB_MIN_Y(a)));
 }
 
+int8_t EcsAABBRaycast(EcsAABB *aabb, EcsRay *ray, float *fraction_out) {
+    if (aabb == NULL || ray == NULL) {
+        return false;
+    }
+    float lower = 0;
+    float upper = ray->max_fraction;
+    for (int32_t axis = 0; axis < 2; axis++) {
+        float origin = ray->origin[axis];
+        float translation = ray->translation[axis];
+        float min = (*aabb)[axis];
+        float max = (*aabb)[axis + 2];
+        if (translation == 0) {
+            if (origin < min || origin > max) {
+                return false;
+            }
+            continue;
+        }
+        float inverse = 1.0f / translation;
+        float t1 = (min - origin) * inverse;
+        float t2 = (max - origin) * inverse;
+        if (t1 > t2) {
+            float tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+        lower = t1 > lower ? t1 : lower;
+        upper = t2 < upper ? t2 : upper;
+        if (lower > upper) {
+            return false;
+        }
+    }
+    if (fraction_out != NULL) {
+        *fraction_out = lower;
+    }
+    return true;
+}
+
 float EcsVector2D_get_angle(EcsVector2D *vector) {
     if (vector == NULL) {
         return INFINITY;
@@ -198,4 +293,76 @@ int8_t EcsMatrix3x3_transform(EcsMatrix3x3 *matrix, EcsVector2D *src, EcsVector2
                              MATRIX_GET(matrix, 1, 2);
     }
     return true;
-}
\ No newline at end of file
+}
+
+void EcsRotation_set(EcsRotation *rotation, float rad)
+{
+    rotation->c = cosf(rad);
+    rotation->s = sinf(rad);
+}
+
+int8_t EcsRotation_rotate(EcsRotation *rotation, EcsVector2D *vector, EcsVector2D *vector_out)
+{
+    if (rotation == NULL || vector == NULL || vector_out == NULL) {
+        return false;
+    }
+    float x = VECTOR_X(vector);
+    float y = VECTOR_Y(vector);
+    VECTOR_X(vector_out) = rotation->c * x - rotation->s * y;
+    VECTOR_Y(vector_out) = rotation->s * x + rotation->c * y;
+    return true;
+}
+
+int8_t EcsRotation_invRotate(EcsRotation *rotation, EcsVector2D *vector, EcsVector2D *vector_out)
+{
+    if (rotation == NULL || vector == NULL || vector_out == NULL) {
+        return false;
+    }
+    float x = VECTOR_X(vector);
+    float y = VECTOR_Y(vector);
+    VECTOR_X(vector_out) = rotation->c * x + rotation->s * y;
+    VECTOR_Y(vector_out) = -rotation->s * x + rotation->c * y;
+    return true;
+}
+
+int8_t EcsTransform_apply(EcsTransform *transform, EcsVector2D *src, EcsVector2D *dest, size_t size)
+{
+    if (transform == NULL || src == NULL || dest == NULL) {
+        return false;
+    }
+    float c = transform->rotation.c;
+    float s = transform->rotation.s;
+    float tx = VECTOR_X(&transform->position);
+    float ty = VECTOR_Y(&transform->position);
+    for (size_t i = 0; i < size; i++) {
+        float x = VECTOR_X(&src[i]);
+        float y = VECTOR_Y(&src[i]);
+        VECTOR_X(&dest[i]) = c * x - s * y + tx;
+        VECTOR_Y(&dest[i]) = s * x + c * y + ty;
+    }
+    return true;
+}
+
+int8_t EcsTransform_invApply(EcsTransform *transform, EcsVector2D *point, EcsVector2D *point_out)
+{
+    if (transform == NULL || point == NULL || point_out == NULL) {
+        return false;
+    }
+    EcsVector2D delta;
+    EcsVector2D_sub(point, &transform->position, &delta);
+    return EcsRotation_invRotate(&transform->rotation, &delta, point_out);
+}
+
+int8_t EcsTransform_relative(EcsTransform *a, EcsTransform *b, EcsTransform *out)
+{
+    if (a == NULL || b == NULL || out == NULL) {
+        return false;
+    }
+    // out.rotation = a.rotation^T * b.rotation
+    float c = a->rotation.c * b->rotation.c + a->rotation.s * b->rotation.s;
+    float s = a->rotation.c * b->rotation.s - a->rotation.s * b->rotation.c;
+    EcsTransform_invApply(a, &b->position, &out->position);
+    out->rotation.c = c;
+    out->rotation.s = s;
+    return true;
+}
@@ -0,0 +1,143 @@
+#include "include/physics_2d.h"
+#include "private.h"
+#include <stdlib.h>
+#include <string.h>
+
+static EcsVertexCacheEntry* EcsVertexCache_find(EcsVertexCache *cache, EcsPolygonCollider *polygon, EcsPoint *position);
+static int8_t EcsVertexCache_grow(EcsVertexCache *cache);
+
+void EcsVertexCache_init(EcsVertexCache *cache)
+{
+    cache->entries = NULL;
+    cache->size = 0;
+    cache->count = 0;
+    cache->stamp = 1;
+}
+
+void EcsVertexCache_deinit(EcsVertexCache *cache)
+{
+    for (int32_t i = 0; i < cache->size; i++) {
+        free(cache->entries[i].vertices);
+        free(cache->entries[i].soa);
+    }
+    free(cache->entries);
+    EcsVertexCache_init(cache);
+}
+
+void EcsVertexCache_begin(EcsVertexCache *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    cache->count = 0;
+    cache->stamp++;
+    if (cache->stamp == 0) {
+        for (int32_t i = 0; i < cache->size; i++) {
+            cache->entries[i].stamp = 0;
+        }
+        cache->stamp = 1;
+    }
+}
+
+EcsPoint* EcsVertexCache_get(EcsVertexCache *cache, EcsColliderData *collider)
+{
+    if (cache == NULL || collider == NULL || GET_POSITION(collider) == NULL || GET_POLYGON(collider) == NULL) {
+        return NULL;
+    }
+    EcsVertexCacheEntry *entry = EcsVertexCache_getEntry(cache, COLLIDER_DATA(collider));
+    return entry != NULL ? entry->vertices : NULL;
+}
+
+EcsVertexCacheEntry* EcsVertexCache_getEntry(EcsVertexCache *cache, ColliderData_t *collider)
+{
+    EcsPolygonCollider *polygon = collider->polygon;
+    EcsTransform transform;
+    EcsPhysis2d_getTransform(collider, &transform);
+
+    // Only inserts grow the table, lookups of warm entries never write to it
+    EcsVertexCacheEntry *entry = cache->size ? EcsVertexCache_find(cache, polygon, collider->position) : NULL;
+    if ((entry == NULL || entry->stamp != cache->stamp) && (cache->count + 1) * 2 > cache->size) {
+        if (!EcsVertexCache_grow(cache)) {
+            return NULL;
+        }
+        entry = EcsVertexCache_find(cache, polygon, collider->position);
+    }
+    if (entry->stamp == cache->stamp) {
+        if (VECTOR_X(&entry->transform.position) == VECTOR_X(&transform.position) &&
+            VECTOR_Y(&entry->transform.position) == VECTOR_Y(&transform.position) &&
+            entry->transform.rotation.c == transform.rotation.c &&
+            entry->transform.rotation.s == transform.rotation.s &&
+            entry->count == polygon->points_count) {
+            return entry;
+        }
+    } else {
+        entry->stamp = cache->stamp;
+        entry->polygon = polygon;
+        entry->position = collider->position;
+        cache->count++;
+    }
+
+    int32_t size = polygon->points_count;
+    if (size > entry->capacity) {
+        entry->count = -1;
+        EcsPoint *vertices = realloc(entry->vertices, size * sizeof(EcsPoint));
+        if (vertices == NULL) {
+            return NULL;
+        }
+        entry->vertices = vertices;
+        float *soa = realloc(entry->soa, size * 2 * sizeof(float));
+        if (soa == NULL) {
+            return NULL;
+        }
+        entry->soa = soa;
+        entry->capacity = size;
+    }
+    EcsTransform_apply(&transform, polygon->points, entry->vertices, size);
+    for (int32_t i = 0; i < size; i++) {
+        entry->soa[i] = VECTOR_X(&entry->vertices[i]);
+        entry->soa[entry->capacity + i] = VECTOR_Y(&entry->vertices[i]);
+    }
+    entry->transform = transform;
+    entry->count = size;
+    return entry;
+}
+
+/* Returns the slot of the collider, or the free slot where it should go */
+static EcsVertexCacheEntry* EcsVertexCache_find(EcsVertexCache *cache, EcsPolygonCollider *polygon, EcsPoint *position)
+{
+    uint32_t mask = (uint32_t)cache->size - 1;
+    uintptr_t key = ((uintptr_t)polygon >> 4) ^ ((uintptr_t)position >> 4) * 31u;
+    uint32_t slot = (uint32_t)(key * 2654435761u) & mask;
+    for (;;) {
+        EcsVertexCacheEntry *entry = &cache->entries[slot];
+        if (entry->stamp != cache->stamp || (entry->polygon == polygon && entry->position == position)) {
+            return entry;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static int8_t EcsVertexCache_grow(EcsVertexCache *cache)
+{
+    int32_t size = cache->size ? cache->size * 2 : 64;
+    EcsVertexCacheEntry *old = cache->entries;
+    int32_t old_size = cache->size;
+    EcsVertexCacheEntry *entries = calloc(size, sizeof(EcsVertexCacheEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    cache->entries = entries;
+    cache->size = size;
+
+    // Live entries keep their vertex buffers, stale ones are released
+    for (int32_t i = 0; i < old_size; i++) {
+        if (old[i].stamp != cache->stamp) {
+            free(old[i].vertices);
+            free(old[i].soa);
+            continue;
+        }
+        *EcsVertexCache_find(cache, old[i].polygon, old[i].position) = old[i];
+    }
+    free(old);
+    return true;
+}
@@ -0,0 +1,864 @@
+#include "include/physics_world.h"
+#include "private.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDLE_SLOT(handle) ((int32_t)((handle) & 0xFFFFFFFFu))
+#define HANDLE_GENERATION(handle) ((uint32_t)((handle) >> 32))
+#define HANDLE_MAKE(slot, generation) (((EcsColliderHandle)(generation) << 32) | (uint32_t)(slot))
+// Margin of the leaves of the world AABB tree
+#define TREE_MARGIN 0.1f
+
+static int8_t EcsPhysicsWorld_reserve(EcsPhysicsWorld *world, int32_t count);
+static int8_t EcsPhysicsWorld_reserveSlots(EcsPhysicsWorld *world, int32_t count);
+static int8_t EcsPhysicsWorld_reserveVertices(EcsPhysicsWorld *world, int32_t count);
+static int8_t EcsPhysicsWorld_compactVertices(EcsPhysicsWorld *world, int32_t capacity);
+static void EcsPhysicsWorld_rebasePolygons(EcsPhysicsWorld *world);
+static void EcsPhysicsWorld_updateViews(EcsPhysicsWorld *world);
+static void EcsPhysicsWorld_getRotatedAABB(EcsPhysicsWorld *world, int32_t i, EcsAABB *aabb_out);
+static void EcsPhysicsWorld_setSleepingIndex(EcsPhysicsWorld *world, int32_t i, int8_t sleeping);
+static void EcsPhysicsWorld_queueSleeping(EcsPhysicsWorld *world, int32_t i);
+static void EcsPhysicsWorld_setAwake(EcsPhysicsWorld *world, int32_t i, int8_t awake);
+static void EcsPhysicsWorld_updateAwake(EcsPhysicsWorld *world);
+static int32_t EcsPhysicsWorld_query(
+    EcsPhysicsWorld *world,
+    EcsAABB *aabb,
+    EcsColliderData *shape,
+    int32_t *indices_out,
+    int32_t max_indices);
+static int8_t EcsPhysicsWorld_queryCallback(void *ctx, int32_t index);
+static int8_t EcsPhysicsWorld_pairCallback(void *ctx, int32_t index);
+
+/* Region query state, shape is NULL for queries on the AABBs only */
+typedef struct EcsPhysicsWorldQuery {
+    EcsPhysicsWorld *world;
+    EcsAABB *aabb;
+    EcsColliderData *shape;
+    int32_t *indices;
+    int32_t max_indices;
+    int32_t count;
+} EcsPhysicsWorldQuery;
+
+/* Pairs of an awake collider, index, with its neighbours */
+typedef struct EcsPhysicsWorldPairQuery {
+    EcsPhysicsWorld *world;
+    EcsColliderPair *pairs;
+    int32_t max_pairs;
+    int32_t count;
+    int32_t index;
+} EcsPhysicsWorldPairQuery;
+
+void EcsPhysicsWorld_init(EcsPhysicsWorld *world)
+{
+    memset(world, 0, sizeof(EcsPhysicsWorld));
+    world->free_slot = -1;
+    EcsSweepAndPrune_init(&world->broadphase);
+    EcsAABBTree_init(&world->tree, TREE_MARGIN);
+    EcsVertexCache_init(&world->vertex_cache);
+    EcsSatCache_init(&world->sat_cache);
+}
+
+void EcsPhysicsWorld_deinit(EcsPhysicsWorld *world)
+{
+    free(world->positions);
+    free(world->rotations);
+    free(world->sweeps);
+    free(world->fast);
+    free(world->sleeping);
+    free(world->awake);
+    free(world->awake_mask);
+    free(world->awake_ranks);
+    free(world->sleep_changes);
+    free(world->circles);
+    free(world->polygons);
+    free(world->capsules);
+    free(world->boxes);
+    free(world->vertex_offsets);
+    free(world->local_aabbs);
+    free(world->aabbs);
+    free(world->types);
+    free(world->handles);
+    free(world->views);
+    free(world->view_ptrs);
+    free(world->proxies);
+    free(world->vertices);
+    free(world->normals);
+    free(world->supports);
+    free(world->facing);
+    free(world->slots);
+    free(world->generations);
+    EcsSweepAndPrune_deinit(&world->broadphase);
+    EcsAABBTree_deinit(&world->tree);
+    EcsVertexCache_deinit(&world->vertex_cache);
+    EcsSatCache_deinit(&world->sat_cache);
+    if (world->thread_pool.thread_count > 0) {
+        EcsThreadPool_deinit(&world->thread_pool);
+    }
+    EcsPhysicsWorld_init(world);
+}
+
+EcsColliderHandle EcsPhysicsWorld_add(EcsPhysicsWorld *world, EcsColliderData *collider)
+{
+    if (world == NULL || collider == NULL || GET_POSITION(collider) == NULL) {
+        return EcsColliderHandle_Null;
+    }
+    int8_t type = GET_COLLIDER_TYPE(collider);
+    EcsPolygonCollider *polygon = GET_POLYGON(collider);
+    if (type == ERR || (type == POLYGON && (polygon->points == NULL || polygon->points_count <= 0))) {
+        return EcsColliderHandle_Null;
+    }
+    if (!EcsPhysicsWorld_reserve(world, world->count + 1) ||
+        !EcsPhysicsWorld_reserveSlots(world, world->slot_count + 1) ||
+        (type == POLYGON && !EcsPhysicsWorld_reserveVertices(world, polygon->points_count))) {
+        return EcsColliderHandle_Null;
+    }
+
+    int32_t slot = world->free_slot;
+    if (slot != -1) {
+        world->free_slot = world->slots[slot];
+    } else {
+        slot = world->slot_count++;
+        world->generations[slot] = 1;
+    }
+    int32_t i = world->count++;
+    world->slots[slot] = i;
+    world->handles[i] = HANDLE_MAKE(slot, world->generations[slot]);
+    world->types[i] = type;
+    world->fast[i] = false;
+    world->sleeping[i] = false;
+    world->awake_mask[i] = false;
+    world->awake_ranks[i] = -1;
+    EcsPhysicsWorld_queueSleeping(world, i);
+    VECTOR_X(&world->positions[i]) = VECTOR_X(GET_POSITION(collider));
+    VECTOR_Y(&world->positions[i]) = VECTOR_Y(GET_POSITION(collider));
+    if (GET_ROTATION(collider) != NULL) {
+        world->rotations[i] = *GET_ROTATION(collider);
+    } else {
+        world->rotations[i].c = 1;
+        world->rotations[i].s = 0;
+    }
+
+    EcsAABB *local = &world->local_aabbs[i];
+    if (type != POLYGON) {
+        world->circles[i].radius = 0;
+        world->polygons[i].points = NULL;
+        world->polygons[i].points_count = 0;
+        world->polygons[i].normals = NULL;
+        world->polygons[i].supports = NULL;
+        world->polygons[i].facing = NULL;
+        world->polygons[i].shape = EcsPolygonShapeGeneric;
+        world->polygons[i].winding = 1;
+        world->vertex_offsets[i] = 0;
+    }
+    if (type == CIRCLE) {
+        float radius = GET_CIRCLE(collider)->radius;
+        world->circles[i].radius = radius;
+        AABB_MIN_X(local) = -radius;
+        AABB_MIN_Y(local) = -radius;
+        AABB_MAX_X(local) = radius;
+        AABB_MAX_Y(local) = radius;
+    } else if (type == CAPSULE) {
+        EcsCapsuleCollider *capsule = &world->capsules[i];
+        *capsule = *GET_CAPSULE(collider);
+        // Without rotation, rotated capsules get their AABB on update
+        float radius = capsule->radius;
+        EcsPoint *p1 = &capsule->point1;
+        EcsPoint *p2 = &capsule->point2;
+        AABB_MIN_X(local) = (VECTOR_X(p1) < VECTOR_X(p2) ? VECTOR_X(p1) : VECTOR_X(p2)) - radius;
+        AABB_MIN_Y(local) = (VECTOR_Y(p1) < VECTOR_Y(p2) ? VECTOR_Y(p1) : VECTOR_Y(p2)) - radius;
+        AABB_MAX_X(local) = (VECTOR_X(p1) > VECTOR_X(p2) ? VECTOR_X(p1) : VECTOR_X(p2)) + radius;
+        AABB_MAX_Y(local) = (VECTOR_Y(p1) > VECTOR_Y(p2) ? VECTOR_Y(p1) : VECTOR_Y(p2)) + radius;
+    } else if (type == BOX) {
+        world->boxes[i] = *GET_BOX(collider);
+        EcsVector2D *half_extents = &world->boxes[i].half_extents;
+        AABB_MIN_X(local) = -VECTOR_X(half_extents);
+        AABB_MIN_Y(local) = -VECTOR_Y(half_extents);
+        AABB_MAX_X(local) = VECTOR_X(half_extents);
+        AABB_MAX_Y(local) = VECTOR_Y(half_extents);
+    } else {
+        int32_t offset = world->vertex_count;
+        int32_t size = polygon->points_count;
+        EcsPoint *points = &world->vertices[offset];
+        memcpy(points, polygon->points, size * sizeof(EcsPoint));
+        EcsPolygonCollider_computeNormals(points, size, &world->normals[offset]);
+        int8_t supports = size >= EXTREME_THRESHOLD &&
+            EcsPolygonCollider_computeSupports(points, &world->normals[offset], size, &world->supports[offset]);
+        int32_t facing = EcsPolygonCollider_computeFacing(&world->normals[offset], size, &world->facing[offset]);
+        world->vertex_count += size;
+        world->vertex_offsets[i] = offset;
+        world->circles[i].radius = 0;
+        world->polygons[i].points = points;
+        world->polygons[i].points_count = size;
+        world->polygons[i].normals = &world->normals[offset];
+        world->polygons[i].supports = supports ? &world->supports[offset] : NULL;
+        world->polygons[i].facing = facing > 0 ? &world->facing[offset] : NULL;
+        world->polygons[i].shape = EcsPolygonCollider_computeShape(&world->normals[offset], size);
+        world->polygons[i].winding = EcsPolygonCollider_computeWinding(points, size);
+        EcsPolygonCollider_computeBounds(points, size, &world->polygons[i].aabb);
+        memcpy(local, &world->polygons[i].aabb, sizeof(EcsAABB));
+    }
+
+    world->views_dirty = true;
+    world->broadphase_dirty = true;
+    EcsVertexCache_begin(&world->vertex_cache);
+    return world->handles[i];
+}
+
+void EcsPhysicsWorld_remove(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return;
+    }
+    if (world->types[i] == POLYGON) {
+        world->vertex_garbage += world->polygons[i].points_count;
+    }
+
+    EcsPhysicsWorld_setAwake(world, i, false);
+    int32_t last = world->count - 1;
+    if (i != last) {
+        world->awake_mask[i] = world->awake_mask[last];
+        world->awake_ranks[i] = world->awake_ranks[last];
+        if (world->awake_ranks[i] >= 0) {
+            world->awake[world->awake_ranks[i]] = i;
+        }
+        world->positions[i][0] = world->positions[last][0];
+        world->positions[i][1] = world->positions[last][1];
+        world->rotations[i] = world->rotations[last];
+        world->sweeps[i] = world->sweeps[last];
+        world->fast[i] = world->fast[last];
+        world->sleeping[i] = world->sleeping[last];
+        world->circles[i] = world->circles[last];
+        world->polygons[i] = world->polygons[last];
+        world->capsules[i] = world->capsules[last];
+        world->boxes[i] = world->boxes[last];
+        world->vertex_offsets[i] = world->vertex_offsets[last];
+        memcpy(world->local_aabbs[i], world->local_aabbs[last], sizeof(EcsAABB));
+        memcpy(world->aabbs[i], world->aabbs[last], sizeof(EcsAABB));
+        world->types[i] = world->types[last];
+        world->handles[i] = world->handles[last];
+        world->slots[HANDLE_SLOT(world->handles[i])] = i;
+        // A change queued under the last index is queued again under i
+        if (world->sleeping[i] == world->awake_mask[i]) {
+            EcsPhysicsWorld_queueSleeping(world, i);
+        }
+    }
+    world->count--;
+
+    int32_t slot = HANDLE_SLOT(handle);
+    world->generations[slot]++;
+    if (world->generations[slot] == 0) {
+        world->generations[slot] = 1;
+    }
+    world->slots[slot] = world->free_slot;
+    world->free_slot = slot;
+
+    if (world->vertex_garbage > world->vertex_count / 2) {
+        EcsPhysicsWorld_compactVertices(world, world->vertex_capacity);
+    }
+    world->views_dirty = true;
+    world->broadphase_dirty = true;
+    EcsVertexCache_begin(&world->vertex_cache);
+}
+
+int32_t EcsPhysicsWorld_getIndex(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    if (world == NULL || handle == EcsColliderHandle_Null) {
+        return -1;
+    }
+    int32_t slot = HANDLE_SLOT(handle);
+    if (slot < 0 || slot >= world->slot_count || world->generations[slot] != HANDLE_GENERATION(handle)) {
+        return -1;
+    }
+    return world->slots[slot];
+}
+
+EcsColliderHandle EcsPhysicsWorld_getHandle(EcsPhysicsWorld *world, int32_t index)
+{
+    if (world == NULL || index < 0 || index >= world->count) {
+        return EcsColliderHandle_Null;
+    }
+    return world->handles[index];
+}
+
+int8_t EcsPhysicsWorld_setPosition(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsVector2D *position)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1 || position == NULL) {
+        return false;
+    }
+    VECTOR_X(&world->positions[i]) = VECTOR_X(position);
+    VECTOR_Y(&world->positions[i]) = VECTOR_Y(position);
+    EcsPhysicsWorld_setSleepingIndex(world, i, false);
+    return true;
+}
+
+EcsVector2D* EcsPhysicsWorld_getPosition(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return NULL;
+    }
+    return &world->positions[i];
+}
+
+int8_t EcsPhysicsWorld_setRotation(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsRotation *rotation)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1 || rotation == NULL) {
+        return false;
+    }
+    world->rotations[i] = *rotation;
+    EcsPhysicsWorld_setSleepingIndex(world, i, false);
+    return true;
+}
+
+EcsRotation* EcsPhysicsWorld_getRotation(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return NULL;
+    }
+    return &world->rotations[i];
+}
+
+int8_t EcsPhysicsWorld_setSweep(EcsPhysicsWorld *world, EcsColliderHandle handle, EcsSweep *sweep)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return false;
+    }
+    world->fast[i] = sweep != NULL;
+    if (sweep != NULL) {
+        world->sweeps[i] = *sweep;
+        EcsPhysicsWorld_setSleepingIndex(world, i, false);
+    }
+    return true;
+}
+
+int8_t EcsPhysicsWorld_setSleeping(EcsPhysicsWorld *world, EcsColliderHandle handle, int8_t sleeping)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return false;
+    }
+    EcsPhysicsWorld_setSleepingIndex(world, i, sleeping != 0);
+    return true;
+}
+
+int8_t EcsPhysicsWorld_isSleeping(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    return i != -1 && world->sleeping[i];
+}
+
+void EcsPhysicsWorld_refreshSleeping(EcsPhysicsWorld *world)
+{
+    if (world == NULL) {
+        return;
+    }
+    world->sleep_rescan = true;
+}
+
+EcsColliderData* EcsPhysicsWorld_getView(EcsPhysicsWorld *world, EcsColliderHandle handle)
+{
+    int32_t i = EcsPhysicsWorld_getIndex(world, handle);
+    if (i == -1) {
+        return NULL;
+    }
+    EcsPhysicsWorld_updateViews(world);
+    return &world->views[i];
+}
+
+void EcsPhysicsWorld_setThreadCount(EcsPhysicsWorld *world, int32_t thread_count)
+{
+    if (world == NULL) {
+        return;
+    }
+    if (world->thread_pool.thread_count > 0) {
+        EcsThreadPool_deinit(&world->thread_pool);
+    }
+    if (thread_count != 1) {
+        EcsThreadPool_init(&world->thread_pool, thread_count);
+    }
+}
+
+void EcsPhysicsWorld_setNarrowphase(EcsPhysicsWorld *world, EcsNarrowphase narrowphase)
+{
+    if (world == NULL) {
+        return;
+    }
+    world->context.narrowphase = narrowphase;
+}
+
+int8_t EcsPhysicsWorld_update(EcsPhysicsWorld *world)
+{
+    if (world == NULL) {
+        return false;
+    }
+    EcsVector2D *positions = world->positions;
+    EcsRotation *rotations = world->rotations;
+    EcsAABB *local = world->local_aabbs;
+    EcsAABB *aabbs = world->aabbs;
+    EcsVertexCache_begin(&world->vertex_cache);
+    EcsPhysicsWorld_updateViews(world);
+    EcsPhysicsWorld_updateAwake(world);
+    int32_t awake_count = world->awake_count;
+
+    // Sleeping colliders keep their AABB and their place in the broadphase
+    // unless colliders were added or removed since the last update
+    int8_t rebuild = world->broadphase_dirty || world->broadphase.count != world->count;
+    int32_t count = rebuild ? world->count : awake_count;
+    STATS_BEGIN(timer);
+    for (int32_t k = 0; k < count; k++) {
+        int32_t i = rebuild ? k : world->awake[k];
+        int8_t rotated = rotations[i].c != 1 || rotations[i].s != 0;
+        if (world->types[i] == POLYGON && rotated) {
+            EcsPhysicsWorld_getRotatedAABB(world, i, &aabbs[i]);
+        } else if (world->types[i] == CAPSULE && rotated) {
+            EcsColliderData_getAABB(&world->views[i], &aabbs[i]);
+        } else {
+            aabbs[i][0] = local[i][0] + positions[i][0];
+            aabbs[i][1] = local[i][1] + positions[i][1];
+            aabbs[i][2] = local[i][2] + positions[i][0];
+            aabbs[i][3] = local[i][3] + positions[i][1];
+            STATS_ADD(aabbs, 1);
+        }
+        if (world->fast[i]) {
+            EcsAABB_sweep(&aabbs[i], &positions[i], &world->sweeps[i]);
+        }
+    }
+    STATS_END(EcsStatsStageAABB, timer);
+    EcsSatCache_begin(&world->sat_cache);
+
+    if (!rebuild) {
+        for (int32_t k = 0; k < awake_count; k++) {
+            int32_t i = world->awake[k];
+            EcsAABBTree_move(&world->tree, world->proxies[i], &aabbs[i]);
+        }
+        if (awake_count < world->count) {
+            return EcsSweepAndPrune_move(&world->broadphase, world->awake, awake_count, aabbs);
+        }
+        return EcsSweepAndPrune_updateAABBs(&world->broadphase, aabbs, world->count);
+    }
+    // Dense indices moved, the leaves are inserted again
+    EcsAABBTree_deinit(&world->tree);
+    for (int32_t i = 0; i < world->count; i++) {
+        world->proxies[i] = EcsAABBTree_insert(&world->tree, &aabbs[i], i);
+        if (world->proxies[i] == EcsAABBTree_NullNode) {
+            return false;
+        }
+    }
+    world->broadphase_dirty = false;
+    return EcsSweepAndPrune_updateAABBs(&world->broadphase, aabbs, world->count);
+}
+
+int32_t EcsPhysicsWorld_getPairs(EcsPhysicsWorld *world, EcsColliderPair *pairs_out, int32_t max_pairs)
+{
+    if (world == NULL) {
+        return 0;
+    }
+    if (world->awake_count == world->broadphase.count) {
+        return EcsSweepAndPrune_getPairs(&world->broadphase, pairs_out, max_pairs);
+    }
+    EcsPhysicsWorldPairQuery query;
+    query.world = world;
+    query.pairs = pairs_out;
+    query.max_pairs = max_pairs;
+    query.count = 0;
+    STATS_BEGIN(timer);
+    for (int32_t k = 0; k < world->awake_count; k++) {
+        query.index = world->awake[k];
+        EcsAABBTree_query(&world->tree, &world->aabbs[query.index], EcsPhysicsWorld_pairCallback, &query);
+    }
+    STATS_END(EcsStatsStageBroadphase, timer);
+    return query.count;
+}
+
+int32_t EcsPhysicsWorld_queryAABB(EcsPhysicsWorld *world, EcsAABB *aabb, int32_t *indices_out, int32_t max_indices)
+{
+    return EcsPhysicsWorld_query(world, aabb, NULL, indices_out, max_indices);
+}
+
+int32_t EcsPhysicsWorld_queryPoint(EcsPhysicsWorld *world, EcsVector2D *point, int32_t *indices_out, int32_t max_indices)
+{
+    return EcsPhysicsWorld_queryCircle(world, point, 0, indices_out, max_indices);
+}
+
+int32_t EcsPhysicsWorld_queryCircle(
+    EcsPhysicsWorld *world,
+    EcsVector2D *center,
+    float radius,
+    int32_t *indices_out,
+    int32_t max_indices)
+{
+    if (center == NULL || radius < 0) {
+        return 0;
+    }
+    EcsCircleCollider circle = {radius};
+    EcsColliderData shape = {center, &circle, NULL, NULL, NULL, NULL};
+    EcsAABB aabb;
+    if (!EcsColliderData_getAABB(&shape, &aabb)) {
+        return 0;
+    }
+    return EcsPhysicsWorld_query(world, &aabb, &shape, indices_out, max_indices);
+}
+
+int32_t EcsPhysicsWorld_collide(
+    EcsPhysicsWorld *world,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsCollisionInfo *collisions_out,
+    int32_t *hits_out)
+{
+    if (world == NULL) {
+        return 0;
+    }
+    EcsPhysicsWorld_updateViews(world);
+    world->context.vertex_cache = &world->vertex_cache;
+    world->context.sat_cache = &world->sat_cache;
+    return EcsPhysis2dCollisionCheckParallel(
+        &world->thread_pool, &world->context, world->view_ptrs, pairs, pair_count, collisions_out, hits_out);
+}
+
+int32_t EcsPhysicsWorld_timeOfImpact(
+    EcsPhysicsWorld *world,
+    EcsColliderPair *pairs,
+    int32_t pair_count,
+    EcsToiInfo *toi_out,
+    int32_t *hits_out)
+{
+    if (world == NULL || pairs == NULL || toi_out == NULL) {
+        return 0;
+    }
+    EcsPhysicsWorld_updateViews(world);
+    int32_t hits = 0;
+    for (int32_t i = 0; i < pair_count; i++) {
+        int32_t a = pairs[i].a;
+        int32_t b = pairs[i].b;
+        if (!world->fast[a] && !world->fast[b]) {
+            continue;
+        }
+        if (!EcsPhysis2dTimeOfImpact(
+                &world->views[a], world->fast[a] ? &world->sweeps[a] : NULL,
+                &world->views[b], world->fast[b] ? &world->sweeps[b] : NULL,
+                &toi_out[hits])) {
+            continue;
+        }
+        if (hits_out != NULL) {
+            hits_out[hits] = i;
+        }
+        hits++;
+    }
+    return hits;
+}
+
+static int8_t EcsPhysicsWorld_reserve(EcsPhysicsWorld *world, int32_t count)
+{
+    if (count <= world->capacity) {
+        return true;
+    }
+    int32_t capacity = world->capacity ? world->capacity * 2 : 64;
+    void *data;
+#define WORLD_REALLOC(field) \
+    data = realloc(world->field, capacity * sizeof(*world->field)); \
+    if (data == NULL) { \
+        return false; \
+    } \
+    world->field = data;
+
+    WORLD_REALLOC(positions);
+    WORLD_REALLOC(rotations);
+    WORLD_REALLOC(sweeps);
+    WORLD_REALLOC(fast);
+    WORLD_REALLOC(sleeping);
+    WORLD_REALLOC(awake);
+    WORLD_REALLOC(awake_mask);
+    WORLD_REALLOC(awake_ranks);
+    WORLD_REALLOC(sleep_changes);
+    WORLD_REALLOC(circles);
+    WORLD_REALLOC(polygons);
+    WORLD_REALLOC(capsules);
+    WORLD_REALLOC(boxes);
+    WORLD_REALLOC(vertex_offsets);
+    WORLD_REALLOC(local_aabbs);
+    WORLD_REALLOC(aabbs);
+    WORLD_REALLOC(types);
+    WORLD_REALLOC(handles);
+    WORLD_REALLOC(views);
+    WORLD_REALLOC(view_ptrs);
+    WORLD_REALLOC(proxies);
+#undef WORLD_REALLOC
+    world->capacity = capacity;
+    world->views_dirty = true;
+    return true;
+}
+
+static int8_t EcsPhysicsWorld_reserveSlots(EcsPhysicsWorld *world, int32_t count)
+{
+    if (world->free_slot != -1 || count <= world->slot_capacity) {
+        return true;
+    }
+    int32_t capacity = world->slot_capacity ? world->slot_capacity * 2 : 64;
+    int32_t *slots = realloc(world->slots, capacity * sizeof(int32_t));
+    if (slots == NULL) {
+        return false;
+    }
+    world->slots = slots;
+    uint32_t *generations = realloc(world->generations, capacity * sizeof(uint32_t));
+    if (generations == NULL) {
+        return false;
+    }
+    world->generations = generations;
+    world->slot_capacity = capacity;
+    return true;
+}
+
+static int8_t EcsPhysicsWorld_reserveVertices(EcsPhysicsWorld *world, int32_t count)
+{
+    if (world->vertex_count + count <= world->vertex_capacity) {
+        return true;
+    }
+    int32_t capacity = world->vertex_capacity ? world->vertex_capacity : 256;
+    while (capacity < world->vertex_count - world->vertex_garbage + count) {
+        capacity *= 2;
+    }
+    if (capacity == world->vertex_capacity) {
+        capacity *= 2;
+    }
+    return EcsPhysicsWorld_compactVertices(world, capacity);
+}
+
+/* Moves the live polygons into new pools of the given capacity */
+static int8_t EcsPhysicsWorld_compactVertices(EcsPhysicsWorld *world, int32_t capacity)
+{
+    EcsPoint *vertices = malloc(capacity * sizeof(EcsPoint));
+    EcsVector2D *normals = malloc(capacity * sizeof(EcsVector2D));
+    EcsPolygonSupport *supports = malloc(capacity * sizeof(EcsPolygonSupport));
+    int32_t *facing = malloc(capacity * sizeof(int32_t));
+    if (vertices == NULL || normals == NULL || supports == NULL || facing == NULL) {
+        free(vertices);
+        free(normals);
+        free(supports);
+        free(facing);
+        return false;
+    }
+    int32_t offset = 0;
+    for (int32_t i = 0; i < world->count; i++) {
+        if (world->types[i] != POLYGON) {
+            continue;
+        }
+        int32_t size = world->polygons[i].points_count;
+        memcpy(&vertices[offset], &world->vertices[world->vertex_offsets[i]], size * sizeof(EcsPoint));
+        memcpy(&normals[offset], &world->normals[world->vertex_offsets[i]], size * sizeof(EcsVector2D));
+        if (world->polygons[i].supports != NULL) {
+            memcpy(&supports[offset], &world->supports[world->vertex_offsets[i]], size * sizeof(EcsPolygonSupport));
+        }
+        if (world->polygons[i].facing != NULL) {
+            memcpy(&facing[offset], &world->facing[world->vertex_offsets[i]], size * sizeof(int32_t));
+        }
+        world->vertex_offsets[i] = offset;
+        offset += size;
+    }
+    free(world->vertices);
+    free(world->normals);
+    free(world->supports);
+    free(world->facing);
+    world->vertices = vertices;
+    world->normals = normals;
+    world->supports = supports;
+    world->facing = facing;
+    world->vertex_count = offset;
+    world->vertex_capacity = capacity;
+    world->vertex_garbage = 0;
+    EcsPhysicsWorld_rebasePolygons(world);
+    return true;
+}
+
+static void EcsPhysicsWorld_rebasePolygons(EcsPhysicsWorld *world)
+{
+    for (int32_t i = 0; i < world->count; i++) {
+        if (world->types[i] != POLYGON) {
+            continue;
+        }
+        world->polygons[i].points = &world->vertices[world->vertex_offsets[i]];
+        world->polygons[i].normals = &world->normals[world->vertex_offsets[i]];
+        if (world->polygons[i].supports != NULL) {
+            world->polygons[i].supports = &world->supports[world->vertex_offsets[i]];
+        }
+        if (world->polygons[i].facing != NULL) {
+            world->polygons[i].facing = &world->facing[world->vertex_offsets[i]];
+        }
+    }
+    EcsVertexCache_begin(&world->vertex_cache);
+}
+
+static void EcsPhysicsWorld_updateViews(EcsPhysicsWorld *world)
+{
+    if (!world->views_dirty) {
+        return;
+    }
+    for (int32_t i = 0; i < world->count; i++) {
+        world->views[i][POSITION] = &world->positions[i];
+        world->views[i][CIRCLE] = world->types[i] == CIRCLE ? &world->circles[i] : NULL;
+        world->views[i][POLYGON] = world->types[i] == POLYGON ? &world->polygons[i] : NULL;
+        world->views[i][ROTATION] = &world->rotations[i];
+        world->views[i][CAPSULE] = world->types[i] == CAPSULE ? &world->capsules[i] : NULL;
+        world->views[i][BOX] = world->types[i] == BOX ? &world->boxes[i] : NULL;
+        world->view_ptrs[i] = &world->views[i];
+    }
+    world->views_dirty = false;
+}
+
+/*
+ * World AABB of a rotated polygon, from its vertices in the vertex cache so
+ * the polygon is transformed once per step.
+ */
+static void EcsPhysicsWorld_getRotatedAABB(EcsPhysicsWorld *world, int32_t i, EcsAABB *aabb_out)
+{
+    EcsVertexCacheEntry *entry = EcsVertexCache_getEntry(&world->vertex_cache, COLLIDER_DATA(&world->views[i]));
+    if (entry == NULL) {
+        EcsColliderData_getAABB(&world->views[i], aabb_out);
+        return;
+    }
+    EcsPoint *vertices = entry->vertices;
+    AABB_MIN_X(aabb_out) = FLT_MAX;
+    AABB_MIN_Y(aabb_out) = FLT_MAX;
+    AABB_MAX_X(aabb_out) = -FLT_MAX;
+    AABB_MAX_Y(aabb_out) = -FLT_MAX;
+    for (int32_t v = 0; v < entry->count; v++) {
+        AABB_MIN_X(aabb_out) = VECTOR_X(&vertices[v]) < AABB_MIN_X(aabb_out) ? VECTOR_X(&vertices[v]) : AABB_MIN_X(aabb_out);
+        AABB_MIN_Y(aabb_out) = VECTOR_Y(&vertices[v]) < AABB_MIN_Y(aabb_out) ? VECTOR_Y(&vertices[v]) : AABB_MIN_Y(aabb_out);
+        AABB_MAX_X(aabb_out) = VECTOR_X(&vertices[v]) > AABB_MAX_X(aabb_out) ? VECTOR_X(&vertices[v]) : AABB_MAX_X(aabb_out);
+        AABB_MAX_Y(aabb_out) = VECTOR_Y(&vertices[v]) > AABB_MAX_Y(aabb_out) ? VECTOR_Y(&vertices[v]) : AABB_MAX_Y(aabb_out);
+    }
+}
+
+static void EcsPhysicsWorld_setSleepingIndex(EcsPhysicsWorld *world, int32_t i, int8_t sleeping)
+{
+    if (world->sleeping[i] == sleeping) {
+        return;
+    }
+    world->sleeping[i] = sleeping;
+    EcsPhysicsWorld_queueSleeping(world, i);
+}
+
+/*
+ * Entries are applied by reading the flag again, an index queued twice or
+ * reused by another collider is harmless
+ */
+static void EcsPhysicsWorld_queueSleeping(EcsPhysicsWorld *world, int32_t i)
+{
+    if (world->sleep_change_count >= world->capacity) {
+        world->sleep_rescan = true;
+        return;
+    }
+    world->sleep_changes[world->sleep_change_count++] = i;
+}
+
+static void EcsPhysicsWorld_setAwake(EcsPhysicsWorld *world, int32_t i, int8_t awake)
+{
+    int32_t rank = world->awake_ranks[i];
+    world->awake_mask[i] = awake;
+    if (awake && rank < 0) {
+        world->awake_ranks[i] = world->awake_count;
+        world->awake[world->awake_count++] = i;
+    } else if (!awake && rank >= 0) {
+        int32_t moved = world->awake[--world->awake_count];
+        world->awake[rank] = moved;
+        world->awake_ranks[moved] = rank;
+        world->awake_ranks[i] = -1;
+    }
+}
+
+static void EcsPhysicsWorld_updateAwake(EcsPhysicsWorld *world)
+{
+    if (world->sleep_rescan) {
+        world->awake_count = 0;
+        for (int32_t i = 0; i < world->count; i++) {
+            world->awake_mask[i] = !world->sleeping[i];
+            world->awake_ranks[i] = world->awake_mask[i] ? world->awake_count : -1;
+            if (world->awake_mask[i]) {
+                world->awake[world->awake_count++] = i;
+            }
+        }
+    } else {
+        for (int32_t k = 0; k < world->sleep_change_count; k++) {
+            int32_t i = world->sleep_changes[k];
+            if (i < world->count) {
+                EcsPhysicsWorld_setAwake(world, i, !world->sleeping[i]);
+            }
+        }
+    }
+    world->sleep_change_count = 0;
+    world->sleep_rescan = false;
+}
+
+static int32_t EcsPhysicsWorld_query(
+    EcsPhysicsWorld *world,
+    EcsAABB *aabb,
+    EcsColliderData *shape,
+    int32_t *indices_out,
+    int32_t max_indices)
+{
+    if (world == NULL || aabb == NULL) {
+        return 0;
+    }
+    EcsPhysicsWorldQuery query;
+    query.world = world;
+    query.aabb = aabb;
+    query.shape = shape;
+    query.indices = indices_out;
+    query.max_indices = indices_out != NULL ? max_indices : 0;
+    query.count = 0;
+    if (shape != NULL) {
+        EcsPhysicsWorld_updateViews(world);
+        world->context.vertex_cache = &world->vertex_cache;
+        world->context.sat_cache = &world->sat_cache;
+    }
+    EcsAABBTree_query(&world->tree, aabb, EcsPhysicsWorld_queryCallback, &query);
+    return query.count;
+}
+
+static int8_t EcsPhysicsWorld_queryCallback(void *ctx, int32_t index)
+{
+    EcsPhysicsWorldQuery *query = ctx;
+    // Leaves are fattened, the world AABB decides
+    if (!EcsAABBTest(query->aabb, &query->world->aabbs[index])) {
+        return true;
+    }
+    if (query->shape != NULL) {
+        EcsCollisionInfo collision;
+        EcsPhysicsWorld *world = query->world;
+        if (!EcsPhysis2dCollisionCheckWithContext(&world->context, query->shape, &world->views[index], &collision)) {
+            return true;
+        }
+    }
+    if (query->count < query->max_indices) {
+        query->indices[query->count] = index;
+    }
+    query->count++;
+    return true;
+}
+
+static int8_t EcsPhysicsWorld_pairCallback(void *ctx, int32_t index)
+{
+    EcsPhysicsWorldPairQuery *query = ctx;
+    EcsPhysicsWorld *world = query->world;
+    int32_t a = query->index;
+    // Pairs of two awake colliders are found from both, keep one
+    if (index == a || (index < a && world->awake_mask[index])) {
+        return true;
+    }
+    // Leaves are fattened, the world AABBs decide
+    if (!EcsAABBTest(&world->aabbs[a], &world->aabbs[index])) {
+        return true;
+    }
+    if (query->count < query->max_pairs) {
+        query->pairs[query->count].a = a < index ? a : index;
+        query->pairs[query->count].b = a < index ? index : a;
+    }
+    query->count++;
+    return true;
+}
@@ -28,17 +28,33 @@
 // EcsColliderData[0] = Position, 
 // EcsColliderData[1] = CircleCollider, 
 // EcsColliderData[2] = PolygonCollider
+// EcsColliderData[3] = Rotation
+// EcsColliderData[4] = CapsuleCollider
+// EcsColliderData[5] = BoxCollider
 #define POSITION 0
 #define CIRCLE 1
 #define POLYGON 2
+#define ROTATION 3
+#define CAPSULE 4
+#define BOX 5
 
 #define GET_POSITION(collider) ((EcsPoint*)((*collider)[POSITION]))
 #define GET_CIRCLE(collider)   ((EcsCircleCollider*)((*collider)[CIRCLE]))
 #define GET_POLYGON(collider)  ((EcsPolygonCollider*)((*collider)[POLYGON]))
+#define GET_ROTATION(collider) ((EcsRotation*)((*collider)[ROTATION]))
+#define GET_CAPSULE(collider)  ((EcsCapsuleCollider*)((*collider)[CAPSULE]))
+#define GET_BOX(collider)      ((EcsBoxCollider*)((*collider)[BOX]))
 
-#define COLLIDER_DATA(collider) ((ColliderData_t*)collider)
+#define COLLIDER_DATA(collider) ((ColliderData_t*)(collider))
 #define GET_COLLIDER_TYPE(collider) ((GET_CIRCLE(collider) != NULL) ? CIRCLE :\
-                                 (GET_POLYGON(collider) != NULL) ? POLYGON : ERR)
+                                 (GET_POLYGON(collider) != NULL) ? POLYGON :\
+                                 (GET_CAPSULE(collider) != NULL) ? CAPSULE :\
+                                 (GET_BOX(collider) != NULL) ? BOX : ERR)
+#define GET_DATA_TYPE(collider) GET_COLLIDER_TYPE((EcsColliderData*)(collider))
+// Capsules and boxes, the shapes with a dedicated primitive narrowphase
+#define IS_PRIMITIVE(type) ((type) == CAPSULE || (type) == BOX)
+#define STATS_PAIR(type_a, type_b) ((IS_PRIMITIVE(type_a) || IS_PRIMITIVE(type_b)) ? \
+                                    EcsStatsPairPrimitive : ((type_a) == POLYGON) + ((type_b) == POLYGON))
 
 #define POLYGON_COLLIDER_START(polygon) (polygon->points)
 #define POLYGON_COLLIDER_END(polygon) (&(polygon->points[polygon->points_count]))
@@ -47,7 +63,181 @@ typedef struct ColliderData {
     EcsPoint *position;
     EcsCircleCollider *circle;
     EcsPolygonCollider *polygon;
+    EcsRotation *rotation;
+    EcsCapsuleCollider *capsule;
+    EcsBoxCollider *box;
 } ColliderData_t;
 
+// Polygons with at least SIMD_THRESHOLD vertices are projected with
+// EcsPhysis2d_projectSoA
+#define SIMD_THRESHOLD 8
+
+// Polygons with at least EXTREME_THRESHOLD vertices are baked with supports.
+// GJK uses them at any size, SAT projections only from
+// EXTREME_PROJECTION_THRESHOLD vertices, the vector kernel is faster below.
+#define EXTREME_THRESHOLD 64
+#define EXTREME_PROJECTION_THRESHOLD 256
+
+// Size of the stack buffers passed to EcsPhysis2d_getWorldVertices, bigger
+// polygons are transformed into heap memory
+#define VERTEX_BUFFER_SIZE 128
+
+// View of a polygon used by the narrowphase, in world space or in the local
+// frame of another collider
+//  xs, ys: SoA copy of points, NULL below SIMD_THRESHOLD
+//  normals, supports, facing: Baked data of the polygon, in its local frame
+//  rotation: Rotation from the local frame of the polygon to the frame of
+//            points, applied to the baked normals and supports
+//  shape: EcsPolygonShape of the polygon, generic when it does not match size
+//  winding: Baked winding of the polygon, 0 when the points are not baked
+//  heap: Memory owned by the view, see EcsPhysis2d_releaseWorldVertices
+typedef struct PolygonVertices {
+    EcsPoint *points;
+    float *xs;
+    float *ys;
+    EcsVector2D *normals;
+    EcsPolygonSupport *supports;
+    int32_t *facing;
+    EcsRotation rotation;
+    int32_t size;
+    int8_t shape;
+    int8_t winding;
+    void *heap;
+} PolygonVertices_t;
+
+// Stats of the calling thread, see EcsPhysicsStats. STATS_ADD adds to a
+// counter of the slot, STATS_BEGIN / STATS_END time a stage. They expand to
+// nothing without ECS_PHYSICS_STATS.
+#ifdef ECS_PHYSICS_STATS
+extern __thread EcsPhysicsStats *EcsPhysicsStats_slot;
+extern __thread int8_t EcsPhysicsStats_shared;
+EcsPhysicsStats* EcsPhysicsStats_getSlot(void);
+uint64_t EcsPhysicsStats_now(void);
+
+// Only the owner thread writes a slot, readers load it without locks. The
+// slot shared by the threads past the last one takes atomic adds
+#define STATS_SLOT() (EcsPhysicsStats_slot != NULL ? EcsPhysicsStats_slot : EcsPhysicsStats_getSlot())
+#define STATS_ADD(field, value) do { \
+        uint64_t *counter_ = &STATS_SLOT()->field; \
+        if (EcsPhysicsStats_shared) { \
+            __atomic_fetch_add(counter_, (value), __ATOMIC_RELAXED); \
+        } else { \
+            __atomic_store_n(counter_, __atomic_load_n(counter_, __ATOMIC_RELAXED) + (value), __ATOMIC_RELAXED); \
+        } \
+    } while (0)
+#define STATS_BEGIN(timer) uint64_t timer = EcsPhysicsStats_now()
+#define STATS_END(stage, timer) do { \
+        STATS_ADD(stage_time[stage], EcsPhysicsStats_now() - (timer)); \
+        STATS_ADD(stage_calls[stage], 1); \
+    } while (0)
+#else
+#define STATS_ADD(field, value) do { } while (0)
+#define STATS_BEGIN(timer) do { } while (0)
+#define STATS_END(stage, timer) do { } while (0)
+#endif
+
+// Grows the AABB of a collider at position to cover the whole sweep
+void EcsAABB_sweep(EcsAABB *aabb, EcsVector2D *position, EcsSweep *sweep);
+EcsVertexCacheEntry* EcsVertexCache_getEntry(EcsVertexCache *cache, ColliderData_t *collider);
+// swapped_out is set when collider_a is b in the key of the entry
+EcsSatCacheEntry* EcsSatCache_getEntry(EcsSatCache *cache, ColliderData_t *collider_a, ColliderData_t *collider_b, int8_t *swapped_out);
+void EcsPolygonCollider_computeNormals(EcsPoint *points, int32_t size, EcsVector2D *normals_out);
+// Returns false when the supports can not order the edges, use the linear scan
+int8_t EcsPolygonCollider_computeSupports(EcsPoint *points, EcsVector2D *normals, int32_t size, EcsPolygonSupport *supports_out);
+int8_t EcsPolygonCollider_computeShape(EcsVector2D *normals, int32_t size);
+// 1 for counter clockwise points, -1 for clockwise
+int8_t EcsPolygonCollider_computeWinding(EcsPoint *points, int32_t size);
+void EcsPolygonCollider_computeBounds(EcsPoint *points, int32_t size, EcsAABB *aabb_out);
+// Returns the number of edges facing an earlier edge, -1 when out of memory
+int32_t EcsPolygonCollider_computeFacing(EcsVector2D *normals, int32_t size, int32_t *facing_out);
+int32_t EcsPolygonCollider_getExtremeVertex(EcsPolygonSupport *supports, int32_t size, float x, float y);
+
+int8_t EcsPhysis2dGjk_collide(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out);
+// Pairs with a capsule or a box, see physics_primitive.c
+int8_t EcsPhysis2dPrimitive_collide(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsCollisionInfo *collision_out);
+// Distance of two separated cores and their closest points, vertex against
+// edge both ways
+float EcsPhysis2dPrimitive_getCoreDistance(
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    EcsPoint *point_a, EcsPoint *point_b);
+
+// Transform of a collider, identity rotation when it has none. Boxes are
+// aligned with the world axes and never take the rotation.
+void EcsPhysis2d_getTransform(ColliderData_t *collider, EcsTransform *out);
+
+// buffer and soa_buffer must hold VERTEX_BUFFER_SIZE points, returns false
+// when out of memory. Release out with EcsPhysis2d_releaseWorldVertices.
+int8_t EcsPhysis2d_getWorldVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out);
+// Vertices of polygon moved by transform, NULL keeps the local vertices
+int8_t EcsPhysis2d_getFrameVertices(
+    ColliderData_t *polygon,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out);
+// Vertices of both polygons of a pair in a common frame: world space when ctx
+// has a vertex cache, the local frame of polygon_a otherwise, so only
+// polygon_b is transformed. frame_out moves results back to world space.
+int8_t EcsPhysis2d_getPairVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *polygon_a,
+    ColliderData_t *polygon_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    PolygonVertices_t *vertices_a,
+    PolygonVertices_t *vertices_b,
+    EcsTransform *frame_out);
+// Core of any collider plus the radius around it: polygon vertices, the
+// corners of boxes, the segment of capsules (a point when both ends are the
+// same) and the center of circles. buffer must hold VERTEX_BUFFER_SIZE
+// points for polygons, primitive cores go into its first 4. transform moves
+// the collider into the frame of the pair, NULL for world space.
+int8_t EcsPhysis2d_getCoreVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider,
+    EcsTransform *transform,
+    EcsPoint *buffer, float *soa_buffer,
+    PolygonVertices_t *out,
+    float *radius_out);
+// Same as EcsPhysis2d_getPairVertices for the cores of any two colliders
+int8_t EcsPhysis2d_getCorePairVertices(
+    EcsPhysis2dContext *ctx,
+    ColliderData_t *collider_a,
+    ColliderData_t *collider_b,
+    EcsPoint *buffer_a, float *soa_a,
+    EcsPoint *buffer_b, float *soa_b,
+    PolygonVertices_t *vertices_a, float *radius_a,
+    PolygonVertices_t *vertices_b, float *radius_b,
+    EcsTransform *frame_out);
+void EcsPhysis2d_releaseWorldVertices(PolygonVertices_t *vertices);
+// Min and max of the vertices along axis
+void EcsPhysis2d_getProjection(
+    EcsVector2D *axis,
+    PolygonVertices_t *vertices,
+    EcsVector2D *out);
+// Extreme vertex of a view with supports along direction, in the view frame
+int32_t EcsPhysis2d_getExtremeVertex(PolygonVertices_t *vertices, EcsVector2D *direction);
+
+// 1 for counter clockwise polygons, -1 for clockwise ones. Baked normals
+// point outwards for counter clockwise polygons only.
+float EcsPhysis2d_getWinding(PolygonVertices_t *vertices);
+// Unit normal of edge [edge, edge+1] pointing out of the polygon
+void EcsPhysis2d_getOutwardNormal(
+    PolygonVertices_t *vertices, float winding,
+    int32_t edge,
+    EcsVector2D *out);
+
 
 #endif
\ No newline at end of file
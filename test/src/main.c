@@ -74,7 +74,7 @@ typedef struct Circle {
     EcsCircleCollider collider;
     EcsColliderData data;
 } Circle;
-#define DEFINE_CIRCLE(name, r) Circle name = {{0,0},{r},{&name.position, &name.collider, NULL}}
+#define DEFINE_CIRCLE(name, r) Circle name = {{0,0},{r},{&name.position, &name.collider, NULL, NULL, NULL, NULL}}
 
 typedef struct Polygon {
     EcsVector2D position;
@@ -83,7 +83,7 @@ typedef struct Polygon {
     EcsPoint points[4];
 }Polygon;
 #define POS(x,y) {x,y}
-#define DEFINE_POLYGON(name, c, p0, p1, p2, p3) Polygon name = {{0,0},{name.points, c}, {&name.position, NULL, &name.collider}, {p0,p1,p2,p3}}
+#define DEFINE_POLYGON(name, c, p0, p1, p2, p3) Polygon name = {{0,0},{name.points, c}, {&name.position, NULL, &name.collider, NULL, NULL, NULL}, {p0,p1,p2,p3}}
 
 
 
@@ -0,0 +1,33 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <physics_2d/physics_2d.h>
+#include <physics_2d/physics_parallel.h>
+#include <physics_2d/physics_simd.h>
+#include <physics_2d/physics_world.h>
+
+// Failed checks of the running test
+extern int32_t test_failures;
+
+#define TEST_CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+uint32_t Test_random(uint32_t *state);
+float Test_uniform(uint32_t *state, float min, float max);
+
+void Test_projectionKernels(void);
+void Test_polygonSupports(void);
+void Test_polygonWinding(void);
+void Test_raycastBounds(void);
+void Test_shapeCastBatch(void);
+void Test_sweepAndPruneExtent(void);
+void Test_worldQuery(void);
+void Test_worldPairs(void);
+void Test_threadPool(void);
+void Test_parallelCollide(void);
@@ -0,0 +1,173 @@
+#include "tests.h"
+
+#define WORLD_COLLIDERS 300
+#define WORLD_STEPS 20
+
+/*
+ * Shrinking the largest collider with a move must bring max_extent down to
+ * the next largest one.
+ */
+void Test_sweepAndPruneExtent(void)
+{
+    EcsAABB aabbs[3] = {{0, 0, 1, 1}, {2, 0, 100, 1}, {5, 0, 8, 1}};
+    EcsSweepAndPrune sap;
+    EcsSweepAndPrune_init(&sap);
+    TEST_CHECK(EcsSweepAndPrune_updateAABBs(&sap, aabbs, 3));
+    float large = sap.max_extent;
+    TEST_CHECK(large >= 98);
+
+    int32_t moved = 1;
+    aabbs[1][2] = 2.5f;
+    aabbs[1][3] = 99;
+    TEST_CHECK(EcsSweepAndPrune_move(&sap, &moved, 1, aabbs));
+    TEST_CHECK(sap.max_extent < large);
+    TEST_CHECK(sap.max_extent == 3 || sap.max_extent == 97);
+    EcsSweepAndPrune_deinit(&sap);
+}
+
+/*
+ * Region queries of a world holding one huge collider must find exactly the
+ * colliders whose AABB overlaps the region, while colliders move and sleep.
+ */
+void Test_worldQuery(void)
+{
+    uint32_t state = 9;
+    EcsPhysicsWorld world;
+    EcsPhysicsWorld_init(&world);
+    EcsColliderHandle handles[WORLD_COLLIDERS];
+    EcsCircleCollider circle = {0.5f};
+    EcsPoint wall_points[4] = {{-500, -1}, {500, -1}, {500, 1}, {-500, 1}};
+    EcsPolygonCollider wall;
+    TEST_CHECK(EcsPolygonCollider_init(&wall, wall_points, 4));
+    for (int32_t i = 0; i < WORLD_COLLIDERS; i++) {
+        EcsPoint position = {Test_uniform(&state, -50, 50), Test_uniform(&state, -50, 50)};
+        EcsColliderData data = {0};
+        data[0] = &position;
+        if (i == 0) {
+            data[2] = &wall;
+        } else {
+            data[1] = &circle;
+        }
+        handles[i] = EcsPhysicsWorld_add(&world, &data);
+        TEST_CHECK(handles[i] != EcsColliderHandle_Null);
+    }
+
+    int32_t indices[WORLD_COLLIDERS];
+    for (int32_t step = 0; step < WORLD_STEPS; step++) {
+        for (int32_t i = 1; i < WORLD_COLLIDERS; i++) {
+            uint32_t kind = Test_random(&state) % 4;
+            if (kind == 0) {
+                EcsPhysicsWorld_setSleeping(&world, handles[i], true);
+            } else if (kind == 1) {
+                EcsPoint position = {Test_uniform(&state, -50, 50), Test_uniform(&state, -50, 50)};
+                EcsPhysicsWorld_setPosition(&world, handles[i], &position);
+            }
+        }
+        TEST_CHECK(EcsPhysicsWorld_update(&world));
+
+        for (int32_t run = 0; run < 20; run++) {
+            float x = Test_uniform(&state, -50, 50);
+            float y = Test_uniform(&state, -50, 50);
+            EcsAABB region = {x, y, x + Test_uniform(&state, 0, 10), y + Test_uniform(&state, 0, 10)};
+            int32_t count = EcsPhysicsWorld_queryAABB(&world, &region, indices, WORLD_COLLIDERS);
+            int32_t expected = 0;
+            for (int32_t i = 0; i < world.count; i++) {
+                if (!EcsAABBTest(&region, &world.aabbs[i])) {
+                    continue;
+                }
+                int8_t found = false;
+                for (int32_t k = 0; k < count && !found; k++) {
+                    found = indices[k] == i;
+                }
+                TEST_CHECK(found);
+                expected++;
+            }
+            TEST_CHECK(count == expected);
+        }
+    }
+    EcsPhysicsWorld_deinit(&world);
+    EcsPolygonCollider_release(&wall);
+}
+
+static int Test_comparePairs(const void *a, const void *b)
+{
+    const EcsColliderPair *pair_a = a;
+    const EcsColliderPair *pair_b = b;
+    return pair_a->a != pair_b->a ? pair_a->a - pair_b->a : pair_a->b - pair_b->b;
+}
+
+/*
+ * Pairs of a partly sleeping world must be the overlapping AABBs with at
+ * least one awake collider, while colliders sleep, wake, move, come and go,
+ * and when the sleeping flags are written directly.
+ */
+void Test_worldPairs(void)
+{
+    static EcsColliderPair pairs[WORLD_COLLIDERS * WORLD_COLLIDERS / 2];
+    static EcsColliderPair expected[WORLD_COLLIDERS * WORLD_COLLIDERS / 2];
+    uint32_t state = 13;
+    EcsPhysicsWorld world;
+    EcsPhysicsWorld_init(&world);
+    EcsColliderHandle handles[WORLD_COLLIDERS];
+    EcsCircleCollider circle = {1};
+    EcsBoxCollider wall = {{200, 1}};
+    for (int32_t i = 0; i < WORLD_COLLIDERS; i++) {
+        EcsPoint position = {Test_uniform(&state, -30, 30), Test_uniform(&state, -30, 30)};
+        EcsColliderData data = {0};
+        data[0] = &position;
+        if (i == 0) {
+            data[5] = &wall;
+        } else {
+            data[1] = &circle;
+        }
+        handles[i] = EcsPhysicsWorld_add(&world, &data);
+    }
+
+    for (int32_t step = 0; step < WORLD_STEPS; step++) {
+        for (int32_t i = 0; i < WORLD_COLLIDERS; i++) {
+            uint32_t kind = Test_random(&state) % 8;
+            int32_t index = EcsPhysicsWorld_getIndex(&world, handles[i]);
+            if (kind < 2) {
+                EcsPhysicsWorld_setSleeping(&world, handles[i], kind == 0);
+            } else if (kind == 2) {
+                EcsPoint position = {Test_uniform(&state, -30, 30), Test_uniform(&state, -30, 30)};
+                EcsPhysicsWorld_setPosition(&world, handles[i], &position);
+            } else if (kind == 3 && step % 2 == 1) {
+                world.sleeping[index] = !world.sleeping[index];
+            } else if (kind == 4 && step % 5 == 4) {
+                EcsPoint position = {Test_uniform(&state, -30, 30), Test_uniform(&state, -30, 30)};
+                EcsColliderData data = {0};
+                data[0] = &position;
+                data[1] = &circle;
+                EcsPhysicsWorld_remove(&world, handles[i]);
+                handles[i] = EcsPhysicsWorld_add(&world, &data);
+            }
+        }
+        if (step % 2 == 1) {
+            EcsPhysicsWorld_refreshSleeping(&world);
+        }
+        TEST_CHECK(EcsPhysicsWorld_update(&world));
+        int32_t count = EcsPhysicsWorld_getPairs(&world, pairs, WORLD_COLLIDERS * WORLD_COLLIDERS / 2);
+
+        int32_t awake = 0;
+        int32_t expected_count = 0;
+        for (int32_t i = 0; i < world.count; i++) {
+            awake += !world.sleeping[i];
+            for (int32_t j = i + 1; j < world.count; j++) {
+                if ((world.sleeping[i] && world.sleeping[j]) || !EcsAABBTest(&world.aabbs[i], &world.aabbs[j])) {
+                    continue;
+                }
+                expected[expected_count].a = i;
+                expected[expected_count].b = j;
+                expected_count++;
+            }
+        }
+        TEST_CHECK(world.awake_count == awake);
+        TEST_CHECK(count == expected_count);
+        if (count == expected_count) {
+            qsort(pairs, count, sizeof(EcsColliderPair), Test_comparePairs);
+            TEST_CHECK(!memcmp(pairs, expected, count * sizeof(EcsColliderPair)));
+        }
+    }
+    EcsPhysicsWorld_deinit(&world);
+}
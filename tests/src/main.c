@@ -0,0 +1,62 @@
+#include "tests.h"
+
+/*
+ * Headless checks of the library
+ *
+ * Every test runs in order and prints its name with the number of failed
+ * checks. The exit status is 1 when any check failed.
+ *
+ * Usage: tests
+ */
+
+typedef struct TestCase {
+    const char *name;
+    void (*run)(void);
+} TestCase;
+
+static const TestCase tests[] = {
+    {"projection_kernels", Test_projectionKernels},
+    {"polygon_supports", Test_polygonSupports},
+    {"polygon_winding", Test_polygonWinding},
+    {"raycast_bounds", Test_raycastBounds},
+    {"shape_cast_batch", Test_shapeCastBatch},
+    {"sweep_and_prune_extent", Test_sweepAndPruneExtent},
+    {"world_query", Test_worldQuery},
+    {"world_pairs", Test_worldPairs},
+    {"thread_pool", Test_threadPool},
+    {"parallel_collide", Test_parallelCollide},
+};
+#define TEST_COUNT (sizeof(tests) / sizeof(tests[0]))
+
+int32_t test_failures = 0;
+
+uint32_t Test_random(uint32_t *state)
+{
+    // xorshift32, the same sequence on every platform
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+float Test_uniform(uint32_t *state, float min, float max)
+{
+    return min + (max - min) * (float)(Test_random(state) >> 8) / (float)(1 << 24);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+    int32_t failed = 0;
+    for (size_t i = 0; i < TEST_COUNT; i++) {
+        test_failures = 0;
+        tests[i].run();
+        printf("%s %s (%d failed checks)\n", test_failures ? "FAIL" : "ok  ", tests[i].name, test_failures);
+        failed += test_failures != 0;
+    }
+    printf("%d of %d tests failed\n", failed, (int)TEST_COUNT);
+    return failed ? 1 : 0;
+}
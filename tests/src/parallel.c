@@ -0,0 +1,82 @@
+#include "tests.h"
+
+#define POOL_RUNS 200
+#define POOL_THREADS 8
+#define POOL_TASKS 64
+#define PARALLEL_COLLIDERS 400
+
+static void Test_countTask(void *ctx, int32_t task, int32_t worker)
+{
+    (void)task;
+    (void)worker;
+    __atomic_fetch_add((int32_t*)ctx, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Runs a new pool right after init, before its threads are waiting for
+ * work, every task must run once. A pool that misses the run hangs instead.
+ */
+void Test_threadPool(void)
+{
+    for (int32_t i = 0; i < POOL_RUNS; i++) {
+        EcsThreadPool pool;
+        int32_t done = 0;
+        EcsThreadPool_init(&pool, POOL_THREADS);
+        EcsThreadPool_run(&pool, POOL_TASKS, Test_countTask, &done);
+        EcsThreadPool_deinit(&pool);
+        TEST_CHECK(done == POOL_TASKS);
+    }
+}
+
+/*
+ * EcsPhysicsWorld_collide must give the same hits in the same order with
+ * any thread count, right after the thread count is set.
+ */
+void Test_parallelCollide(void)
+{
+    static EcsColliderPair pairs[PARALLEL_COLLIDERS * 16];
+    static EcsCollisionInfo expected[PARALLEL_COLLIDERS * 16];
+    static EcsCollisionInfo collisions[PARALLEL_COLLIDERS * 16];
+    static int32_t expected_hits[PARALLEL_COLLIDERS * 16];
+    static int32_t hits[PARALLEL_COLLIDERS * 16];
+    uint32_t state = 17;
+    EcsPhysicsWorld world;
+    EcsPhysicsWorld_init(&world);
+    EcsCircleCollider circle = {1};
+    EcsPoint points[5] = {{-1, -1}, {1, -1}, {1.5f, 0.5f}, {0, 1.5f}, {-1.5f, 0.5f}};
+    EcsPolygonCollider polygon;
+    TEST_CHECK(EcsPolygonCollider_init(&polygon, points, 5));
+    for (int32_t i = 0; i < PARALLEL_COLLIDERS; i++) {
+        EcsPoint position = {Test_uniform(&state, 0, 40), Test_uniform(&state, 0, 40)};
+        EcsRotation rotation;
+        EcsRotation_set(&rotation, Test_uniform(&state, 0, 6.2831853f));
+        EcsColliderData data = {0};
+        data[0] = &position;
+        data[3] = &rotation;
+        if (i % 2) {
+            data[1] = &circle;
+        } else {
+            data[2] = &polygon;
+        }
+        EcsPhysicsWorld_add(&world, &data);
+    }
+    TEST_CHECK(EcsPhysicsWorld_update(&world));
+    int32_t pair_count = EcsPhysicsWorld_getPairs(&world, pairs, PARALLEL_COLLIDERS * 16);
+    TEST_CHECK(pair_count <= PARALLEL_COLLIDERS * 16);
+    pair_count = pair_count < PARALLEL_COLLIDERS * 16 ? pair_count : PARALLEL_COLLIDERS * 16;
+
+    int32_t expected_count = EcsPhysicsWorld_collide(&world, pairs, pair_count, expected, expected_hits);
+    TEST_CHECK(expected_count > 0);
+    int32_t thread_counts[3] = {2, 4, POOL_THREADS};
+    for (int32_t t = 0; t < 3; t++) {
+        EcsPhysicsWorld_setThreadCount(&world, thread_counts[t]);
+        int32_t count = EcsPhysicsWorld_collide(&world, pairs, pair_count, collisions, hits);
+        TEST_CHECK(count == expected_count);
+        if (count == expected_count) {
+            TEST_CHECK(!memcmp(hits, expected_hits, count * sizeof(int32_t)));
+            TEST_CHECK(!memcmp(collisions, expected, count * sizeof(EcsCollisionInfo)));
+        }
+    }
+    EcsPhysicsWorld_deinit(&world);
+    EcsPolygonCollider_release(&polygon);
+}
@@ -0,0 +1,122 @@
+#include "tests.h"
+
+#define SUPPORT_VERTICES 240
+#define SUPPORT_POINTS (SUPPORT_VERTICES * 2)
+#define SUPPORT_RUNS 2000
+
+/*
+ * A round polygon with repeated vertices and edges of one ULP, the supports
+ * must find the vertices the linear scan finds.
+ */
+void Test_polygonSupports(void)
+{
+    uint32_t state = 7;
+    EcsPoint points[SUPPORT_POINTS];
+    int32_t count = 0;
+    for (int32_t i = 0; i < SUPPORT_VERTICES; i++) {
+        float angle = (float)i * 6.2831853f / SUPPORT_VERTICES;
+        points[count][0] = 10 * cosf(angle);
+        points[count][1] = 10 * sinf(angle);
+        count++;
+        if (i % 5 == 0) {
+            points[count][0] = points[count - 1][0];
+            points[count][1] = points[count - 1][1];
+            count++;
+        } else if (i % 7 == 0) {
+            points[count][0] = nextafterf(points[count - 1][0], 0);
+            points[count][1] = points[count - 1][1];
+            count++;
+        }
+    }
+    EcsPolygonCollider polygon;
+    TEST_CHECK(EcsPolygonCollider_init(&polygon, points, count));
+    TEST_CHECK(polygon.supports != NULL);
+    EcsPolygonCollider scan = polygon;
+    scan.supports = NULL;
+
+    EcsPoint box_points[4] = {{-1, -0.5f}, {1, -0.5f}, {1, 0.5f}, {-1, 0.5f}};
+    EcsPolygonCollider box;
+    TEST_CHECK(EcsPolygonCollider_init(&box, box_points, 4));
+
+    EcsPoint origin = {0, 0};
+    for (int32_t run = 0; run < SUPPORT_RUNS; run++) {
+        float angle = Test_uniform(&state, -3.1415926f, 3.1415926f);
+        float radius = Test_uniform(&state, 8, 12);
+        EcsPoint position = {radius * cosf(angle), radius * sinf(angle)};
+        EcsColliderData box_data = {0};
+        EcsColliderData polygon_data = {0};
+        EcsColliderData scan_data = {0};
+        box_data[0] = &position;
+        box_data[2] = &box;
+        polygon_data[0] = &origin;
+        polygon_data[2] = &polygon;
+        scan_data[0] = &origin;
+        scan_data[2] = &scan;
+
+        EcsCollisionInfo expected = {0};
+        EcsCollisionInfo result = {0};
+        int8_t expected_hit = EcsPhysis2dCollisionCheck(&box_data, &scan_data, &expected);
+        int8_t hit = EcsPhysis2dCollisionCheck(&box_data, &polygon_data, &result);
+        TEST_CHECK(hit == expected_hit);
+        if (hit && expected_hit) {
+            TEST_CHECK(fabsf(result.distance - expected.distance) <= 1e-4f);
+        }
+
+        EcsDistanceInfo expected_distance;
+        EcsDistanceInfo distance;
+        TEST_CHECK(EcsPhysis2dDistance(NULL, &box_data, &scan_data, &expected_distance));
+        TEST_CHECK(EcsPhysis2dDistance(NULL, &box_data, &polygon_data, &distance));
+        TEST_CHECK(fabsf(distance.distance - expected_distance.distance) <= 1e-4f);
+    }
+    EcsPolygonCollider_release(&box);
+    EcsPolygonCollider_release(&polygon);
+}
+
+/*
+ * The winding is baked with the normals, circles must collide with a
+ * clockwise polygon as with the same polygon counter clockwise.
+ */
+void Test_polygonWinding(void)
+{
+    uint32_t state = 11;
+    EcsPoint ccw_points[5] = {{-2, -1}, {2, -1}, {3, 1}, {0, 2}, {-3, 1}};
+    EcsPoint cw_points[5];
+    for (int32_t i = 0; i < 5; i++) {
+        cw_points[i][0] = ccw_points[4 - i][0];
+        cw_points[i][1] = ccw_points[4 - i][1];
+    }
+    EcsPolygonCollider ccw;
+    EcsPolygonCollider cw;
+    TEST_CHECK(EcsPolygonCollider_init(&ccw, ccw_points, 5));
+    TEST_CHECK(EcsPolygonCollider_init(&cw, cw_points, 5));
+    TEST_CHECK(ccw.winding == 1);
+    TEST_CHECK(cw.winding == -1);
+
+    EcsCircleCollider circle = {0.75f};
+    EcsPoint origin = {0, 0};
+    for (int32_t run = 0; run < 500; run++) {
+        EcsPoint position = {Test_uniform(&state, -4, 4), Test_uniform(&state, -3, 3)};
+        EcsColliderData circle_data = {0};
+        EcsColliderData ccw_data = {0};
+        EcsColliderData cw_data = {0};
+        circle_data[0] = &position;
+        circle_data[1] = &circle;
+        ccw_data[0] = &origin;
+        ccw_data[2] = &ccw;
+        cw_data[0] = &origin;
+        cw_data[2] = &cw;
+
+        EcsCollisionInfo expected = {0};
+        EcsCollisionInfo result = {0};
+        int8_t expected_hit = EcsPhysis2dCollisionCheck(&circle_data, &ccw_data, &expected);
+        int8_t hit = EcsPhysis2dCollisionCheck(&circle_data, &cw_data, &result);
+        TEST_CHECK(hit == expected_hit);
+        if (hit && expected_hit) {
+            TEST_CHECK(fabsf(result.distance - expected.distance) <= 1e-5f);
+            TEST_CHECK(fabsf(result.direction[0] - expected.direction[0]) <= 1e-5f);
+            TEST_CHECK(fabsf(result.direction[1] - expected.direction[1]) <= 1e-5f);
+        }
+    }
+    EcsPolygonCollider_release(&cw);
+    EcsPolygonCollider_release(&ccw);
+}
@@ -0,0 +1,156 @@
+#include "tests.h"
+
+#define CAST_COLLIDERS 40
+#define CAST_RUNS 2000
+
+typedef struct CastScene {
+    EcsPoint positions[CAST_COLLIDERS];
+    EcsRotation rotations[CAST_COLLIDERS];
+    EcsPoint points[CAST_COLLIDERS][6];
+    EcsPolygonCollider polygons[CAST_COLLIDERS];
+    EcsCircleCollider circles[CAST_COLLIDERS];
+    EcsColliderData data[CAST_COLLIDERS];
+    EcsColliderData *colliders[CAST_COLLIDERS];
+} CastScene;
+
+// Rotated hexagons and circles spread over a 40 x 40 area
+static void Test_initCastScene(CastScene *scene, uint32_t *state)
+{
+    memset(scene, 0, sizeof(CastScene));
+    for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+        scene->positions[i][0] = Test_uniform(state, -20, 20);
+        scene->positions[i][1] = Test_uniform(state, -20, 20);
+        EcsRotation_set(&scene->rotations[i], Test_uniform(state, 0, 6.2831853f));
+        scene->data[i][0] = &scene->positions[i];
+        scene->colliders[i] = &scene->data[i];
+        if (i % 3 == 0) {
+            scene->circles[i].radius = Test_uniform(state, 0.5f, 2);
+            scene->data[i][1] = &scene->circles[i];
+            continue;
+        }
+        float radius = Test_uniform(state, 0.5f, 3);
+        for (int32_t v = 0; v < 6; v++) {
+            float angle = (float)v * 6.2831853f / 6;
+            scene->points[i][v][0] = radius * cosf(angle) + 1;
+            scene->points[i][v][1] = radius * 0.5f * sinf(angle);
+        }
+        EcsPolygonCollider_init(&scene->polygons[i], scene->points[i], 6);
+        scene->data[i][2] = &scene->polygons[i];
+        scene->data[i][3] = &scene->rotations[i];
+    }
+}
+
+static void Test_releaseCastScene(CastScene *scene)
+{
+    for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+        EcsPolygonCollider_release(&scene->polygons[i]);
+    }
+}
+
+/*
+ * The bounds of baked polygons reject rays before the exact test, the hits
+ * must be those of the same polygon without baked data.
+ */
+void Test_raycastBounds(void)
+{
+    uint32_t state = 3;
+    CastScene scene;
+    Test_initCastScene(&scene, &state);
+    int32_t hits = 0;
+    for (int32_t run = 0; run < CAST_RUNS; run++) {
+        // Aimed close to a polygon, most rays graze or hit it
+        int32_t target = (int32_t)(Test_random(&state) % CAST_COLLIDERS);
+        while (scene.data[target][2] == NULL) {
+            target = (target + 1) % CAST_COLLIDERS;
+        }
+        EcsRay ray;
+        ray.origin[0] = Test_uniform(&state, -25, 25);
+        ray.origin[1] = Test_uniform(&state, -25, 25);
+        ray.translation[0] = (scene.positions[target][0] + Test_uniform(&state, -3, 3) - ray.origin[0]) * 1.5f;
+        ray.translation[1] = (scene.positions[target][1] + Test_uniform(&state, -3, 3) - ray.origin[1]) * 1.5f;
+        ray.max_fraction = Test_uniform(&state, 0.5f, 1);
+        for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+            if (scene.data[i][2] == NULL) {
+                continue;
+            }
+            EcsPolygonCollider plain = {scene.points[i], 6, NULL, NULL, NULL, EcsPolygonShapeGeneric, 0, {0}};
+            EcsColliderData plain_data = {&scene.positions[i], NULL, &plain, &scene.rotations[i], NULL, NULL};
+            EcsRaycastHit expected;
+            EcsRaycastHit result;
+            int8_t expected_hit = EcsPhysis2dRaycast(&plain_data, &ray, &expected);
+            int8_t hit = EcsPhysis2dRaycast(scene.colliders[i], &ray, &result);
+            TEST_CHECK(hit == expected_hit);
+            if (hit && expected_hit) {
+                TEST_CHECK(fabsf(result.fraction - expected.fraction) <= 1e-5f);
+            }
+            hits += hit;
+        }
+    }
+    TEST_CHECK(hits > 0);
+    Test_releaseCastScene(&scene);
+}
+
+/*
+ * Batched shape casts against a tree must find the hits of casting every
+ * shape against every collider.
+ */
+void Test_shapeCastBatch(void)
+{
+    uint32_t state = 5;
+    CastScene scene;
+    Test_initCastScene(&scene, &state);
+    EcsAABBTree tree;
+    EcsAABBTree_init(&tree, 0.1f);
+    for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+        EcsAABB aabb;
+        EcsColliderData_getAABB(scene.colliders[i], &aabb);
+        EcsAABBTree_insert(&tree, &aabb, i);
+    }
+
+    EcsColliderData *shapes[CAST_COLLIDERS];
+    EcsVector2D translations[CAST_COLLIDERS];
+    for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+        shapes[i] = scene.colliders[i];
+        translations[i][0] = Test_uniform(&state, -10, 10);
+        translations[i][1] = Test_uniform(&state, -10, 10);
+    }
+
+    EcsRaycastHit hits[CAST_COLLIDERS * CAST_COLLIDERS];
+    int32_t count = EcsPhysis2dShapeCastBatch(&tree, scene.colliders, shapes, translations, CAST_COLLIDERS,
+        false, hits, CAST_COLLIDERS * CAST_COLLIDERS);
+    EcsRaycastHit closest[CAST_COLLIDERS];
+    int32_t closest_count = EcsPhysis2dShapeCastBatch(&tree, scene.colliders, shapes, translations, CAST_COLLIDERS,
+        true, closest, CAST_COLLIDERS);
+
+    int32_t expected_count = 0;
+    int32_t expected_closest = 0;
+    for (int32_t i = 0; i < CAST_COLLIDERS; i++) {
+        EcsRaycastHit best = {INFINITY, {0, 0}, {0, 0}, 0, 0};
+        for (int32_t j = 0; j < CAST_COLLIDERS; j++) {
+            EcsRaycastHit hit;
+            if (j == i || !EcsPhysis2dShapeCast(shapes[i], &translations[i], scene.colliders[j], &hit)) {
+                continue;
+            }
+            expected_count++;
+            best = hit.fraction < best.fraction ? hit : best;
+            int8_t found = false;
+            for (int32_t h = 0; h < count && !found; h++) {
+                found = hits[h].ray == i && hits[h].collider == j && hits[h].fraction == hit.fraction;
+            }
+            TEST_CHECK(found);
+        }
+        if (best.fraction != INFINITY) {
+            int8_t found = false;
+            for (int32_t h = 0; h < closest_count && !found; h++) {
+                found = closest[h].ray == i && closest[h].fraction == best.fraction;
+            }
+            TEST_CHECK(found);
+            expected_closest++;
+        }
+    }
+    TEST_CHECK(count == expected_count);
+    TEST_CHECK(closest_count == expected_closest);
+    TEST_CHECK(expected_count > 0);
+    EcsAABBTree_deinit(&tree);
+    Test_releaseCastScene(&scene);
+}
@@ -0,0 +1,52 @@
+#include "tests.h"
+
+#define PROJECTION_POINTS 67
+#define PROJECTION_RUNS 2000
+
+static const char *kernel_names[] = {"auto", "scalar", "sse2", "avx2", "neon"};
+
+/*
+ * Every kernel the CPU supports must give the bits of the scalar kernel,
+ * for counts that do and do not fill the vectors, with NaN and signed zero
+ * products anywhere in the input.
+ */
+void Test_projectionKernels(void)
+{
+    EcsProjectionKernel selected = EcsPhysis2d_getProjectionKernel();
+    uint32_t state = 1;
+    float xs[PROJECTION_POINTS];
+    float ys[PROJECTION_POINTS];
+
+    for (int32_t run = 0; run < PROJECTION_RUNS; run++) {
+        int32_t count = (int32_t)(Test_random(&state) % (PROJECTION_POINTS + 1));
+        EcsVector2D axis = {Test_uniform(&state, -1, 1), Test_uniform(&state, -1, 1)};
+        for (int32_t i = 0; i < count; i++) {
+            uint32_t kind = Test_random(&state) % 16;
+            xs[i] = kind == 0 ? NAN : kind == 1 ? -0.0f : Test_uniform(&state, -100, 100);
+            ys[i] = kind == 2 ? NAN : kind == 1 ? 0.0f : Test_uniform(&state, -100, 100);
+        }
+        if (run % 50 == 0) {
+            // Only NaN products
+            for (int32_t i = 0; i < count; i++) {
+                xs[i] = NAN;
+            }
+        }
+
+        EcsVector2D expected;
+        EcsPhysis2d_setProjectionKernel(EcsProjectionKernelScalar);
+        EcsPhysis2d_projectSoA(&axis, xs, ys, count, &expected);
+        for (int32_t kernel = EcsProjectionKernelSse2; kernel <= EcsProjectionKernelNeon; kernel++) {
+            if (!EcsPhysis2d_setProjectionKernel(kernel)) {
+                continue;
+            }
+            EcsVector2D result;
+            EcsPhysis2d_projectSoA(&axis, xs, ys, count, &result);
+            if (memcmp(&result, &expected, sizeof(EcsVector2D))) {
+                printf("  %s, %d points: [%g, %g] expected [%g, %g]\n", kernel_names[kernel], count,
+                    result[0], result[1], expected[0], expected[1]);
+            }
+            TEST_CHECK(!memcmp(&result, &expected, sizeof(EcsVector2D)));
+        }
+    }
+    EcsPhysis2d_setProjectionKernel(selected);
+}